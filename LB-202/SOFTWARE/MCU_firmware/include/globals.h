@@ -7,6 +7,73 @@
 
 // #define INCLUDE_TEST_POINT
 
+// INCLUDE_DISPLAY: the SSD1306 OLED driver (src/ssd1306.c).  Its transfers go
+// through the interrupt-driven I2C queue (src/i2c_queue.c), on the I2C pins
+// I2C_PORT selects.  NOTE: this is for other hardware, it cannot run on
+// LB-202: the board has no I2C pin pair free (see I2C_PORT in
+// include/i2c_queue.h), so the build stops unless I2C_PORT is defined.  The
+// sim's display variant uses P2.5/P2.4, which only larger packages than
+// LB-202's 20-pin STC8G1K08 have.
+// #define INCLUDE_DISPLAY
+// #define I2C_PORT I2C_AlterPort_P25_P24 // other hardware only, not LB-202
+
+// INCLUDE_POWER_DOWN: after POWER_DOWN_QUIET_TICKS with a static LED (not the
+// VU meter, an RVC flash or the low battery pulse), a steady RVC and no switch
+// activity, sample RVC at 20Hz without the 100Hz tick.  With the LED OFF that
+// is power-down + wake-up timer.  The PCA (the LED PWM) stops in power-down,
+// so with a static color, which every SW1 mode but the VU meter is, the
+// firmware stays in IDLE and slows Timer0 to two wakes per RVC frame.
+// #define INCLUDE_POWER_DOWN
+
+// INCLUDE_SCHED_STATS: the Timer0 task scheduler (Timer0_Routine() in main.c)
+// counts runs, cost (in Timer0 counts, 12 clocks each) and overruns (the
+// next tick came due while the task ran) per task in sched_stats[], in XDATA.
+// For development: the measuring costs a few percent of the ISR.
+// #define INCLUDE_SCHED_STATS
+
+// INCLUDE_LIMITER: sustained near-clip peaks on OUTMON add temporary
+// attenuation on top of the RVC setting, released slowly once they stop
+// (LIMITER_* in main.c).  NOTE: Timer2 then samples OUTMON in every LED mode,
+// so it costs some battery life, and it cannot be used with INCLUDE_POWER_DOWN.
+// #define INCLUDE_LIMITER
+
+// INCLUDE_HOWL_DETECTOR: a sustained single tone building up on OUTMON
+// (acoustic feedback) adds temporary attenuation on top of the RVC setting
+// (HOWL_* in main.c).  Same NOTE as INCLUDE_LIMITER.
+// #define INCLUDE_HOWL_DETECTOR
+
+// INCLUDE_LOUDNESS_TRIM: a slow (seconds) loudness estimate of the program
+// trims the RVC attenuation by up to +/-LOUDNESS_TRIM_MAX_DB, so songs come
+// out at about the same level (LOUDNESS_* in main.c).  Turned on and off by
+// holding SW2 at power-up (loudness_trim_pref); while on, Timer2 samples
+// OUTMON in every LED mode.
+// #define INCLUDE_LOUDNESS_TRIM
+
+// Anything that adds attenuation on top of the RVC's
+#if defined(INCLUDE_LIMITER) || defined(INCLUDE_HOWL_DETECTOR) ||             \
+    defined(INCLUDE_LOUDNESS_TRIM)
+#define INCLUDE_AUTO_ATTEN
+#endif
+
+// Anything on the I2C bus (the display, Stemma-QT peripherals)
+#if defined(INCLUDE_DISPLAY)
+#define INCLUDE_I2C_QUEUE
+#endif
+
+// VU METER BALLISTICS ---------
+// How the VU meter LED follows OUTMON (vu_meter_ballistics() in main.c):
+//   VU_BALLISTICS_PPM_DIN  true peak, instant rise, 20dB fall in 1.5s
+//                          (IEC 60268-10 type I) [default]
+//   VU_BALLISTICS_PPM_BBC  true peak, instant rise, 24dB fall in 2.8s
+//                          (IEC 60268-10 type IIa)
+//   VU_BALLISTICS_VU       RMS, 99% rise and fall in 300ms (IEC 60268-17)
+#define VU_BALLISTICS_PPM_DIN 0
+#define VU_BALLISTICS_PPM_BBC 1
+#define VU_BALLISTICS_VU 2
+#ifndef VU_METER_BALLISTICS
+#define VU_METER_BALLISTICS VU_BALLISTICS_PPM_DIN
+#endif
+
 // CLOCK DIVIDER CONFIGURATION ---------
 // NOTE: __CONF_CLKDIV is set in platformio.ini to ensure all source files
 // see the same value during compilation (important for SYS_Delay calibration)
@@ -36,4 +103,24 @@
 // for unused variables
 #define UNUSED(x) (void)(x)
 
+// REGISTER BANKS ---------
+// Every interrupt runs at the same (default) priority, so they never nest
+// and can share one register bank: an ISR then saves no R0-R7 on entry,
+// unless it calls a bank 0 function (SDCC then pushes all of bank 0).
+// Timer0_Routine() calls its bank 0 tasks, so only the other ISRs gain;
+// make bench-s51 counts each ISR's PUSH / POP (-D ISR_BANK=0 to compare).
+// ISR_USING marks the ISR-only helpers compiled for that bank.  They may
+// only be called from the ISRs and each other, and may only call each other
+// (no SDCC arithmetic helper such as _mulint either, those are bank 0 code):
+// SDCC switches banks only on calls made by an ISR itself.  sim/isr_calls.py
+// checks this (and what the ISRs share with main()) on every make check.
+#ifndef ISR_BANK
+#define ISR_BANK 1
+#endif
+#if defined(SDCC) || defined(__SDCC)
+#define ISR_USING __using(ISR_BANK)
+#else
+#define ISR_USING
+#endif
+
 #endif // __GLOBALS_H__
@@ -0,0 +1,99 @@
+#ifndef __I2C_QUEUE_H__
+#define __I2C_QUEUE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fw_hal.h"
+#include "globals.h"
+
+#ifdef INCLUDE_I2C_QUEUE
+
+// Non-blocking I2C master.  main() queues transfers (a START, the device
+// address, a register or control byte, then data written or read) and goes
+// back to sleep; I2C_Routine() moves each one along a byte at a time on the
+// I2C master interrupt, so a 512-byte display frame costs the CPU one short
+// interrupt per byte instead of busy-waiting through all of it.
+//
+// When a transfer ends, its done() callback runs from i2c_poll() in the main
+// loop, never from the ISR: sim/isr_calls.py does not allow an ISR to call
+// through a function pointer.  A transfer that makes no progress for
+// I2C_TIMEOUT_TICKS Timer0 ticks (a device holding SCL low, or a bus with
+// nothing on it) is aborted by handle_i2c_timeout(), which resets the I2C
+// peripheral and goes on with the next one.
+
+// I2C_PORT: the I2C_AlterPort_t pin pair of the I2C peripheral.  LB-202 has
+// none free: P1.5/P1.4 (the default) are SW1 and OUTMON, P3.2/P3.3 the
+// LM1971's VOL_CLK and VOL_DATA, P2.x and P7.x are not on the STC8G1K08, and
+// the display header's P1.1/P1.2 are not an I2C pair.  So there is no
+// default: a board with a pair free defines I2C_PORT (P1, P2 or P3 only).
+#ifndef I2C_PORT
+#error "INCLUDE_I2C_QUEUE: no free I2C pins on LB-202, define I2C_PORT"
+#endif
+
+#define I2C_QUEUE_LEN 4      // transfers queued or waiting for i2c_poll()
+#define I2C_BUS_HZ 265000UL  // safe for the SSD1306 (400KHz max)
+#define I2C_TIMEOUT_TICKS 2  // 10-20ms without an interrupt
+
+// Transfer status, as passed to done()
+#define I2C_PENDING 0 // queued or on the bus
+#define I2C_OK 1
+#define I2C_NACK 2    // the device did not acknowledge its address or a byte
+#define I2C_TIMEOUT 3 // no progress for I2C_TIMEOUT_TICKS, bus reset
+
+// Called from the main loop (i2c_poll()) with the transfer's status
+typedef void (*i2c_done_fn)(uint8_t status);
+
+/**
+ * @brief Sets up the I2C master (I2C_BUS_HZ) on the I2C_PORT pins (open
+ *        drain), with its interrupt enabled.
+ */
+void i2c_init(void);
+
+/**
+ * @brief Queues a write: START, dev, reg, then len bytes of buf.
+ *
+ * @param dev  8-bit device address (R/W bit 0), e.g. SSD1306_I2C_ADDR
+ * @param reg  register, or control byte, sent right after the address
+ * @param buf  data, which must stay unchanged until done() (may be NULL
+ *             when len is 0)
+ * @param done NULL, or called from i2c_poll() when the transfer has ended
+ * @return false (nothing queued) when the queue is full
+ */
+bool i2c_write(uint8_t dev, uint8_t reg, __XDATA uint8_t *buf, uint16_t len,
+               i2c_done_fn done);
+
+/**
+ * @brief Queues a one-byte write, the byte kept in the queue itself.
+ */
+bool i2c_write_byte(uint8_t dev, uint8_t reg, uint8_t value, i2c_done_fn done);
+
+/**
+ * @brief Queues a read: START, dev, reg, repeated START, dev + 1, then len
+ *        bytes into buf (the last one NACKed).
+ */
+bool i2c_read(uint8_t dev, uint8_t reg, __XDATA uint8_t *buf, uint16_t len,
+              i2c_done_fn done);
+
+/**
+ * @brief Main loop: runs done() for every transfer that has ended, and frees
+ *        its queue slot.
+ */
+void i2c_poll(void);
+
+/**
+ * @brief Main loop: sleeps in IDLE until the next interrupt, then i2c_poll().
+ *        For callers that have to queue while the queue is full.
+ */
+void i2c_wait(void);
+
+/**
+ * @brief Timer0 task: aborts a transfer that stopped making progress.
+ */
+void handle_i2c_timeout(void);
+
+INTERRUPT_USING(I2C_Routine, EXTI_VectI2C, ISR_BANK);
+
+#endif // INCLUDE_I2C_QUEUE
+
+#endif // __I2C_QUEUE_H__
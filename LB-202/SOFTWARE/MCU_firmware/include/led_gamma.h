@@ -0,0 +1,24 @@
+// +-----------------------------------------------+
+// | RGB LED GAMMA TABLE                           |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// GENERATED by tools/gen_led_gamma.py -- DO NOT EDIT.
+
+#ifndef __LED_GAMMA_H__
+#define __LED_GAMMA_H__
+
+#include "fw_hal.h"
+#include <stdint.h>
+
+#define LED_GAMMA_DUTY_MAX 1023 // PCA_PWM_BitWidth_10
+
+/**
+ * @brief Perceptual LED level (0-255) -> 10-bit PCA compare value,
+ *        gamma 2.2.  0 = off, every other level is at least 1.
+ */
+extern __CODE const uint16_t led_gamma_table[256];
+
+#endif // __LED_GAMMA_H__
@@ -0,0 +1,107 @@
+// Generated by tools/gen_mem_classes.py -- do not edit.
+//
+// Memory class of every MEMVAR(type, name) global, from accesses per
+// second in 1 h sim gig replays of default, power_down, limiter, howl, loudness, display.
+// What an ISR touches more than 1000/s is planned first, then the shipped
+// build (default) from its own replay; the variables only a feature flag
+// compiles in share what is left.
+// __DATA: 48 of 48 bytes (32 shipped), __BIT: 20 of 64 bits.
+// The other 48 of the 96 direct RAM bytes are kept for SDCC's overlay.
+
+#ifndef MEM_CLASSES_H
+#define MEM_CLASSES_H
+
+#ifdef MEM_CLASSES_UNPLANNED
+// the profiling build: every global in the default class
+#define MEMVAR(type, name) type name
+#else
+#define MEMVAR(type, name) MEM_##name(type) name
+
+// shipped build                                     // accesses/s  (from ISRs)
+#define MEM_adc_seq_busy(type) __BIT                 //     2942.4  (2942.4)
+#define MEM_adc_seq_vu(type) __BIT                   //     2886.0  (2886.0)
+#define MEM_prefs_commit_due(type) __BIT             //     1533.3  (100.0)
+#define MEM_prefs_dirty(type) __BIT                  //     1533.3  (100.0)
+#define MEM_adc_seq_rvc(type) __BIT                  //      837.6  (837.6)
+#define MEM_vu_sampling(type) __BIT                  //      837.6  (837.6)
+#define MEM_adc_seq_battmon(type) __BIT              //      818.6  (818.6)
+#define MEM_atten_zc_primed(type) __BIT              //      208.3  (208.3)
+#define MEM_atten_zc_ahead(type) __BIT               //       92.9  (92.9)
+#define MEM_led_override_active(type) __BIT          //       20.0  (20.0)
+#define MEM_s_initialized(type) __BIT                //        0.0  (0.0)
+#define MEM_adc_seq_channel(type) __DATA type        //     6179.1  (6179.1)
+#define MEM_atten_zc_steps(type) __DATA type         //     1661.8  (1661.8)
+#define MEM_timer_ticks(type) __DATA type            //     1021.0  (1021.0)
+#define MEM_res(type) __DATA type                    //      907.4  (907.4)
+#define MEM_vu_acc_peak(type) __DATA type            //      680.7  (680.7)
+#define MEM_vu_acc_samples(type) __DATA type         //      676.7  (676.7)
+#define MEM_vu_acc_sq(type) __DATA type              //      673.3  (673.3)
+#define MEM_atten_zc_prev(type) __DATA type          //      462.3  (462.3)
+#define MEM_previousRes(type) __DATA type            //      120.5  (120.5)
+#define MEM_switch2_debounce_counter(type) __DATA type //      100.0  (100.0)
+#define MEM_switch2_state(type) __DATA type          //      100.0  (100.0)
+#define MEM_switch1_debounce_counter(type) __DATA type //      100.0  (100.0)
+#define MEM_switch1_state(type) __DATA type          //      100.0  (100.0)
+#define MEM_atten_zc_wait(type) __DATA type          //       99.0  (99.0)
+#define MEM_battmon_res(type) __DATA type            //       45.0  (45.0)
+#define MEM_rvc_mode(type) __DATA type               //       40.0  (40.0)
+#define MEM_adc_rvc_res(type) __DATA type            //       40.0  (40.0)
+#define MEM_led_mode(type) __DATA type               //       38.0  (38.0)
+#define MEM_vu_display_val_fixed(type) __DATA type   //       10.0  (10.0)
+#define MEM_led_seq_frames(type) __DATA type         //        7.7  (7.7)
+#define MEM_abs_out_res(type) __DATA type            //        6.7  (6.7)
+#define MEM_led_seq_pc(type) __DATA type             //        3.9  (3.9)
+#define MEM_vu_rms(type) __DATA type                 //        3.3  (3.3)
+#define MEM_adc_battmon_res(type) __DATA type        //        2.0  (2.0)
+#define MEM_led_seq_repeat_left(type) __XDATA type   //        1.9  (1.9)
+#define MEM_led_seq_repeat_end(type) __XDATA type    //        1.9  (1.9)
+#define MEM_prefs_quiet_ticks(type) __XDATA type     //        0.5  (0.5)
+#define MEM_s_next_write_offset(type) __XDATA type   //        0.0  (0.0)
+#define MEM_s_active_sector(type) __XDATA type       //        0.0  (0.0)
+#define MEM_switch_held_at_boot(type) __XDATA type   //        0.0  (0.0)
+#define MEM_led_seq_repeat_start(type) __XDATA type  //        0.0  (0.0)
+#define MEM_s_active_header(type) __XDATA type       //        0.0  (0.0)
+
+// feature flags only                                // accesses/s  (from ISRs)
+#define MEM_i2c_ended(type) __BIT                    //     1433.3  (0.0)
+#define MEM_display_started(type) __BIT              //     1433.3  (0.0)
+#define MEM_i2c_busy(type) __BIT                     //      100.2  (100.2)
+#define MEM_slow_tick(type) __BIT                    //       91.8  (75.1)
+#define MEM_slow_tick_fired(type) __BIT              //       66.4  (16.6)
+#define MEM_loudness_on(type) __BIT                  //       23.3  (23.3)
+#define MEM_led_dark(type) __BIT                     //       11.6  (11.5)
+#define MEM_loudness_valid(type) __BIT               //        0.0  (0.0)
+#define MEM_sched_late(type) __BIT                   //        0.0  (0.0)
+#define MEM_howl_d1(type) __DATA type                //    27999.8  (27999.8)
+#define MEM_howl_d2(type) __DATA type                //    11999.9  (11999.9)
+#define MEM_howl_x(type) __DATA type                 //     7999.9  (7999.9)
+#define MEM_howl_acc_a(type) __DATA type             //     4200.0  (4200.0)
+#define MEM_howl_acc_b(type) __DATA type             //     4200.0  (4200.0)
+#define MEM_howl_acc_c(type) __DATA type             //     4200.0  (4200.0)
+#define MEM_limiter_hits(type) __DATA type           //     4200.0  (4200.0)
+#define MEM_power_down_quiet_ticks(type) __XDATA type //     1480.8  (89.0)
+#define MEM_howl_prev_c(type) __XDATA type           //      200.0  (200.0)
+#define MEM_howl_db(type) __XDATA type               //      142.6  (142.6)
+#define MEM_limiter_db(type) __XDATA type            //      142.6  (142.6)
+#define MEM_rvc_res(type) __XDATA type               //      140.0  (140.0)
+#define MEM_power_down_res(type) __XDATA type        //      117.0  (117.0)
+#define MEM_i2c_idle_ticks(type) __XDATA type        //      100.2  (100.2)
+#define MEM_howl_hold_ticks(type) __XDATA type       //      100.0  (100.0)
+#define MEM_howl_tonal_ticks(type) __XDATA type      //      100.0  (100.0)
+#define MEM_limiter_hold_ticks(type) __XDATA type    //      100.0  (100.0)
+#define MEM_loudness_trim_db(type) __XDATA type      //       85.2  (85.2)
+#define MEM_power_down_battmon_wakes(type) __XDATA type //        8.7  (0.0)
+#define MEM_i2c_state(type) __XDATA type             //        1.1  (1.1)
+#define MEM_i2c_pos(type) __XDATA type               //        0.3  (0.3)
+#define MEM_i2c_tail(type) __XDATA type              //        0.2  (0.2)
+#define MEM_i2c_reap(type) __XDATA type              //        0.0  (0.0)
+#define MEM_i2c_head(type) __XDATA type              //        0.0  (0.0)
+#define MEM_howl_release_ticks(type) __XDATA type    //        0.0  (0.0)
+#define MEM_i2c_errors(type) __XDATA type            //        0.0  (0.0)
+#define MEM_limiter_release_ticks(type) __XDATA type //        0.0  (0.0)
+#define MEM_loudness_acc(type) __XDATA type          //        0.0  (0.0)
+#define MEM_loudness_step_frames(type) __XDATA type  //        0.0  (0.0)
+#define MEM_sched_start(type) __XDATA type           //        0.0  (0.0)
+#endif
+
+#endif // MEM_CLASSES_H
@@ -5,11 +5,33 @@
 #include <stdbool.h>
 
 // Configuration
+// Preferences are a log that rotates through all PREF_NUM_SECTORS sectors of
+// the 4KB EEPROM (0x0000-0x0FFF), so each sector is erased only once every
+// PREF_NUM_SECTORS laps.  Nothing else is kept in the EEPROM.
+#define PREF_NUM_SECTORS 8
 #define PREF_START_ADDR                                                        \
-  0x0E00 // Last 512-byte sector of 4KB EEPROM (0x0000-0x0FFF)
+  0x0000 // First of the PREF_NUM_SECTORS 512-byte sectors (0x0000-0x0FFF)
 
-#define PREF_SECTOR_SIZE 512
-// #define PREF_SECTOR_SIZE 8 // for testing SECTOR ERASE, smaller size
+#define PREF_SECTOR_SIZE 512 // IAP erase granularity
+#define PREF_SECTOR_ADDR(__N__)                                                \
+  (PREF_START_ADDR + (uint16_t)(__N__) * PREF_SECTOR_SIZE)
+
+#define PREF_SECTOR_SLOTS PREF_SECTOR_SIZE // slot 0 = header, 1.. = entries
+// #define PREF_SECTOR_SLOTS 8 // for testing SECTOR ROTATION, fewer slots
+
+// Sector header (slot 0): a sequence number 0x80-0xFE, +1 per rotation
+// (0xFE wraps to 0x80).  Bit 7 is 1, so a header is never a valid entry, and
+// 0xFF means "no header": erased, or a rotation that never completed.
+#define PREF_HEADER_FIRST 0x80
+#define PREF_HEADER_LAST 0xFE
+#define PREF_IS_HEADER(__H__) (((__H__) & 0x80) && ((__H__) != 0xFF))
+#define PREF_NEXT_HEADER(__H__)                                                \
+  (((__H__) == PREF_HEADER_LAST) ? PREF_HEADER_FIRST : (uint8_t)((__H__) + 1))
+
+// Firmware <= 1.1.1 kept a single log (no header) in the last sector; it is
+// read once, when no sector has a header yet.  Its entries all have bit 7
+// clear (or are 0xFF), so its slot 0 is never taken for a header.
+#define PREF_LEGACY_ADDR 0x0E00
 
 #define PREF_DEFAULT_VALUE 0x00
 
@@ -21,14 +43,18 @@
  * 
  * Bit layout (LSB to MSB):
  *   Bit 0: rvc_direction (0=right-handed, 1=left-handed)
- *   Bit 1: vu_meter_disabled (0=enabled, 1=disabled)
- *   Bits 2-6: unused (reserved for future use)
+ *   Bits 1-2: vu_meter_mode_pref (power-up LED mode)
+ *   Bit 3: rvc_curve_pref (0=default curve, 1=traditional MA-220 curve)
+ *   Bit 4: loudness_trim_pref (0=off, 1=on; INCLUDE_LOUDNESS_TRIM builds)
+ *   Bits 5-6: unused (reserved for future use)
  *   Bit 7: valid_marker (always 0 for valid entries)
  * 
  * NOTE: Default values for all fields are all zeros (0x00).
  *   Bit 7 is 0 to indicate a valid entry.  Entries are written sequentially into the
- *   last sector of EEPROM, with unused bytes set to 0xFF.  Reads will scan backwards to find
- *   the latest valid entry.  Writes will append a new entry, and erase the sector if full.
+ *   active sector of EEPROM, after its header, with unused bytes set to 0xFF.  Reads will
+ *   binary search for the latest valid entry.  Writes will append a new entry.  When the
+ *   active sector is full, the next sector is erased and gets the entry and then its
+ *   header, so the old sector stays valid until the new one is (power-fail safe).
  *   This design minimizes EEPROM wear by reducing unnecessary writes.  Bits that are set to 0
  *   can only be set back to 1 by performing a sector erase.
  */
@@ -37,7 +63,8 @@ typedef union {
     uint8_t rvc_direction_pref : 1;  // Bit 0: 0=right-handed [default], 1=left-handed
     uint8_t vu_meter_mode_pref : 2;  // Bits 1-2: 00 = battery monitor [default], 01 = VU meter, 10 = solid white, 11 = reserved
     uint8_t rvc_curve_pref : 1;      // Bit 3: 0=right-handed [default], 1=left-handed
-    uint8_t unused : 3;              // Bits 4-6: Reserved for future use
+    uint8_t loudness_trim_pref : 1;  // Bit 4: 0=off [default], 1=loudness trim on
+    uint8_t unused : 2;              // Bits 5-6: Reserved for future use
     uint8_t valid_marker : 1;        // Bit 7: Always 0 (marks valid entry)
     // WARNING: changing the bitfield layout might invalidate existing EEPROM data!
     // WARNING: the sum of the bitfield widths must equal 8!
@@ -46,18 +73,20 @@ typedef union {
 } Preferences_t;
 
 /**
- * @brief Initializes the EEPROM preferences system with default value in slot 0.
+ * @brief Finds the active preferences sector.
  *
- * This function should be called once at system startup to ensure that the preferences
- * storage is initialized. It writes a default Preferences_t value to the first slot  
- * of the designated EEPROM sector. That means setting all bits to 0, including the valid_marker bit.
- * This ensures that there is always a valid entry to read from.
+ * This function should be called once at system startup.  The active sector is the
+ * one with a header that is not followed by a newer one.  Only if no sector has a
+ * header yet (first power-up) is sector 0 formatted, with the latest entry of the
+ * legacy single-sector log, or the default Preferences_t value (all bits 0,
+ * including the valid_marker bit).  This ensures that there is always a valid entry
+ * to read from, without writing EEPROM at every power-up.
  * 
  */
 void Pref_Init();
 
 /**
- * @brief Dumps the first N bytes of the preferences EEPROM sector for debugging.
+ * @brief Dumps the first N bytes of the active preferences EEPROM sector for debugging.
  *
  * This function can be called anytime after Pref_Init() to output the contents
  * of the preferences EEPROM sector to the UART for debugging purposes.
@@ -69,7 +98,8 @@ void Pref_Dump();
 /**
  * @brief Reads the latest user preferences from EEPROM.
  * 
- * Scans the assigned EEPROM sector for the latest valid entry (MSB == 0).
+ * Binary searches the active EEPROM sector for the latest valid entry (MSB == 0),
+ * relying on entries being appended in order (at most 10 EEPROM reads).
  * If no valid entry is found, returns default values.
  * 
  * @param prefs Pointer to Preferences_t structure to populate.
@@ -79,8 +109,9 @@ void Pref_Read(Preferences_t *prefs);
 /**
  * @brief Writes new user preferences to EEPROM.
  * 
- * Appends the new value to the next available slot in the sector.
- * If the sector is full, it performs a sector erase and writes to the first slot.
+ * Appends the new value to the next available slot in the active sector.
+ * If the sector is full, it erases the next sector, writes the value to its first
+ * slot and then commits it with a header.
  * Only writes if the value has actually changed.
  * 
  * @param prefs Pointer to Preferences_t structure containing values to save.
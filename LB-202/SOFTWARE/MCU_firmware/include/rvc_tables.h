@@ -0,0 +1,26 @@
+// +-----------------------------------------------+
+// | RVC ATTENUATION TABLES                        |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// GENERATED by tools/gen_rvc_tables.py -- DO NOT EDIT.
+
+#ifndef __RVC_TABLES_H__
+#define __RVC_TABLES_H__
+
+#include "fw_hal.h"
+#include <stdint.h>
+
+#define RVC_TABLE_MODES 2 // one table per rvc_mode_t
+
+/**
+ * @brief RVC -> attenuation in dB (0 = 0dB, >= 64 = MUTE).
+ *
+ * Indexed by [rvc_mode][ADC7 result].  Values above 0xE0 (nothing plugged
+ * in) map to 0dB in every mode.
+ */
+extern __CODE const uint8_t rvc_atten_table[RVC_TABLE_MODES][256];
+
+#endif // __RVC_TABLES_H__
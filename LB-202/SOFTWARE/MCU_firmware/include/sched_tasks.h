@@ -0,0 +1,46 @@
+// +-----------------------------------------------+
+// | TIMER0 TASK LIST                              |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// One SCHED_TASK(function, period, phase) per Timer0 task, in the order they
+// run within a tick: a task runs when timer_ticks % period == phase, and
+// period must divide TIMER_FREQUENCY_HZ.  src/main.c includes this list once
+// for sched_tasks[] and once for the direct calls in Timer0_Routine(), so it
+// has no include guard.
+//
+// The 20Hz frame is spread over its SCHED_FRAME ticks, so no two of its heavy
+// tasks share one:
+//   3  ADC power on (10ms settling)    4  RVC (+ battery) sequence started
+//   0  handle_RVC()                    1  handle_VU_meter()
+//   2  handle_leds(), showing the VU frame from tick 1
+// and handle_battmon() takes the battery result from tick 99 at tick 3.
+
+SCHED_TASK(handle_switches, 1, 0) // switch debouncing
+#ifdef INCLUDE_PREFERENCES
+SCHED_TASK(handle_prefs_quiet, 1, 0) // commit prefs after a quiet period
+#endif
+SCHED_TASK(task_adc_power, SCHED_FRAME, SCHED_PHASE_ADC_POWER)
+SCHED_TASK(task_adc_start, SCHED_FRAME, SCHED_PHASE_ADC_START)
+SCHED_TASK(task_rvc, SCHED_FRAME, SCHED_PHASE_RVC)
+SCHED_TASK(task_vu_meter, SCHED_FRAME, SCHED_PHASE_VU)
+SCHED_TASK(handle_leds, SCHED_FRAME, SCHED_PHASE_LEDS) // LED update, all modes
+#ifdef INCLUDE_LIMITER
+SCHED_TASK(handle_limiter, 1, 0) // near-clip peaks add attenuation
+#endif
+#ifdef INCLUDE_HOWL_DETECTOR
+SCHED_TASK(handle_howl, 1, 0) // a building single tone adds attenuation
+#endif
+#ifdef INCLUDE_AUTO_ATTEN
+SCHED_TASK(task_auto_atten, 1, 0)
+#endif
+SCHED_TASK(handle_atten_slew, 1, 0) // bounded number of 1dB steps towards res
+#ifdef INCLUDE_POWER_DOWN
+SCHED_TASK(handle_power_down_quiet, 1, 0) // may we power down?
+#endif
+#ifdef INCLUDE_I2C_QUEUE
+SCHED_TASK(handle_i2c_timeout, 1, 0) // abandon a stalled I2C transfer
+#endif
+SCHED_TASK(handle_battmon, TIMER_FREQUENCY_HZ, SCHED_PHASE_BATTMON)
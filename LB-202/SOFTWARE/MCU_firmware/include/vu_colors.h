@@ -0,0 +1,28 @@
+// +-----------------------------------------------+
+// | VU METER COLOR TABLE                          |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// GENERATED by tools/gen_vu_colors.py -- DO NOT EDIT.
+
+#ifndef __VU_COLORS_H__
+#define __VU_COLORS_H__
+
+#include "fw_hal.h"
+#include <stdint.h>
+
+#define VU_COLOR_ENTRIES 128 // VU display value 0..VU_METER_FULL_SCALE
+
+typedef struct {
+  uint8_t r, g; // set_rgb() levels; the VU meter never uses blue
+} vu_color_t;
+
+/**
+ * @brief VU display value (0-127, linear amplitude) -> LED color: the log
+ *        loudness curve, then green -> yellow -> red.
+ */
+extern __CODE const vu_color_t vu_color_table[VU_COLOR_ENTRIES];
+
+#endif // __VU_COLORS_H__
@@ -0,0 +1,359 @@
+// +-----------------------------------------------+
+// | HOST SIMULATION: program audio for OUTMON     |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+
+#include "audio.h"
+#include "sim_hal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYNTH_RATE_HZ 48000
+#define SYNTH_BEAT_S 0.5 // 120 BPM
+
+sim_audio_t sim_audio = {NULL, 0, 0, 1.0};
+sim_howl_t sim_howl;
+
+static uint32_t le(const uint8_t *p, int bytes) {
+  uint32_t v = 0;
+  for (int i = bytes - 1; i >= 0; i--) {
+    v = (v << 8) | p[i];
+  }
+  return v;
+}
+
+static void set_program(float *samples, uint32_t count, uint32_t rate_hz) {
+  free(sim_audio.samples);
+  sim_audio.samples = samples;
+  sim_audio.count = count;
+  sim_audio.rate_hz = rate_hz;
+}
+
+bool sim_audio_load_wav(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *buf = malloc(size > 0 ? (size_t)size : 1);
+  bool ok = buf && size >= 12 && fread(buf, 1, (size_t)size, f) == (size_t)size;
+  fclose(f);
+  if (!ok || memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) {
+    fprintf(stderr, "%s: not a RIFF/WAVE file\n", path);
+    free(buf);
+    return false;
+  }
+
+  uint32_t format = 0, channels = 0, rate = 0, bits = 0;
+  const uint8_t *data = NULL;
+  uint32_t data_len = 0;
+  for (long pos = 12; pos + 8 <= size;) {
+    uint32_t len = le(buf + pos + 4, 4);
+    const uint8_t *body = buf + pos + 8;
+    if (len > (uint32_t)(size - pos - 8)) {
+      len = (uint32_t)(size - pos - 8); // truncated file: use what is there
+    }
+    if (memcmp(buf + pos, "fmt ", 4) == 0 && len >= 16) {
+      format = le(body, 2);
+      channels = le(body + 2, 2);
+      rate = le(body + 4, 4);
+      bits = le(body + 14, 2);
+      if (format == 0xFFFE && len >= 26) {
+        format = le(body + 24, 2); // WAVE_FORMAT_EXTENSIBLE sub-format
+      }
+    } else if (memcmp(buf + pos, "data", 4) == 0) {
+      data = body;
+      data_len = len;
+    }
+    pos += 8 + len + (len & 1);
+  }
+
+  uint32_t bytes = bits / 8;
+  bool pcm = (format == 1 && bits >= 8 && bits <= 32 && bits % 8 == 0) ||
+             (format == 3 && bits == 32);
+  if (!pcm || channels == 0 || rate == 0 || !data) {
+    fprintf(stderr, "%s: only PCM or float WAV files are supported\n", path);
+    free(buf);
+    return false;
+  }
+
+  uint32_t count = data_len / (bytes * channels);
+  float *samples = malloc(((size_t)count + 1) * sizeof(float));
+  for (uint32_t i = 0; i < count; i++) {
+    double sum = 0;
+    for (uint32_t c = 0; c < channels; c++) {
+      const uint8_t *p = data + ((size_t)i * channels + c) * bytes;
+      uint32_t raw = le(p, (int)bytes);
+      double v;
+      if (format == 3) {
+        float fv;
+        memcpy(&fv, &raw, sizeof(fv));
+        v = fv;
+      } else if (bytes == 1) {
+        v = ((int)raw - 128) / 128.0; // 8-bit WAV is unsigned
+      } else {
+        int32_t s = (int32_t)(raw << (32 - bits)); // sign-extend
+        v = s / 2147483648.0;
+      }
+      sum += v;
+    }
+    samples[i] = (float)(sum / channels);
+  }
+  free(buf);
+
+  set_program(samples, count, rate);
+  return count > 0;
+}
+
+// deterministic noise for the drums and breath
+static uint32_t s_noise = 1;
+
+static double noise(void) {
+  s_noise = s_noise * 1664525u + 1013904223u;
+  return (int32_t)s_noise / 2147483648.0;
+}
+
+static uint32_t s_rand = 1;
+
+static uint32_t next_rand(void) {
+  s_rand = s_rand * 1103515245u + 12345u;
+  return s_rand >> 16;
+}
+
+static double note_hz(int semitones_from_a4) {
+  return 440.0 * pow(2.0, semitones_from_a4 / 12.0);
+}
+
+// Am, F, C, G, one chord per 4-beat bar
+static const double s_chords[4][4] = {{220.00, 261.63, 329.63, 440.00},
+                                      {174.61, 220.00, 261.63, 349.23},
+                                      {261.63, 329.63, 392.00, 523.25},
+                                      {196.00, 246.94, 293.66, 392.00}};
+
+static double synth_band(double t) {
+  static const double bass[8] = {55.00, 55.00, 65.41, 55.00,
+                                 43.65, 43.65, 49.00, 49.00}; // eighths
+  static double kick_phase = 0, prev_noise = 0;
+  uint32_t beat = (uint32_t)(t / SYNTH_BEAT_S);
+  double tb = t - beat * SYNTH_BEAT_S;   // time into the beat
+  double te = fmod(t, SYNTH_BEAT_S / 2); // ... into the eighth
+  uint32_t eighth = (uint32_t)(t / (SYNTH_BEAT_S / 2));
+  const double *chord = s_chords[(beat / 4) % 4];
+
+  if (t == 0) {
+    kick_phase = prev_noise = 0;
+  }
+
+  // kick on every beat: a falling sine
+  kick_phase += 2 * M_PI * (50 + 100 * exp(-tb * 30)) / SYNTH_RATE_HZ;
+  double v = 0.9 * sin(kick_phase) * exp(-tb * 12);
+
+  // snare on beats 2 and 4, hi-hat on every eighth
+  double n = noise();
+  if (beat % 2 == 1) {
+    v += (0.35 * n + 0.3 * sin(2 * M_PI * 185 * tb)) * exp(-tb * 20);
+  }
+  v += 0.12 * (n - prev_noise) * exp(-te * 60); // crude high-pass
+  prev_noise = n;
+
+  // bass eighths and a sustained chord
+  double bf = bass[eighth % 8];
+  v += 0.35 * (sin(2 * M_PI * bf * t) + 0.3 * sin(4 * M_PI * bf * t)) *
+       (1 - 0.5 * te / (SYNTH_BEAT_S / 2));
+  for (int k = 0; k < 3; k++) {
+    v += 0.08 * sin(2 * M_PI * chord[k] * t);
+  }
+  return v;
+}
+
+// A minor pentatonic, A3 .. A5
+static const int s_penta[11] = {-12, -9, -7, -5, -2, 0, 3, 5, 7, 10, 12};
+
+static double synth_piano(double t) {
+  static double start[8], hz[8];
+  static uint32_t notes = 0;
+  double v = 0;
+
+  if (t == 0) {
+    notes = 0;
+  }
+  if (t >= notes * 0.25) { // a new note every 250ms, up to 8 ringing
+    start[notes % 8] = t;
+    hz[notes % 8] = note_hz(s_penta[next_rand() % 11]);
+    notes++;
+  }
+  for (uint32_t i = 0; i < 8 && i < notes; i++) {
+    double tn = t - start[i];
+    for (int k = 1; k <= 6; k++) {
+      double hk = hz[i] * k * (1 + 0.0004 * k * k); // slightly inharmonic
+      v += sin(2 * M_PI * hk * tn) * exp(-tn * (2 + k)) / k;
+    }
+  }
+  return v;
+}
+
+static double synth_pad(double t) {
+  uint32_t bar = (uint32_t)(t / 2.0);
+  double tb = t - bar * 2.0;
+  const double *chord = s_chords[bar % 4];
+  double attack = (tb < 0.3) ? tb / 0.3 : 1.0;
+  double v = 0;
+
+  for (int i = 0; i < 4; i++) {
+    for (int d = -1; d <= 1; d += 2) { // detuned pair, +/-4 cents
+      double f = chord[i] * (1 + d * 0.0023);
+      for (int k = 1; k <= 3; k++) {
+        v += sin(2 * M_PI * f * k * t + i + d) / (k * 2.0);
+      }
+    }
+  }
+  return v * attack;
+}
+
+static double synth_voice(double t) {
+  // F1, F2, F3 of the vowels a, e, i, o, u
+  static const double formants[5][3] = {{730, 1090, 2440}, {530, 1840, 2480},
+                                        {270, 2290, 3010}, {570, 840, 2410},
+                                        {300, 870, 2240}};
+  static double phase = 0;
+  static int vowel = 0, pitch = 0;
+  static uint32_t syllable = 0xFFFFFFFF;
+  uint32_t syl = (uint32_t)(t / 0.25);
+  double ts = t - syl * 0.25;
+
+  if (t == 0) {
+    phase = 0;
+    syllable = 0xFFFFFFFF;
+  }
+  if (syl != syllable) { // a new syllable every 250ms
+    syllable = syl;
+    vowel = (int)(next_rand() % 5);
+    pitch = s_penta[next_rand() % 6] - 12; // A2 .. A3 + a 4th
+  }
+  double env = (ts < 0.02) ? ts / 0.02 : (ts > 0.2 ? 0.0 : 1.0);
+  double f0 = note_hz(pitch) * (1 + 0.015 * sin(2 * M_PI * 5.5 * t)); // vibrato
+  phase += 2 * M_PI * f0 / SYNTH_RATE_HZ;
+
+  double v = 0;
+  for (int k = 1; k * f0 < 3500; k++) {
+    double fk = k * f0, a = 0;
+    for (int j = 0; j < 3; j++) {
+      double df = (fk - formants[vowel][j]) / (60.0 + 40 * j);
+      a += 1.0 / (1 + df * df) / (1 + j);
+    }
+    v += a / k * sin(k * phase);
+  }
+  return v * env + 0.01 * noise() * env;
+}
+
+static double synth_flute(double t) {
+  static double phase = 0;
+  static double hz = 440;
+  static uint32_t note = 0xFFFFFFFF;
+  uint32_t n = (uint32_t)(t / 0.6);
+  double tn = t - n * 0.6;
+
+  if (t == 0) {
+    phase = 0;
+    note = 0xFFFFFFFF;
+  }
+  if (n != note) { // a new note every 600ms, legato
+    note = n;
+    hz = note_hz(s_penta[5 + next_rand() % 6]); // A4 .. A5
+  }
+  double env = (tn < 0.05) ? tn / 0.05 : 1.0;
+  phase += 2 * M_PI * hz * (1 + 0.006 * sin(2 * M_PI * 5 * t)) / SYNTH_RATE_HZ;
+  return env * (sin(phase) + 0.12 * sin(2 * phase) + 0.04 * noise());
+}
+
+const char *const sim_audio_names[SIM_AUDIO_PROGRAMS] = {
+    "band", "piano", "pad", "voice", "flute"};
+
+void sim_audio_synth(sim_audio_program_t program, double seconds) {
+  static double (*const synth[SIM_AUDIO_PROGRAMS])(double) = {
+      synth_band, synth_piano, synth_pad, synth_voice, synth_flute};
+  uint32_t count = (uint32_t)(seconds * SYNTH_RATE_HZ);
+  float *samples = malloc(((size_t)count + 1) * sizeof(float));
+  double peak = 0;
+
+  s_noise = 1;
+  s_rand = 1;
+  for (uint32_t i = 0; i < count; i++) {
+    double v = synth[program]((double)i / SYNTH_RATE_HZ);
+    samples[i] = (float)v;
+    peak = fabs(v) > peak ? fabs(v) : peak;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    samples[i] = (float)(samples[i] / peak);
+  }
+
+  set_program(samples, count, SYNTH_RATE_HZ);
+}
+
+double sim_audio_rms_db(void) {
+  double sum = 0;
+  for (uint32_t i = 0; i < sim_audio.count; i++) {
+    sum += (double)sim_audio.samples[i] * sim_audio.samples[i];
+  }
+  return 20 * log10(sim_audio.gain * sqrt(sum / sim_audio.count) + 1e-9);
+}
+
+void sim_howl_start(double hz, double loop_db, double floor_db) {
+  sim_howl.hz = hz;
+  sim_howl.loop_db = loop_db;
+  sim_howl.ref_db = sim_lm1971.atten_db;
+  sim_howl.floor_db = sim_howl.level_db = sim_howl.max_db = floor_db;
+  sim_howl.last_us = sim.time_us;
+}
+
+uint64_t sim_audio_length_us(void) {
+  return sim_audio.rate_hz ? (uint64_t)sim_audio.count * 1000000ULL /
+                                 sim_audio.rate_hz
+                           : 0;
+}
+
+uint8_t sim_audio_outmon(uint64_t time_us) {
+  static uint8_t cached_db = 0xFF;
+  static double atten = 0;
+
+  if (sim_audio.count == 0) {
+    return 0x80;
+  }
+  if (sim_lm1971.atten_db != cached_db) {
+    cached_db = sim_lm1971.atten_db;
+    atten = (cached_db >= 64) ? 0 : pow(10, -cached_db / 20.0);
+  }
+
+  // linear interpolation, looping
+  double pos = fmod((double)time_us * sim_audio.rate_hz / 1e6, sim_audio.count);
+  uint32_t i = (uint32_t)pos;
+  uint32_t j = (i + 1 < sim_audio.count) ? i + 1 : 0;
+  double x = sim_audio.samples[i] +
+             (pos - i) * (sim_audio.samples[j] - sim_audio.samples[i]);
+
+  double y = sim_audio.gain * x;
+  if (sim_howl.hz != 0) {
+    // loop gain falls 1dB per dB of attenuation above ref_db, MUTE opens it
+    double loop = (cached_db >= 64) ? -60
+                                    : sim_howl.loop_db + sim_howl.ref_db - cached_db;
+    double l = sim_howl.level_db +
+               loop * (double)(time_us - sim_howl.last_us) / SIM_HOWL_TRIP_US;
+    sim_howl.level_db = l < sim_howl.floor_db ? sim_howl.floor_db
+                                              : (l > 0 ? 0 : l);
+    sim_howl.max_db = (sim_howl.level_db > sim_howl.max_db) ? sim_howl.level_db
+                                                            : sim_howl.max_db;
+    sim_howl.last_us = time_us;
+    y += pow(10, sim_howl.level_db / 20) * sin(2 * M_PI * sim_howl.hz * time_us / 1e6);
+  }
+
+  long v = lround(0x80 + 127 * atten * y);
+  return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
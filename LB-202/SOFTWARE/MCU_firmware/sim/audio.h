@@ -0,0 +1,95 @@
+// +-----------------------------------------------+
+// | HOST SIMULATION: program audio for OUTMON     |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// A mono audio program (a WAV file, or a synthesized one) played into the
+// mixer, optionally with acoustic feedback, through the LM1971 model, and
+// onto OUTMON:
+//
+//   sim_adc.source[ADC_OUTMON] = sim_audio_outmon;
+//
+// Full scale (+/-1.0) at 0dB attenuation and sim_audio.gain 1.0 is
+// +/-127 ADC counts around 0x80; louder than that clips, like the real ADC.
+
+#ifndef __SIM_AUDIO_H__
+#define __SIM_AUDIO_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  float *samples;    // mono, +/-1.0
+  uint32_t count;    // samples in the program (played in a loop)
+  uint32_t rate_hz;  // sample rate
+  double gain;       // program level into the mixer (1.0 = full scale)
+} sim_audio_t;
+
+extern sim_audio_t sim_audio;
+
+// Acoustic feedback: a tone that goes round mic -> mixer -> speaker -> mic
+// every SIM_HOWL_TRIP_US, gaining loop_db dB per trip at ref_db attenuation
+// (1dB less per extra dB of attenuation).  It starts at floor_db, and the PA
+// saturates at 0dB (full scale before the LM1971).
+#define SIM_HOWL_TRIP_US 10000 // ~3.4m from the speaker to the mic
+
+typedef struct {
+  double hz;          // 0 = no feedback
+  double loop_db;     // loop gain at ref_db, dB per trip
+  uint8_t ref_db;     // LM1971 setting the loop gain is for (the RVC's)
+  double floor_db;    // start level, and where it dies away to
+  double level_db;    // current level, before the LM1971
+  double max_db;      // highest level_db so far
+  uint64_t last_us;   // time of the previous level update
+} sim_howl_t;
+
+extern sim_howl_t sim_howl;
+
+typedef enum {
+  SIM_AUDIO_BAND = 0, // kick, snare, hi-hat, bass and chords at 120 BPM
+  SIM_AUDIO_PIANO,    // overlapping decaying notes, 6 harmonics
+  SIM_AUDIO_PAD,      // sustained 4-note chords, detuned, slow attack
+  SIM_AUDIO_VOICE,    // sung syllables: glottal harmonics through formants
+  SIM_AUDIO_FLUTE,    // one near-sine note at a time, with vibrato and breath
+  SIM_AUDIO_PROGRAMS
+} sim_audio_program_t;
+
+extern const char *const sim_audio_names[SIM_AUDIO_PROGRAMS];
+
+/**
+ * @brief Loads a PCM WAV file (8/16/24/32-bit, any channels, mixed to mono).
+ * @return false (with a message on stderr) if it cannot be read.
+ */
+bool sim_audio_load_wav(const char *path);
+
+/**
+ * @brief Synthesizes `seconds` of a program, peak normalized to 1.0.
+ *        Deterministic.
+ */
+void sim_audio_synth(sim_audio_program_t program, double seconds);
+
+/**
+ * @brief Starts feedback at `hz`, `loop_db` per trip at the LM1971's current
+ *        setting, from `floor_db`.
+ */
+void sim_howl_start(double hz, double loop_db, double floor_db);
+
+/**
+ * @brief RMS of the program at sim_audio.gain, in dB of full scale.
+ */
+double sim_audio_rms_db(void);
+
+/**
+ * @brief OUTMON ADC source: the program (plus feedback) at `time_us`,
+ *        attenuated by the latched LM1971 setting.
+ */
+uint8_t sim_audio_outmon(uint64_t time_us);
+
+/**
+ * @brief Program length in us.
+ */
+uint64_t sim_audio_length_us(void);
+
+#endif // __SIM_AUDIO_H__
@@ -0,0 +1,305 @@
+// +-----------------------------------------------+
+// | HOST SHIM: FwLib_STC8 fw_hal.h for Linux sim  |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// This header replaces lib/FwLib_STC8/include/fw_hal.h when the firmware is
+// compiled for the host (see sim/Makefile).  It provides only the subset of the
+// FwLib_STC8 API that src/main.c and src/preferences.c actually use.
+//
+// Every SFR, SBIT and peripheral that the firmware touches is backed by an
+// in-memory model in sim_hal.c, so the firmware source compiles UNCHANGED:
+//   - port pins (P1.x, P3.x) are plain bytes, but every access first calls
+//     sim_pins_sync(), which lets the LM1971 model see CLK/DATA/LOAD edges
+//   - ADC_RES returns the value of the currently selected channel; with the
+//     ADC interrupt enabled, conversions complete in the background and
+//     ADC_Routine() runs after the current ISR (or wakes IDLE)
+//   - PCA compare registers (CCAPnH, plus XCCAPnH in 10-bit mode) are the RGB
+//     LED duty cycles
+//   - IAP commands read/write/erase a 4KB EEPROM array, with write counters
+//   - SYS_Delay()/SYS_DelayUs() advance simulated time instead of spinning
+//   - touching PCON (entering IDLE) runs the next interrupt: a background
+//     ADC conversion, Timer2 (VU sampling) or the next Timer0 tick
+//   - RCC_SetPowerDownMode() sleeps until the wake-up timer fires
+//   - TH0/TL0/TF0 count the modelled time (ADC waits, IAP, LM1971 pin
+//     clocks) since the Timer0 tick started, not instruction cycles
+//   - a command written to I2CMSCR takes its SCL clocks at the I2CCFG bus
+//     speed in the background, against one modelled device, and then runs
+//     I2C_Routine() (INCLUDE_I2C_QUEUE builds)
+
+#ifndef ___FW_INC_H___
+#define ___FW_INC_H___
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim_hal.h"
+
+// COMPILER KEYWORDS ---------
+#define __BIT bool
+#define __DATA
+#define __IDATA
+#define __PDATA
+#define __XDATA
+#define __CODE
+#define __REENTRANT
+
+#define INTERRUPT(name, vector) void name(void)
+#define INTERRUPT_USING(name, vector, regnum) void name(void)
+#define NOP() sim_nop()
+
+// TYPES ---------
+typedef enum {
+  HAL_State_OFF = 0x00,
+  HAL_State_ON = 0x01,
+} HAL_State_t;
+
+#define __SYSCLOCK                                                             \
+  (__CONF_FOSC / ((__CONF_CLKDIV == 0) ? 1 : __CONF_CLKDIV))
+
+// SYSTEM ---------
+#define SYS_SetClock() sim_sys_set_clock()
+#define SYS_Delay(__MS__) sim_delay_us((uint32_t)(__MS__) * 1000UL)
+#define SYS_DelayUs(__US__) sim_delay_us(__US__)
+
+// SFRs ---------
+#define SIM_SBIT(__MEMBER__) (*(sim_pins_sync(), &sim_pins.__MEMBER__))
+
+#define P10 SIM_SBIT(p10)
+#define P11 SIM_SBIT(p11)
+#define P12 SIM_SBIT(p12)
+#define P13 SIM_SBIT(p13)
+#define P14 SIM_SBIT(p14)
+#define P15 SIM_SBIT(p15)
+#define P16 SIM_SBIT(p16)
+#define P17 SIM_SBIT(p17)
+#define P30 SIM_SBIT(p30)
+#define P31 SIM_SBIT(p31)
+#define P32 SIM_SBIT(p32)
+#define P33 SIM_SBIT(p33)
+#define P34 SIM_SBIT(p34)
+#define P35 SIM_SBIT(p35)
+#define P36 SIM_SBIT(p36)
+#define P37 SIM_SBIT(p37)
+
+#define EA sim_cpu.ea
+
+// Timer0 count (12T, read-only): modelled time since the tick started
+#define TH0 ((uint8_t)(sim_timer0_count() >> 8))
+#define TL0 ((uint8_t)sim_timer0_count())
+#define TF0 sim_timer0_overflow()
+
+// extended SFRs (XDATA 0xFExx/0xFDxx) are only there with EAXFR set
+#define SFRX_ON() (sim_cpu.p_sw2 |= 0x80)
+#define SFRX_OFF() (sim_cpu.p_sw2 &= ~0x80)
+#define PCON (*(sim_cpu_idle(), &sim_cpu.pcon))
+
+// RCC (power modes) ---------
+#define RCC_SetPowerDownMode(__STATE__)                                        \
+  do {                                                                         \
+    if (__STATE__) {                                                           \
+      sim_cpu_power_down();                                                    \
+    }                                                                          \
+  } while (0)
+#define RCC_SetPowerDownWakeupTimerState(__STATE__)                            \
+  (sim_cpu.wkt_enabled = (__STATE__))
+#define RCC_SetPowerDownWakeupTimerCountdown(__15BIT_COUNT__)                  \
+  (sim_cpu.wkt_count = (__15BIT_COUNT__) & 0x7FFF)
+
+// GPIO ---------
+typedef enum {
+  GPIO_Mode_InOut_QBD = 0x00,
+  GPIO_Mode_Output_PP = 0x01,
+  GPIO_Mode_Input_HIP = 0x02,
+  GPIO_Mode_InOut_OD = 0x03,
+} GPIO_Mode_t;
+
+typedef enum {
+  GPIO_Port_0 = 0U,
+  GPIO_Port_1 = 1U,
+  GPIO_Port_2 = 2U,
+  GPIO_Port_3 = 3U,
+  GPIO_Port_4 = 4U,
+  GPIO_Port_5 = 5U,
+} GPIO_Port_t;
+
+typedef enum {
+  GPIO_Pin_0 = 0x01,
+  GPIO_Pin_1 = 0x02,
+  GPIO_Pin_2 = 0x04,
+  GPIO_Pin_3 = 0x08,
+  GPIO_Pin_4 = 0x10,
+  GPIO_Pin_5 = 0x20,
+  GPIO_Pin_6 = 0x40,
+  GPIO_Pin_7 = 0x80,
+  GPIO_Pin_All = 0xFF,
+} GPIO_Pin_t;
+
+#define GPIO_P1_SetMode(__PINS__, __MODE__)                                    \
+  sim_gpio_set_mode(GPIO_Port_1, __PINS__, __MODE__)
+#define GPIO_P2_SetMode(__PINS__, __MODE__)                                    \
+  sim_gpio_set_mode(GPIO_Port_2, __PINS__, __MODE__)
+#define GPIO_P3_SetMode(__PINS__, __MODE__)                                    \
+  sim_gpio_set_mode(GPIO_Port_3, __PINS__, __MODE__)
+#define GPIO_SetPullUp(__PORT__, __PINS__, __STATE__)                          \
+  sim_gpio_set_pullup(__PORT__, __PINS__, __STATE__)
+
+// ADC ---------
+#define ADC_SetPowerState(__STATE__) sim_adc_set_power(__STATE__)
+#define ADC_Start() sim_adc_start()
+#define ADC_SamplingFinished() (sim_adc.flag)
+#define ADC_ClearInterrupt() (sim_adc.flag = 0)
+#define ADC_SetChannel(__CHANNEL__) (sim_adc.channel = ((__CHANNEL__) & 0x0F))
+#define ADC_SetResultAlignmentLeft() (sim_adc.align_right = 0)
+#define ADC_SetResultAlignmentRight() (sim_adc.align_right = 1)
+#define ADC_SetClockPrescaler(__PRESCALER__) (sim_adc.prescaler = (__PRESCALER__))
+#define ADC_RES (sim_adc.res)
+
+// PCA ---------
+typedef enum {
+  PCA_ClockSource_SysClkDiv12 = 0x00,
+  PCA_ClockSource_SysClkDiv2 = 0x01,
+  PCA_ClockSource_Timer0Overflow = 0x02,
+  PCA_ClockSource_ExtClock = 0x03,
+  PCA_ClockSource_SysClk = 0x04,
+  PCA_ClockSource_SysClkDiv4 = 0x05,
+  PCA_ClockSource_SysClkDiv6 = 0x06,
+  PCA_ClockSource_SysClkDiv8 = 0x07,
+} PCA_ClockSource_t;
+
+typedef enum {
+  PCA_WorkMode_None = 0x00,
+  PCA_WorkMode_PWM_NonInterrupt = 0x42,
+} PCA_WorkMode_t;
+
+typedef enum {
+  PCA_PWM_BitWidth_8 = 0x00,
+  PCA_PWM_BitWidth_7 = 0x01,
+  PCA_PWM_BitWidth_6 = 0x02,
+  PCA_PWM_BitWidth_10 = 0x03,
+} PCA_PWM_Bitwidth_t;
+
+typedef enum {
+  PCA_AlterPort_P12_P11_P10_P37 = 0x00,
+  PCA_AlterPort_P34_P35_P36_P37 = 0x01,
+  PCA_AlterPort_P24_P25_P26_P27 = 0x10,
+} PCA_AlterPort_t;
+
+#define PCA_SetCounterState(__STATE__) (sim_pca.running = (__STATE__))
+#define PCA_SetStopCounterInIdle(__STATE__) (sim_pca.stop_in_idle = (__STATE__))
+#define PCA_SetClockSource(__SOURCE__) (sim_pca.clock_source = (__SOURCE__))
+#define PCA_EnableCounterOverflowInterrupt(__STATE__) ((void)(__STATE__))
+#define PCA_SetPort(__ALTER_PORT__) (sim_pca.port = (__ALTER_PORT__))
+
+#define PCA_PCA0_SetWorkMode(__MODE__) (sim_pca.mode[0] = (__MODE__))
+#define PCA_PCA1_SetWorkMode(__MODE__) (sim_pca.mode[1] = (__MODE__))
+#define PCA_PCA2_SetWorkMode(__MODE__) (sim_pca.mode[2] = (__MODE__))
+
+#define PCA_PWM0_SetBitWidth(__BIT_WIDTH__) (sim_pca.bit_width[0] = (__BIT_WIDTH__))
+#define PCA_PWM1_SetBitWidth(__BIT_WIDTH__) (sim_pca.bit_width[1] = (__BIT_WIDTH__))
+#define PCA_PWM2_SetBitWidth(__BIT_WIDTH__) (sim_pca.bit_width[2] = (__BIT_WIDTH__))
+
+#define PCA_PCA0_SetCompareValue(__VALUE__) sim_pca_set_compare(0, __VALUE__)
+#define PCA_PCA1_SetCompareValue(__VALUE__) sim_pca_set_compare(1, __VALUE__)
+#define PCA_PCA2_SetCompareValue(__VALUE__) sim_pca_set_compare(2, __VALUE__)
+#define PCA_PCA0_ChangeCompareValue(__VALUE__) sim_pca_set_compare(0, __VALUE__)
+#define PCA_PCA1_ChangeCompareValue(__VALUE__) sim_pca_set_compare(1, __VALUE__)
+#define PCA_PCA2_ChangeCompareValue(__VALUE__) sim_pca_set_compare(2, __VALUE__)
+#define PCA_PCA0_SetCompareValue10bit(__VALUE__) sim_pca_set_compare(0, __VALUE__)
+#define PCA_PCA1_SetCompareValue10bit(__VALUE__) sim_pca_set_compare(1, __VALUE__)
+#define PCA_PCA2_SetCompareValue10bit(__VALUE__) sim_pca_set_compare(2, __VALUE__)
+#define PCA_PCA0_ChangeCompareValue10bit(__VALUE__) sim_pca_set_compare(0, __VALUE__)
+#define PCA_PCA1_ChangeCompareValue10bit(__VALUE__) sim_pca_set_compare(1, __VALUE__)
+#define PCA_PCA2_ChangeCompareValue10bit(__VALUE__) sim_pca_set_compare(2, __VALUE__)
+
+// IAP (EEPROM) ---------
+#define IAP_SetWaitTime() (sim_iap.tps = (uint8_t)(__CONF_FOSC / 1000000UL))
+#define IAP_SetEnabled(__STATE__) (sim_iap.enabled = (__STATE__))
+#define IAP_ReadData() (sim_iap.data)
+#define IAP_WriteData(__BYTE__) (sim_iap.data = (__BYTE__))
+#define IAP_CmdRead(__16BIT_ADDR__) sim_iap_cmd(SIM_IAP_CMD_READ, __16BIT_ADDR__)
+#define IAP_CmdWrite(__16BIT_ADDR__) sim_iap_cmd(SIM_IAP_CMD_WRITE, __16BIT_ADDR__)
+#define IAP_CmdErase(__16BIT_ADDR__) sim_iap_cmd(SIM_IAP_CMD_ERASE, __16BIT_ADDR__)
+#define IAP_IsCmdFailed() (sim_iap.cmd_failed)
+#define IAP_ClearCmdFailFlag() (sim_iap.cmd_failed = 0)
+
+// TIMER / INTERRUPTS ---------
+typedef enum {
+  TIM_TimerMode_16BitAuto = 0x00,
+  TIM_TimerMode_16Bit = 0x01,
+  TIM_TimerMode_8BitAuto = 0x02,
+  TIM_TimerMode_16BitAutoNoInt = 0x03
+} TIM_TimerMode_t;
+
+#define TIM_Timer0_Config(__FREQ1T__, __MODE__, __FREQUENCY__)                 \
+  (sim_cpu.timer0_hz = (__FREQUENCY__))
+#define TIM_Timer0_SetRunState(__STATE__) sim_timer0_set_run(__STATE__)
+#define TIM_Timer2_Config(__FREQ1T__, __PRESCALER__, __FREQUENCY__)            \
+  (sim_cpu.timer2_hz = (__FREQUENCY__))
+#define TIM_Timer2_SetRunState(__STATE__) sim_timer2_set_run(__STATE__)
+
+#define EXTI_VectTimer0 1
+#define EXTI_VectADC 5
+#define EXTI_VectTimer2 12
+
+#define EXTI_Global_SetIntState(__STATE__)                                     \
+  (sim_cpu.ea_offs += !(__STATE__), sim_cpu.ea = (__STATE__))
+#define EXTI_Timer0_SetIntState(__STATE__) (sim_cpu.et0 = (__STATE__))
+#define EXTI_Timer2_SetIntState(__STATE__) (sim_cpu.et2 = (__STATE__))
+#define EXTI_ADC_SetIntState(__STATE__) (sim_cpu.eadc = (__STATE__))
+
+// I2C master (INCLUDE_I2C_QUEUE builds) ---------
+typedef enum {
+  I2C_MasterCmd_Wait = 0x00,
+  I2C_MasterCmd_Start = 0x01,
+  I2C_MasterCmd_Send = 0x02,
+  I2C_MasterCmd_RxAck = 0x03,
+  I2C_MasterCmd_Recv = 0x04,
+  I2C_MasterCmd_TxAck = 0x05,
+  I2C_MasterCmd_Stop = 0x06,
+  I2C_MasterCmd_StartSendRxAck = 0x09,
+  I2C_MasterCmd_SendRxAck = 0x0A,
+  I2C_MasterCmd_RecvTxAck0 = 0x0B,
+  I2C_MasterCmd_RecvNAck = 0x0C,
+} I2C_MasterCmd_t;
+
+typedef enum {
+  I2C_AlterPort_P15_P14 = 0x00,
+  I2C_AlterPort_P25_P24 = 0x01,
+  I2C_AlterPort_P77_P76 = 0x02,
+  I2C_AlterPort_P32_P33 = 0x03,
+} I2C_AlterPort_t;
+
+#define I2C_SetPort(__ALTER_PORT__)                                            \
+  (sim_cpu.p_sw2 = (sim_cpu.p_sw2 & ~(0x03 << 4)) | ((__ALTER_PORT__) << 4))
+#define I2C_PRESCALER_COMPUTE(__FREQ__) ((((__SYSCLOCK / __FREQ__) / 2U) - 4U) / 2U)
+
+// every access first lets the model take a command written since the last
+#define SIM_I2C(__MEMBER__) (*(sim_i2c_access(), &sim_i2c.__MEMBER__))
+#define I2CCFG SIM_I2C(cfg)
+#define I2CMSCR SIM_I2C(mscr)
+#define I2CMSST SIM_I2C(msst)
+#define I2CTXD SIM_I2C(txd)
+#define I2CRXD SIM_I2C(rxd)
+
+#define EXTI_VectI2C 24
+
+// UART (DEBUG builds only) ---------
+typedef enum {
+  UART1_BaudSource_Timer1 = 0x00,
+  UART1_BaudSource_Timer2 = 0x01,
+} UART1_BaudSource_t;
+
+typedef enum {
+  UART1_AlterPort_P30_P31 = 0x00,
+} UART1_AlterPort_t;
+
+#define UART1_Config8bitUart(__SOURCE__, __1T__, __BAUD__) ((void)0)
+#define UART1_SwitchPort(__PORT__) ((void)0)
+#define UART1_TxChar(__CH__) sim_uart_tx_char(__CH__)
+#define UART1_TxHex(__HEX__) sim_uart_tx_hex(__HEX__)
+#define UART1_TxString(__STR__) sim_uart_tx_string(__STR__)
+
+#endif // ___FW_INC_H___
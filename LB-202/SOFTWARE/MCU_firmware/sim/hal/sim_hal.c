@@ -0,0 +1,753 @@
+// +-----------------------------------------------+
+// | HOST SHIM: in-memory models of STC8G1K08      |
+// |            peripherals used by LB-202         |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+
+#include "sim_hal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+#define SIM_FIRMWARE_STACK_SIZE (256 * 1024)
+
+// firmware entry points (main() is renamed by the Makefile)
+void firmware_main(void);
+void Timer0_Routine(void);
+void ADC_Routine(void);
+void VU_Routine(void);
+void I2C_Routine(void) __attribute__((weak));    // INCLUDE_I2C_QUEUE
+
+sim_pins_t sim_pins;
+sim_cpu_t sim_cpu;
+sim_adc_t sim_adc;
+sim_pca_t sim_pca;
+sim_iap_t sim_iap;
+sim_lm1971_t sim_lm1971;
+sim_i2c_t sim_i2c;
+sim_energy_t sim_energy;
+sim_state_t sim;
+
+static ucontext_t s_harness_ctx;
+static ucontext_t s_firmware_ctx;
+static uint8_t *s_firmware_stack;
+static bool s_booted;
+static uint64_t s_next_tick_us;
+static uint64_t s_tick_start_us;    // this Timer0 tick, for TH0/TL0
+static uint64_t s_tick_start_clock; // sim_lm1971.clock at the tick
+static uint64_t s_next_t2_us;
+static uint32_t s_irq_clocks; // Timer2/ADC/I2C interrupt CPU time this tick
+
+// +---------------------------------------------------------------+
+// | PINS + LM1971                                                 |
+// +---------------------------------------------------------------+
+const uint32_t sim_lm1971_min_ns[SIM_LM1971_T_COUNT] = {200, 100, 50, 50};
+const char *const sim_lm1971_names[SIM_LM1971_T_COUNT] = {
+    "LOAD low to CLK high", "DATA setup", "DATA hold", "CLK high to LOAD high"};
+
+uint32_t sim_lm1971_clocks_to_ns(uint64_t clocks) {
+  return (uint32_t)(clocks * 1000000000ULL / SIM_SYSCLOCK_HZ);
+}
+
+// edge at clock `at`, constraint measured from clock `from`
+static void lm1971_check(sim_lm1971_timing_t t, uint64_t from, uint64_t at) {
+  uint64_t clocks = at - from;
+  if (clocks < sim_lm1971.min_clocks[t]) {
+    sim_lm1971.min_clocks[t] = (uint32_t)clocks;
+  }
+  // clocks * 1e9 / SYSCLK >= spec, without rounding
+  if (clocks * 1000000000ULL < (uint64_t)sim_lm1971_min_ns[t] * SIM_SYSCLOCK_HZ) {
+    sim_lm1971.timing_errors[t]++;
+  }
+}
+
+// One SYSCLK clock, so NOP() delays are visible to the timing checks
+void sim_nop(void) { sim_lm1971.clock++; }
+
+// Called before every pin access, so it sees the result of the previous write.
+// Only one pin can change between two calls, so edges are never merged.
+// Every access counts as one clock (SETB/CLR/MOV bit on the 1T core), and the
+// change it saw was made by the previous access, at `last_access`.
+void sim_pins_sync(void) {
+  uint8_t clk = sim_pins.p32;
+  uint8_t data = sim_pins.p33;
+  uint8_t load = sim_pins.p34;
+  uint64_t at = sim_lm1971.last_access;
+
+  sim_lm1971.clock++;
+  sim_lm1971.last_access = sim_lm1971.clock;
+
+  if (data != sim_lm1971.last_data) {
+    if (sim_lm1971.clk_rise_in_frame) {
+      lm1971_check(SIM_LM1971_T_DATA_HOLD, sim_lm1971.clk_rise_at, at);
+    }
+    sim_lm1971.data_at = at;
+    sim_lm1971.last_data = data;
+  }
+
+  if (load == 0 && sim_lm1971.last_load != 0) {
+    // LOAD falling edge: start of a new frame
+    if (clk != 0) {
+      sim_lm1971.order_errors++; // CLK must go low before LOAD goes low
+    }
+    sim_lm1971.shift = 0;
+    sim_lm1971.bits = 0;
+    sim_lm1971.load_fall_at = at;
+    sim_lm1971.clk_rise_in_frame = 0;
+  }
+
+  if (load == 0 && clk != 0 && sim_lm1971.last_clk == 0) {
+    // CLK rising edge while LOAD is low: shift in DATA (MSB first)
+    lm1971_check(SIM_LM1971_T_LOAD_CLK, sim_lm1971.load_fall_at, at);
+    lm1971_check(SIM_LM1971_T_DATA_SETUP, sim_lm1971.data_at, at);
+    sim_lm1971.shift = (uint16_t)((sim_lm1971.shift << 1) | (data & 0x01));
+    sim_lm1971.bits++;
+    sim_lm1971.clk_rise_at = at;
+    sim_lm1971.clk_rise_in_frame = 1;
+  }
+
+  if (load != 0 && sim_lm1971.last_load == 0) {
+    // LOAD rising edge: latch the frame (8 address bits, 8 data bits)
+    if (sim_lm1971.clk_rise_in_frame) {
+      lm1971_check(SIM_LM1971_T_CLK_LOAD, sim_lm1971.clk_rise_at, at);
+    }
+    sim_lm1971.frame_clocks = (uint32_t)(at - sim_lm1971.load_fall_at);
+    if (sim_lm1971.bits == 16 && (sim_lm1971.shift >> 8) == 0x00) {
+      sim_lm1971.atten_db = sim_lm1971.shift & 0xFF;
+      sim_lm1971.writes++;
+      if (sim.on_atten) {
+        sim.on_atten(sim_lm1971.atten_db);
+      }
+    } else {
+      sim_lm1971.errors++;
+    }
+  }
+
+  sim_lm1971.last_clk = clk;
+  sim_lm1971.last_load = load;
+}
+
+// +---------------------------------------------------------------+
+// | SYSTEM                                                        |
+// +---------------------------------------------------------------+
+void sim_sys_set_clock(void) {}
+
+void sim_delay_us(uint32_t us) { sim.time_us += us; }
+
+void sim_gpio_set_mode(uint8_t port, uint8_t pins, uint8_t mode) {
+  if (mode == 0x03) { // GPIO_Mode_InOut_OD
+    sim_cpu.od_pins[port] |= pins;
+  } else {
+    sim_cpu.od_pins[port] &= ~pins;
+  }
+}
+
+void sim_gpio_set_pullup(uint8_t port, uint8_t pins, uint8_t state) {
+  (void)port;
+  (void)pins;
+  (void)state;
+}
+
+// +---------------------------------------------------------------+
+// | ADC                                                           |
+// +---------------------------------------------------------------+
+uint32_t sim_adc_conv_us(void) {
+  // ADC clock = SYSCLK / 2 / (prescaler + 1)
+  uint32_t adc_hz = SIM_SYSCLOCK_HZ / 2 / (sim_adc.prescaler + 1);
+  return (uint32_t)((SIM_ADC_CONV_CLOCKS * 1000000ULL + adc_hz - 1) / adc_hz);
+}
+
+// Sample the input at `start_us`; the result is ready one conversion later
+static void sim_adc_convert(uint64_t start_us) {
+  uint8_t ch = sim_adc.channel & 0x0F;
+  uint64_t end_us = start_us + sim_adc_conv_us();
+
+  sim_adc.res = sim_adc.source[ch] ? sim_adc.source[ch](start_us)
+                                   : sim_adc.inputs[ch];
+  sim_adc.conversions[ch]++;
+  sim_adc.flag = 1;
+  sim.time_us = (sim.time_us > end_us) ? sim.time_us : end_us;
+}
+
+void sim_adc_set_power(uint8_t state) {
+  if (state && !sim_adc.powered) {
+    sim_adc.powered_us = sim.time_us;
+    sim_energy.adc_on_since_us = sim.time_us;
+  } else if (!state && sim_adc.powered) {
+    sim_energy.adc_on_us += sim.time_us - sim_energy.adc_on_since_us;
+  }
+  sim_adc.powered = state;
+}
+
+void sim_adc_start(void) {
+  if (!sim_adc.powered) {
+    sim_adc.unpowered_conversions++;
+  } else if (sim.time_us - sim_adc.powered_us < SIM_ADC_SETTLE_US) {
+    sim_adc.unsettled_conversions++;
+  }
+  if (sim_cpu.ea && sim_cpu.eadc) {
+    sim_adc.pending = 1; // completes in the background, see sim_adc_service()
+    sim_adc.start_us = sim.time_us;
+    return;
+  }
+  sim_adc_convert(sim.time_us); // polled: the caller waits for the conversion
+}
+
+static bool sim_timer2_due(void);
+
+// A background conversion is running, and ends before the next Timer2
+// interrupt and (while Timer0 runs) the next Timer0 tick; a later one waits
+// for those to be delivered first (it goes on converting meanwhile).
+static bool sim_adc_due(void) {
+  if (!(sim_adc.pending && sim_cpu.ea && sim_cpu.eadc)) {
+    return false;
+  }
+  uint64_t end_us = sim_adc.start_us + sim_adc_conv_us();
+  if (sim_timer2_due() && s_next_t2_us < end_us) {
+    return false;
+  }
+  if (!s_booted || !(sim_cpu.et0 && sim_cpu.tr0)) {
+    return true;
+  }
+  return end_us <= s_next_tick_us;
+}
+
+// Run background conversions, and the ADC interrupt at the end of each one,
+// until none is due.  Called when the CPU is free to take the ADC interrupt:
+// after the Timer0 ISR returns, or from IDLE.
+static void sim_adc_service(void) {
+  while (sim_adc_due()) {
+    sim_adc.pending = 0;
+    sim_adc_convert(sim_adc.start_us);
+    sim_adc.interrupts++;
+    s_irq_clocks += SIM_RUN_CLOCKS_PER_IRQ;
+    sim_cpu.in_isr = 1;
+    ADC_Routine();
+    sim_pins_sync();
+    sim_cpu.in_isr = 0;
+  }
+}
+
+// +---------------------------------------------------------------+
+// | TIMER2                                                        |
+// +---------------------------------------------------------------+
+void sim_timer0_set_run(uint8_t state) {
+  if (state && !sim_cpu.tr0 && s_booted && sim_cpu.timer0_hz != 0) {
+    s_next_tick_us = sim.time_us + 1000000UL / sim_cpu.timer0_hz;
+  }
+  sim_cpu.tr0 = state;
+}
+
+void sim_timer2_set_run(uint8_t state) {
+  if (state && !sim_cpu.tr2 && sim_cpu.timer2_hz != 0) {
+    s_next_t2_us = sim.time_us + 1000000UL / sim_cpu.timer2_hz;
+  }
+  sim_cpu.tr2 = state;
+}
+
+// Timer2 overflows before the next Timer0 tick (ties go to Timer0)
+static bool sim_timer2_due(void) {
+  if (!(sim_cpu.ea && sim_cpu.et2 && sim_cpu.tr2 && sim_cpu.timer2_hz)) {
+    return false;
+  }
+  return !(s_booted && sim_cpu.et0 && sim_cpu.tr0) ||
+         s_next_t2_us < s_next_tick_us;
+}
+
+// Overflows missed while the CPU was busy set the flag only once
+static void sim_timer2_irq(void) {
+  uint32_t period_us = 1000000UL / sim_cpu.timer2_hz;
+
+  if (sim.time_us < s_next_t2_us) {
+    sim.time_us = s_next_t2_us;
+  }
+  while (s_next_t2_us <= sim.time_us) {
+    s_next_t2_us += period_us;
+  }
+  sim_cpu.timer2_irqs++;
+  s_irq_clocks += SIM_RUN_CLOCKS_PER_IRQ;
+  sim_cpu.in_isr = 1;
+  VU_Routine();
+  sim_pins_sync();
+  sim_cpu.in_isr = 0;
+}
+
+// extended SFRs (I2C) are only there with EAXFR set
+void sim_xfr_access(void) {
+  if (!(sim_cpu.p_sw2 & 0x80)) {
+    sim_cpu.xfr_errors++;
+  }
+}
+
+// +---------------------------------------------------------------+
+// | I2C MASTER                                                    |
+// +---------------------------------------------------------------+
+#define SIM_I2C_ENI2C 0x80  // I2CCFG
+#define SIM_I2C_EMSI 0x80   // I2CMSCR
+#define SIM_I2C_MSIF 0x40   // I2CMSST
+#define SIM_I2C_MSACKI 0x02 // I2CMSST
+#define SIM_I2C_SSD1306 0x78
+
+// I2CMSCR commands (I2C_MasterCmd_* in fw_i2c.h)
+#define SIM_I2C_CMD_START 0x01
+#define SIM_I2C_CMD_SEND 0x02
+#define SIM_I2C_CMD_RXACK 0x03
+#define SIM_I2C_CMD_RECV 0x04
+#define SIM_I2C_CMD_TXACK 0x05
+#define SIM_I2C_CMD_STOP 0x06
+#define SIM_I2C_CMD_START_SEND_RXACK 0x09
+#define SIM_I2C_CMD_SEND_RXACK 0x0A
+#define SIM_I2C_CMD_RECV_TXACK0 0x0B
+#define SIM_I2C_CMD_RECV_NACK 0x0C
+
+// SCL clocks each command takes (0 = not a command)
+static const uint8_t s_i2c_cmd_clocks[16] = {
+    [SIM_I2C_CMD_START] = 1,  [SIM_I2C_CMD_SEND] = 8,
+    [SIM_I2C_CMD_RXACK] = 1,  [SIM_I2C_CMD_RECV] = 8,
+    [SIM_I2C_CMD_TXACK] = 1,  [SIM_I2C_CMD_STOP] = 1,
+    [SIM_I2C_CMD_START_SEND_RXACK] = 10, [SIM_I2C_CMD_SEND_RXACK] = 9,
+    [SIM_I2C_CMD_RECV_TXACK0] = 9,       [SIM_I2C_CMD_RECV_NACK] = 9};
+
+// I2C bus clock = SYSCLK / 2 / (MSSPEED * 2 + 4)
+static uint32_t sim_i2c_cmd_us(uint8_t cmd) {
+  uint32_t bus_hz = SIM_SYSCLOCK_HZ / 2 / ((sim_i2c.cfg & 0x3F) * 2 + 4);
+  return (uint32_t)((s_i2c_cmd_clocks[cmd] * 1000000ULL + bus_hz - 1) / bus_hz);
+}
+
+// A command written to I2CMSCR since the last look goes on the bus (its
+// command bits then read back as Wait); ENI2C off drops the one on the bus.
+static void sim_i2c_latch(void) {
+  if (!(sim_i2c.cfg & SIM_I2C_ENI2C)) {
+    if (sim_i2c.cmd) {
+      sim_i2c.resets++;
+    }
+    sim_i2c.cmd = 0;
+    sim_i2c.mscr &= ~0x0F;
+    sim_i2c.addressed = false;
+    return;
+  }
+  uint8_t cmd = sim_i2c.mscr & 0x0F;
+  if (cmd && s_i2c_cmd_clocks[cmd]) {
+    sim_i2c.mscr &= ~0x0F;
+    sim_i2c.cmd = cmd;
+    sim_i2c.done_us = sim.time_us + sim_i2c_cmd_us(cmd);
+    sim_i2c.busy_us += sim_i2c_cmd_us(cmd);
+  }
+}
+
+void sim_i2c_access(void) {
+  sim_xfr_access();
+  sim_i2c_latch();
+}
+
+static void sim_i2c_send(void) {
+  uint8_t byte = sim_i2c.txd;
+  if (sim_i2c.want_addr) {
+    sim_i2c.want_addr = false;
+    sim_i2c.addressed = (byte & 0xFE) == sim_i2c.device;
+    sim_i2c.reading = byte & 0x01;
+    sim_i2c.reg_next = !sim_i2c.reading;
+    sim_i2c.ack = sim_i2c.addressed;
+    if (!sim_i2c.addressed) {
+      sim_i2c.nacks++;
+    }
+    return;
+  }
+  sim_i2c.ack = sim_i2c.addressed && !sim_i2c.reading;
+  if (!sim_i2c.ack) {
+    return;
+  }
+  if (sim_i2c.reg_next) {
+    sim_i2c.reg_next = false;
+    sim_i2c.reg = byte;
+  }
+  if (sim_i2c.log_len < SIM_I2C_LOG_SIZE) {
+    sim_i2c.log[sim_i2c.log_len] = byte;
+  }
+  sim_i2c.log_len++;
+}
+
+// The bus side of a master command that has taken its clocks
+static void sim_i2c_complete(uint8_t cmd) {
+  if (cmd == SIM_I2C_CMD_START || cmd == SIM_I2C_CMD_START_SEND_RXACK) {
+    sim_i2c.want_addr = true;
+  }
+  if (cmd == SIM_I2C_CMD_SEND || cmd == SIM_I2C_CMD_START_SEND_RXACK ||
+      cmd == SIM_I2C_CMD_SEND_RXACK) {
+    sim_i2c_send();
+  }
+  if (cmd == SIM_I2C_CMD_RXACK || cmd == SIM_I2C_CMD_START_SEND_RXACK ||
+      cmd == SIM_I2C_CMD_SEND_RXACK) {
+    sim_i2c.msst = (sim_i2c.msst & ~SIM_I2C_MSACKI) | (sim_i2c.ack ? 0 : SIM_I2C_MSACKI);
+  }
+  if (cmd == SIM_I2C_CMD_RECV || cmd == SIM_I2C_CMD_RECV_TXACK0 || cmd == SIM_I2C_CMD_RECV_NACK) {
+    sim_i2c.rxd = (sim_i2c.addressed && sim_i2c.reading) ? sim_i2c.regs[sim_i2c.reg++] : 0xFF;
+  }
+  if (cmd == SIM_I2C_CMD_STOP) {
+    if (sim_i2c.addressed) {
+      sim_i2c.transfers++;
+    }
+    sim_i2c.addressed = false;
+  }
+}
+
+// A command is on the bus, the device lets it complete, and it ends before
+// the next Timer2 interrupt and (while Timer0 runs) the next Timer0 tick
+static bool sim_i2c_due(void) {
+  sim_i2c_latch();
+  if (!(sim_i2c.cmd && !sim_i2c.stuck && sim_cpu.ea &&
+        (sim_i2c.mscr & SIM_I2C_EMSI) && I2C_Routine)) {
+    return false;
+  }
+  if (sim_timer2_due() && s_next_t2_us < sim_i2c.done_us) {
+    return false;
+  }
+  if (!s_booted || !(sim_cpu.et0 && sim_cpu.tr0)) {
+    return true;
+  }
+  return sim_i2c.done_us <= s_next_tick_us;
+}
+
+// Complete due commands, and run I2C_Routine() at the end of each one
+static void sim_i2c_service(void) {
+  while (sim_i2c_due()) {
+    uint8_t cmd = sim_i2c.cmd;
+    if (sim.time_us < sim_i2c.done_us) {
+      sim.time_us = sim_i2c.done_us;
+    }
+    sim_i2c.cmd = 0;
+    sim_i2c_complete(cmd);
+    sim_i2c.msst |= SIM_I2C_MSIF;
+    sim_i2c.irqs++;
+    s_irq_clocks += SIM_RUN_CLOCKS_PER_IRQ;
+    sim_cpu.in_isr = 1;
+    I2C_Routine();
+    sim_pins_sync();
+    sim_cpu.in_isr = 0;
+  }
+}
+
+// +---------------------------------------------------------------+
+// | PCA                                                           |
+// +---------------------------------------------------------------+
+// Counts per PWM period at the channel's PCA_PWM_Bitwidth_t
+double sim_pca_full_scale(uint8_t channel) {
+  static const double counts[4] = {256.0, 128.0, 64.0, 1024.0}; // 8, 7, 6, 10
+  return counts[sim_pca.bit_width[channel] & 0x03];
+}
+
+void sim_pca_set_compare(uint8_t channel, uint16_t value) {
+  sim_pca.ccap[channel] = value;
+  sim_pca.updates++;
+}
+
+// +---------------------------------------------------------------+
+// | IAP / EEPROM                                                  |
+// +---------------------------------------------------------------+
+void sim_iap_cmd(sim_iap_cmd_t cmd, uint16_t addr) {
+  if (!sim_iap.enabled || addr >= SIM_EEPROM_SIZE) {
+    sim_iap.cmd_failed = 1;
+    return;
+  }
+
+  switch (cmd) {
+  case SIM_IAP_CMD_READ:
+    sim_iap.data = sim_iap.eeprom[addr];
+    sim_iap.reads++;
+    break;
+  case SIM_IAP_CMD_WRITE:
+    sim_iap.eeprom[addr] &= sim_iap.data; // programming can only clear bits
+    sim_iap.writes++;
+    if (sim_cpu.in_isr) {
+      sim_iap.isr_writes++;
+    }
+    sim.time_us += SIM_IAP_WRITE_US;
+    break;
+  case SIM_IAP_CMD_ERASE:
+    memset(&sim_iap.eeprom[addr & ~(SIM_EEPROM_SECTOR_SIZE - 1)], 0xFF,
+           SIM_EEPROM_SECTOR_SIZE);
+    sim_iap.erases[addr / SIM_EEPROM_SECTOR_SIZE]++;
+    if (sim_cpu.in_isr) {
+      sim_iap.isr_erases++;
+    }
+    sim.time_us += SIM_IAP_ERASE_US;
+    break;
+  }
+}
+
+// +---------------------------------------------------------------+
+// | UART                                                          |
+// +---------------------------------------------------------------+
+void sim_uart_tx_char(char ch) { fputc(ch, stderr); }
+
+void sim_uart_tx_hex(uint8_t hex) { fprintf(stderr, "%02X", hex); }
+
+void sim_uart_tx_string(const char *str) { fputs(str, stderr); }
+
+// +---------------------------------------------------------------+
+// | CPU: IDLE + TIMER0 + POWER-DOWN                               |
+// +---------------------------------------------------------------+
+// Account one tick (in IDLE, or in power-down) to the energy model; run_us
+// of it with the CPU running
+static void sim_energy_account(uint32_t period_us, uint32_t run_us,
+                               bool power_down) {
+  if (power_down) {
+    sim_energy.power_down_us += period_us;
+  } else {
+    run_us = (run_us > period_us) ? period_us : run_us;
+    sim_energy.run_us += run_us;
+    sim_energy.idle_us += period_us - run_us;
+  }
+
+  // the PCA (and so the LED PWM) only runs while the clock does
+  if (sim_pca.running && !power_down) {
+    double duty = 0;
+    for (int n = 0; n < 3; n++) {
+      duty += sim_pca.ccap[n] / sim_pca_full_scale(n);
+    }
+    sim_energy.led_uaus += duty * SIM_I_LED_FULL_UA * period_us;
+  }
+}
+
+static void sim_timer0_tick(void) {
+  uint32_t period_us = 1000000UL / sim_cpu.timer0_hz;
+  uint32_t slot_us = (period_us > SIM_TICK_US) ? SIM_TICK_US : period_us;
+
+  if (s_next_tick_us < sim.time_us) {
+    s_next_tick_us = sim.time_us; // the previous tick overran its period
+  }
+  sim.time_us = s_next_tick_us;
+  s_next_tick_us += period_us;
+
+  if (sim.on_tick) {
+    sim.on_tick(sim.ticks);
+  }
+
+  uint64_t start_us = sim.time_us;
+  s_tick_start_us = start_us;
+  s_tick_start_clock = sim_lm1971.clock;
+  sim_cpu.in_isr = 1;
+  Timer0_Routine();
+  sim_pins_sync();
+  sim_cpu.in_isr = 0;
+
+  uint32_t busy_us = (uint32_t)(sim.time_us - start_us);
+  sim.isr_busy_us_total += busy_us;
+  if (busy_us > sim.isr_busy_us_max) {
+    sim.isr_busy_us_max = busy_us;
+  }
+  sim.ticks++;
+  sim_energy.wakes++;
+  uint32_t irq_us = (uint32_t)(s_irq_clocks * 1000000ULL / SIM_SYSCLOCK_HZ);
+  sim_energy_account(slot_us, busy_us + irq_us + SIM_RUN_US_PER_WAKE, false);
+  s_irq_clocks = 0;
+
+  sim_adc_service();
+  sim_i2c_service();
+}
+
+// Timer0 counts SYSCLK / 12 from the reload value, 65536 - counts per tick.
+// Inside the ISR it has counted the modelled time since the tick started:
+// delays, ADC conversion waits and IAP commands, plus one clock per LM1971
+// pin access or NOP().
+static uint32_t sim_timer0_elapsed(void) {
+  uint64_t clocks = (sim.time_us - s_tick_start_us) * SIM_SYSCLOCK_HZ / 1000000 +
+                    (sim_lm1971.clock - s_tick_start_clock);
+  return (uint32_t)(clocks / 12);
+}
+
+uint16_t sim_timer0_count(void) {
+  uint32_t period = SIM_SYSCLOCK_HZ / 12 / sim_cpu.timer0_hz;
+  return (uint16_t)(65536 - period + sim_timer0_elapsed() % period);
+}
+
+bool sim_timer0_overflow(void) {
+  return sim_timer0_elapsed() >= SIM_SYSCLOCK_HZ / 12 / sim_cpu.timer0_hz;
+}
+
+// Entering IDLE: sleep until the next interrupt (an ADC conversion or I2C
+// command in flight, Timer2, else Timer0), or hand control back to the
+// harness once the requested number of ticks has run.
+void sim_cpu_idle(void) {
+  if (sim_adc_due()) {
+    sim_adc_service();
+    return;
+  }
+  if (sim_i2c_due()) {
+    sim_i2c_service();
+    return;
+  }
+  if (sim_timer2_due()) {
+    sim_timer2_irq();
+    return;
+  }
+
+  if (!s_booted) {
+    s_booted = true;
+    sim.boot_us = sim.time_us;
+    s_next_tick_us = sim.time_us;
+  }
+
+  if (!(sim_cpu.ea && sim_cpu.et0 && sim_cpu.tr0) || sim_cpu.timer0_hz == 0) {
+    fprintf(stderr, "sim: IDLE entered with Timer0 interrupt disabled\n");
+    exit(2);
+  }
+
+  // a Timer0 period longer than a tick (power_down() slows it down with the
+  // LED lit) sleeps through the ticks before its own in IDLE
+  while (s_next_tick_us > sim.time_us + SIM_TICK_US) {
+    if (sim.ticks_remaining == 0) {
+      swapcontext(&s_firmware_ctx, &s_harness_ctx);
+    }
+    sim.ticks_remaining--;
+    if (sim.on_tick) {
+      sim.on_tick(sim.ticks);
+    }
+    sim.time_us += SIM_TICK_US;
+    sim.ticks++;
+    sim_energy_account(SIM_TICK_US, 0, false);
+  }
+
+  if (sim.ticks_remaining == 0) {
+    swapcontext(&s_firmware_ctx, &s_harness_ctx);
+  }
+  sim.ticks_remaining--;
+  sim_timer0_tick();
+}
+
+// Power-down: the clock (and Timer0, PCA, ADC conversions) stop until the
+// wake-up timer fires; a powered ADC still draws SIM_I_ADC_UA (adc_on_us).
+// Simulated time still advances in SIM_TICK_US slots, so the harness keeps
+// counting in ticks and on_tick() still sees every 10ms.
+void sim_cpu_power_down(void) {
+  if (!sim_cpu.wkt_enabled) {
+    fprintf(stderr, "sim: power-down entered with the wake-up timer disabled\n");
+    exit(2);
+  }
+  sim_cpu.power_downs++;
+
+  uint32_t period_us = SIM_TICK_US;
+  uint32_t sleep_us = (sim_cpu.wkt_count + 1UL) * SIM_WKT_COUNT_US;
+  for (uint32_t slept_us = 0; slept_us < sleep_us; slept_us += period_us) {
+    if (sim.ticks_remaining == 0) {
+      swapcontext(&s_firmware_ctx, &s_harness_ctx);
+    }
+    sim.ticks_remaining--;
+    if (sim.on_tick) {
+      sim.on_tick(sim.ticks);
+    }
+    sim.time_us += period_us;
+    sim.ticks++;
+    sim_energy_account(period_us, 0, true);
+  }
+  sim_energy.wakes++;
+  s_next_tick_us = sim.time_us;
+}
+
+double sim_energy_report(const char *label) {
+  double total_us = (double)(sim_energy.run_us + sim_energy.idle_us +
+                             sim_energy.power_down_us);
+  if (total_us == 0) {
+    return 0;
+  }
+  uint64_t adc_on_us = sim_energy.adc_on_us;
+  if (sim_adc.powered) {
+    adc_on_us += sim.time_us - sim_energy.adc_on_since_us;
+  }
+
+  double mcu_ua = (sim_energy.run_us * (double)SIM_I_RUN_UA +
+                   sim_energy.idle_us * (double)SIM_I_IDLE_UA +
+                   sim_energy.power_down_us * (double)SIM_I_PD_UA +
+                   adc_on_us * (double)SIM_I_ADC_UA) /
+                  total_us;
+  double led_ua = sim_energy.led_uaus / total_us;
+  double total_ua = mcu_ua + led_ua + SIM_I_BOARD_UA;
+
+  printf("  %s: run %.1f%% idle %.1f%% power-down %.1f%% ADC on %.1f%%, "
+         "%.1f wakes/s\n",
+         label, 100.0 * sim_energy.run_us / total_us,
+         100.0 * sim_energy.idle_us / total_us,
+         100.0 * sim_energy.power_down_us / total_us,
+         100.0 * adc_on_us / total_us, sim_energy.wakes * 1e6 / total_us);
+  printf("  %s: MCU %.0f uA + LEDs %.0f uA + board %d uA = %.2f mA => %.0f h "
+         "on a 9V alkaline\n",
+         label, mcu_ua, led_ua, SIM_I_BOARD_UA, total_ua / 1000.0,
+         SIM_BATTERY_UAH / total_ua);
+  return total_ua;
+}
+
+static void sim_firmware_entry(void) {
+  firmware_main();
+  fprintf(stderr, "sim: firmware main() returned\n");
+  exit(2);
+}
+
+// +---------------------------------------------------------------+
+// | HARNESS API                                                   |
+// +---------------------------------------------------------------+
+void sim_reset(void) {
+  uint8_t eeprom[SIM_EEPROM_SIZE];
+  uint32_t erases[SIM_EEPROM_SECTORS];
+
+  // EEPROM contents and wear survive a power cycle
+  memcpy(eeprom, sim_iap.eeprom, sizeof(eeprom));
+  memcpy(erases, sim_iap.erases, sizeof(erases));
+  memset(&sim_pins, 0, sizeof(sim_pins));
+  memset(&sim_cpu, 0, sizeof(sim_cpu));
+  memset(&sim_adc, 0, sizeof(sim_adc));
+  memset(&sim_pca, 0, sizeof(sim_pca));
+  memset(&sim_iap, 0, sizeof(sim_iap));
+  memset(&sim_lm1971, 0, sizeof(sim_lm1971));
+  memset(&sim_i2c, 0, sizeof(sim_i2c));
+  memset(&sim_energy, 0, sizeof(sim_energy));
+  memset(&sim, 0, sizeof(sim));
+  memcpy(sim_iap.eeprom, eeprom, sizeof(eeprom));
+  memcpy(sim_iap.erases, erases, sizeof(erases));
+
+  // 8051 ports reset HIGH; the switches are pulled up (not pressed)
+  memset(&sim_pins, 1, sizeof(sim_pins));
+  sim_lm1971.last_clk = 1;
+  sim_lm1971.last_load = 1;
+  sim_lm1971.last_data = 1;
+  for (int t = 0; t < SIM_LM1971_T_COUNT; t++) {
+    sim_lm1971.min_clocks[t] = UINT32_MAX;
+  }
+  sim_lm1971.atten_db = 0xFF; // unknown until the first write
+  sim_i2c.device = SIM_I2C_SSD1306;
+
+  // nothing plugged in: RVC reads full scale, audio is silent (0x80),
+  // battery is a fresh 9V cell
+  sim_adc.inputs[7] = 0xFF;
+  sim_adc.inputs[4] = 0x80;
+  sim_adc.inputs[0] = 138;
+
+  s_booted = false;
+  s_next_tick_us = 0;
+  s_next_t2_us = 0;
+  s_irq_clocks = 0;
+}
+
+void sim_erase_eeprom(void) { memset(sim_iap.eeprom, 0xFF, SIM_EEPROM_SIZE); }
+
+void sim_power_on(uint32_t ticks) {
+  if (s_firmware_stack == NULL) {
+    s_firmware_stack = malloc(SIM_FIRMWARE_STACK_SIZE);
+  }
+  getcontext(&s_firmware_ctx);
+  s_firmware_ctx.uc_stack.ss_sp = s_firmware_stack;
+  s_firmware_ctx.uc_stack.ss_size = SIM_FIRMWARE_STACK_SIZE;
+  s_firmware_ctx.uc_link = NULL;
+  makecontext(&s_firmware_ctx, sim_firmware_entry, 0);
+
+  sim.ticks_remaining = ticks;
+  swapcontext(&s_harness_ctx, &s_firmware_ctx);
+}
+
+void sim_run(uint32_t ticks) {
+  sim.ticks_remaining = ticks;
+  swapcontext(&s_harness_ctx, &s_firmware_ctx);
+}
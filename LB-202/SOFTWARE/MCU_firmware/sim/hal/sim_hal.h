@@ -0,0 +1,296 @@
+// +-----------------------------------------------+
+// | HOST SHIM: in-memory models of STC8G1K08      |
+// |            peripherals used by LB-202         |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+
+#ifndef __SIM_HAL_H__
+#define __SIM_HAL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SIM_EEPROM_SIZE 4096
+#define SIM_EEPROM_SECTOR_SIZE 512
+#define SIM_EEPROM_SECTORS (SIM_EEPROM_SIZE / SIM_EEPROM_SECTOR_SIZE)
+#define SIM_ADC_CHANNELS 16
+
+// __CONF_FOSC / __CONF_CLKDIV, as set in the Makefile (FW_FLAGS)
+#define SIM_SYSCLOCK_HZ                                                        \
+  (__CONF_FOSC / ((__CONF_CLKDIV == 0) ? 1 : __CONF_CLKDIV))
+
+// Timing of slow peripheral operations (STC8G datasheet, typical values)
+#define SIM_IAP_WRITE_US 7     // byte program: 6.1-7.6us
+#define SIM_IAP_ERASE_US 5000  // sector erase: 4-6ms
+#define SIM_IAP_ENDURANCE_CYCLES 100000 // erase cycles per sector (datasheet min)
+#define SIM_ADC_CONV_CLOCKS 24 // (switch+1)+(hold+1)+(sample+1)+10 at reset ADCTIM
+#define SIM_WKT_COUNT_US 500   // power-down wake-up timer: 32KHz / 16
+#define SIM_ADC_SETTLE_US 10000 // ADC power-on to a trusted conversion: the
+                                // one tick the 100Hz loop gives it
+#define SIM_TICK_US 10000 // the harness's tick: one 100Hz Timer0 period
+
+// Energy model (9V supply current, typical values).  The MCU currents are
+// STC8G datasheet figures scaled to 4.375MHz; SIM_I_BOARD_UA (LM1971, op-amps,
+// regulator) is set so that `ladybug_sim replay` of the default (IDLE-only)
+// firmware matches the README's ~90 hours on a 9V alkaline.
+#define SIM_I_RUN_UA 1800       // CPU running
+#define SIM_I_IDLE_UA 900       // IDLE (clock and peripherals running)
+#define SIM_I_PD_UA 3           // power-down, wake-up timer running
+#define SIM_I_ADC_UA 500        // ADC powered (extra)
+#define SIM_I_LED_FULL_UA 10000 // one LED at 100% PWM duty
+#define SIM_I_BOARD_UA 2900     // everything that is not the MCU or the LEDs
+#define SIM_RUN_US_PER_WAKE 150 // CPU time per wake-up not spent in modelled delays
+#define SIM_RUN_CLOCKS_PER_IRQ 90 // CPU time per Timer2 or ADC interrupt
+#define SIM_BATTERY_UAH 550000  // 9V alkaline
+
+// PORT PINS -------------------------------------
+typedef struct {
+  uint8_t p10, p11, p12, p13, p14, p15, p16, p17;
+  uint8_t p30, p31, p32, p33, p34, p35, p36, p37;
+} sim_pins_t;
+
+// CPU / TIMER0 -----------------------------------
+typedef struct {
+  uint8_t pcon;
+  uint8_t ea;  // global interrupt enable
+  uint32_t ea_offs; // EXTI_Global_SetIntState(OFF) calls (masked sections)
+  uint8_t et0; // Timer0 interrupt enable
+  uint8_t eadc; // ADC interrupt enable
+  uint8_t tr0; // Timer0 run
+  uint16_t timer0_hz;
+  uint8_t et2; // Timer2 interrupt enable
+  uint8_t tr2; // Timer2 run
+  uint16_t timer2_hz;
+  uint32_t timer2_irqs; // VU_Routine() calls
+  uint8_t in_isr;
+  uint8_t wkt_enabled;    // power-down wake-up timer
+  uint16_t wkt_count;     // wakes after (wkt_count + 1) * SIM_WKT_COUNT_US
+  uint32_t power_downs;   // number of power-down entries
+  // the extended SFRs behind EAXFR, and open-drain pins
+  uint8_t p_sw2;          // bit 7 = EAXFR (SFRX_ON), bits 5-4 = I2C pins
+  uint8_t od_pins[6];     // per GPIO port: pins in GPIO_Mode_InOut_OD
+  uint32_t xfr_errors;    // extended SFR access without EAXFR
+} sim_cpu_t;
+
+// ADC ------------------------------------------
+// inputs[] is the 8-bit value presented to each channel (left-aligned result),
+// unless source[] has a waveform for it, sampled at the start of a conversion
+typedef uint8_t (*sim_adc_source_fn)(uint64_t time_us);
+
+typedef struct {
+  uint8_t powered;
+  uint64_t powered_us; // when power last went ON
+  uint8_t channel;
+  uint8_t prescaler;
+  uint8_t align_right;
+  uint8_t flag;
+  uint8_t pending; // conversion started with the ADC interrupt enabled
+  uint64_t start_us; // ... when it started (and sampled its input)
+  uint8_t res;
+  uint8_t inputs[SIM_ADC_CHANNELS];
+  sim_adc_source_fn source[SIM_ADC_CHANNELS];
+  uint32_t conversions[SIM_ADC_CHANNELS];
+  uint32_t unpowered_conversions; // conversions started with ADC power OFF
+  uint32_t unsettled_conversions; // ... within SIM_ADC_SETTLE_US of power-on
+  uint32_t interrupts;            // ADC_Routine() calls
+} sim_adc_t;
+
+// PCA / RGB LED --------------------------------
+// ccap[0] = BLUE (CCP0), ccap[1] = GREEN (CCP1), ccap[2] = RED (CCP2), as
+// compare values at bit_width[n] (0 to sim_pca_full_scale(n) - 1)
+typedef struct {
+  uint8_t running;
+  uint8_t stop_in_idle;
+  uint8_t clock_source;
+  uint8_t port;
+  uint8_t mode[3];
+  uint8_t bit_width[3];
+  uint16_t ccap[3];
+  uint32_t updates;
+} sim_pca_t;
+
+// IAP / EEPROM ---------------------------------
+typedef enum {
+  SIM_IAP_CMD_READ = 1,
+  SIM_IAP_CMD_WRITE = 2,
+  SIM_IAP_CMD_ERASE = 3,
+} sim_iap_cmd_t;
+
+typedef struct {
+  uint8_t tps;
+  uint8_t enabled;
+  uint8_t data;
+  uint8_t cmd_failed;
+  uint8_t eeprom[SIM_EEPROM_SIZE];
+  uint32_t reads;
+  uint32_t writes;
+  uint32_t erases[SIM_EEPROM_SECTORS];
+  uint32_t isr_writes; // byte writes issued from inside an ISR
+  uint32_t isr_erases; // sector erases issued from inside an ISR
+} sim_iap_t;
+
+// LM1971 ATTENUATOR ----------------------------
+// Serial timing from the datasheet (ns), checked on every frame
+typedef enum {
+  SIM_LM1971_T_LOAD_CLK = 0, // LOAD LOW to CLOCK HIGH
+  SIM_LM1971_T_DATA_SETUP,   // DATA VALID to CLOCK HIGH
+  SIM_LM1971_T_DATA_HOLD,    // CLOCK HIGH to DATA change
+  SIM_LM1971_T_CLK_LOAD,     // CLOCK HIGH to LOAD HIGH
+  SIM_LM1971_T_COUNT
+} sim_lm1971_timing_t;
+extern const uint32_t sim_lm1971_min_ns[SIM_LM1971_T_COUNT];
+extern const char *const sim_lm1971_names[SIM_LM1971_T_COUNT];
+
+// Decoded from the VOL_CLK (P3.2), VOL_DATA (P3.3), VOL_LOAD (P3.4) pins
+typedef struct {
+  uint16_t shift;    // bits clocked in while LOAD is low
+  uint8_t bits;      // number of bits clocked in
+  uint8_t atten_db;  // latched attenuation (>= 64 = MUTE)
+  uint32_t writes;   // number of LOAD rising edges with 16 valid bits
+  uint32_t errors;   // LOAD rising edges with a bad frame
+  uint8_t last_clk, last_load, last_data;
+
+  // Timing, in SYSCLK clocks: one per pin access, one per NOP().  The minimum
+  // spacing seen for each SIM_LM1971_T_* constraint, and the number of times
+  // it was shorter than the spec.
+  uint64_t clock;       // clocks since power-on
+  uint64_t last_access; // clock of the previous pin access
+  uint64_t load_fall_at, clk_rise_at, data_at;
+  uint8_t clk_rise_in_frame;
+  uint32_t min_clocks[SIM_LM1971_T_COUNT];
+  uint32_t timing_errors[SIM_LM1971_T_COUNT];
+  uint32_t order_errors;  // LOAD fell while CLK was high
+  uint32_t frame_clocks;  // LOAD falling to LOAD rising, last frame
+} sim_lm1971_t;
+
+// I2C MASTER + ONE DEVICE ----------------------
+// The I2C master registers, and the device at `device` (8-bit address, the
+// SSD1306 unless a scenario changes it): it ACKs its address and every byte,
+// logs what is written to it after the address, and answers reads from
+// regs[], starting at the first byte written after its address.  With
+// `stuck` set, the device holds SCL low: no command ever completes.  Access
+// without EAXFR counts in sim_cpu.xfr_errors.
+#define SIM_I2C_LOG_SIZE 1024
+
+typedef struct {
+  uint8_t cfg, mscr, msst, txd, rxd; // I2CCFG, I2CMSCR, I2CMSST, I2CTXD, I2CRXD
+  uint8_t cmd;         // command on the bus (0 = none)
+  uint64_t done_us;    // ...and when it completes
+  uint8_t device;
+  bool stuck;
+  bool want_addr;      // the next byte sent is an address (after a START)
+  bool addressed;      // the device ACKed the address of this transfer
+  bool reading;        // ...with R/W = 1
+  bool reg_next;       // the next byte written sets reg
+  bool ack;            // ACK of the last byte sent
+  uint8_t reg;         // read pointer into regs[]
+  uint8_t regs[256];
+  uint8_t log[SIM_I2C_LOG_SIZE]; // bytes written to the device
+  uint32_t log_len;    // (log[] keeps the first SIM_I2C_LOG_SIZE)
+  uint32_t transfers;  // STOPs after the device ACKed its address
+  uint32_t nacks;      // addresses nobody ACKed
+  uint32_t resets;     // ENI2C turned off with a command on the bus
+  uint32_t irqs;       // I2C_Routine() calls
+  uint64_t busy_us;    // bus time of all commands
+} sim_i2c_t;
+
+// ENERGY MODEL ---------------------------------
+// Time spent in each state, and LED charge (uA * us), since power-on
+typedef struct {
+  uint64_t run_us;
+  uint64_t idle_us;
+  uint64_t power_down_us;
+  uint64_t adc_on_us;
+  uint64_t adc_on_since_us;
+  double led_uaus;
+  uint32_t wakes; // Timer0 ticks and wake-up timer wakes
+} sim_energy_t;
+
+// SIMULATION STATE -----------------------------
+typedef void (*sim_tick_fn)(uint32_t tick);
+typedef void (*sim_atten_fn)(uint8_t atten_db);
+
+typedef struct {
+  uint64_t time_us;         // simulated time since power-on
+  uint32_t ticks;           // SIM_TICK_US slots so far (Timer0 ticks at 100Hz)
+  uint32_t ticks_remaining; // sim_cpu_idle() exits the firmware at 0
+  sim_tick_fn on_tick;      // called before each Timer0 tick (scenario input)
+  sim_atten_fn on_atten;    // called when the LM1971 latches a new value
+  uint32_t isr_busy_us_max; // longest modelled blocking time inside one ISR
+  uint64_t isr_busy_us_total;
+  uint64_t boot_us;         // time from power-on to first IDLE
+} sim_state_t;
+
+extern sim_pins_t sim_pins;
+extern sim_cpu_t sim_cpu;
+extern sim_adc_t sim_adc;
+extern sim_pca_t sim_pca;
+extern sim_iap_t sim_iap;
+extern sim_lm1971_t sim_lm1971;
+extern sim_i2c_t sim_i2c;
+extern sim_energy_t sim_energy;
+extern sim_state_t sim;
+
+// Called by the fw_hal.h shim
+void sim_pins_sync(void);
+void sim_xfr_access(void);
+void sim_i2c_access(void);
+uint16_t sim_timer0_count(void);
+bool sim_timer0_overflow(void);
+void sim_nop(void);
+void sim_cpu_idle(void);
+void sim_cpu_power_down(void);
+void sim_adc_set_power(uint8_t state);
+void sim_timer0_set_run(uint8_t state);
+void sim_timer2_set_run(uint8_t state);
+void sim_sys_set_clock(void);
+void sim_delay_us(uint32_t us);
+void sim_gpio_set_mode(uint8_t port, uint8_t pins, uint8_t mode);
+
+void sim_gpio_set_pullup(uint8_t port, uint8_t pins, uint8_t state);
+void sim_adc_start(void);
+void sim_pca_set_compare(uint8_t channel, uint16_t value);
+double sim_pca_full_scale(uint8_t channel);
+void sim_iap_cmd(sim_iap_cmd_t cmd, uint16_t addr);
+void sim_uart_tx_char(char ch);
+void sim_uart_tx_hex(uint8_t hex);
+void sim_uart_tx_string(const char *str);
+
+// Harness API
+void sim_reset(void);       // power-on reset of everything except EEPROM
+void sim_erase_eeprom(void); // factory-blank EEPROM (all 0xFF)
+
+/**
+ * @brief Powers on the firmware and runs it for the given number of Timer0 ticks.
+ *
+ * Calls the firmware's main() (renamed firmware_main() by the sim Makefile).
+ * Every time main() enters IDLE, one Timer0 tick is delivered; once
+ * `ticks` ticks have run, control returns here.  Firmware globals are NOT
+ * re-initialized, so each scenario should run in its own process.
+ */
+void sim_power_on(uint32_t ticks);
+
+/**
+ * @brief Continues a running firmware image for another `ticks` ticks.
+ */
+void sim_run(uint32_t ticks);
+
+/**
+ * @brief Prints the energy model since power-on, and returns the average
+ *        board supply current in uA.
+ */
+double sim_energy_report(const char *label);
+
+/**
+ * @brief Length of one ADC conversion at the current prescaler, in us.
+ */
+uint32_t sim_adc_conv_us(void);
+
+/**
+ * @brief SYSCLK clocks to nanoseconds, at the configured __CONF_CLKDIV.
+ */
+uint32_t sim_lm1971_clocks_to_ns(uint64_t clocks);
+
+#endif // __SIM_HAL_H__
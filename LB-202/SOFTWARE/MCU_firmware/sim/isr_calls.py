@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+"""
+Static check of what the LB-202 interrupt handlers call.
+
+SDCC compiles every function non-reentrant: its locals and parameters live at
+fixed addresses (overlaid between functions that never call each other), so a
+function that an ISR can reach must never be running in main() at the same
+time.  The ISRs also share one register bank (ISR_USING in globals.h), which only
+works if the bank-switched helpers are called from nowhere else.
+
+The firmware is compiled on the host with gcc -fcallgraph-info (with the same
+defines as a sim variant) and the call graphs of all its sources are merged.
+Calls into the sim HAL (hal/) stand for FwLib_STC8 register macros and are
+ignored.  The SDCC library helpers that 16 and 32-bit multiplies, divides and
+modulos compile to (_mulint, _divulong, _mullong, ...) are added as calls,
+from gcc's SSA dump with uint32_t / int32_t made a type of their own: they
+are just as non-reentrant, and are bank 0 code.  The check fails if:
+
+  - an ISR can reach a call through a function pointer: SDCC then has to save
+    every register bank, and the callee is invisible to this check
+  - an ISR_USING function is reachable from main(), or calls a function that
+    is not ISR_USING
+  - a function reachable from both an ISR and main() is not in SHARED below
+    (each entry says why the two can never overlap), or SHARED lists a
+    function that is no longer shared in any checked variant
+
+Usage:
+    sim/isr_calls.py [-D DEFINE ...]            check one variant
+    sim/isr_calls.py --variant "FLAGS" ... --stale
+        check several variants (compiler flags, e.g. "-DINCLUDE_POWER_DOWN"),
+        and that every SHARED entry is still shared in one of them
+"""
+
+import argparse
+import glob
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FW_DIR = os.path.abspath(os.path.join(HERE, ".."))
+SRCS = ["main.c", "preferences.c", "i2c_queue.c", "ssd1306.c"]
+
+CC_FLAGS = [
+    "-std=gnu11",
+    "-O0",  # no inlining: every call in the source is an edge
+    "-fcallgraph-info",
+    "-D__CONF_MCU_MODEL=MCU_MODEL_STC8G1K08",
+    "-D__CONF_FOSC=17500000UL",
+    "-D__CONF_CLKDIV=0x04",
+    "-DSTC8G1K08A",
+    "-Dmain=firmware_main",
+    "-I" + os.path.join(HERE, "hal"),
+    "-I" + os.path.join(FW_DIR, "include"),
+    "-fdump-tree-ssa",
+]
+
+# SDCC's 32-bit types as a host type nothing else uses (sizetype is long), so
+# that their arithmetic can be told apart in the .ssa dumps
+INT32_SHIM = """#include <stdint.h>
+#define uint32_t unsigned long long
+#define int32_t long long
+"""
+
+MAIN = "firmware_main"
+INDIRECT = "__indirect_call"
+
+# Functions both main() and an ISR may call, and why they never overlap.
+# BOOT: main() calls it before Timer0 starts.  POWER_DOWN: power_down() calls
+# it with the Timer0 interrupt OFF, or with slow_tick set, when
+# Timer0_Routine() returns at once.  ADC_Routine() calls none of these.
+BOOT = "main() before Timer0 starts"
+POWER_DOWN = "power_down() with the Timer0 interrupt OFF or slow_tick set"
+SHARED = {
+    "adc_seq_start": BOOT + ", " + POWER_DOWN,
+    "adc_seq_next": "adc_seq_start() only",
+    "setAttenuation": "init_RVC() and handle_RVC(), " + BOOT,
+    "handle_RVC": BOOT + ", " + POWER_DOWN,
+    "auto_atten_res": "handle_RVC() only",
+    "led_seq_start": "led_override_start() only",
+    "led_override_start": "welcome_to_ladybug(), " + BOOT,
+    "handle_battmon": POWER_DOWN,
+    "handle_leds": POWER_DOWN,
+    "led_is_static": POWER_DOWN,
+    "led_seq_tick": "handle_leds() only",
+    "pulsing_red": "handle_battmon() and handle_leds() only",
+    "set_rgb": POWER_DOWN,
+    "vu_meter_ballistics": "handle_leds() only",
+}
+
+
+# SDCC library helpers behind C arithmetic on 16 and 32-bit operands (8 x 8
+# multiplies, with a 16-bit result too, and 8-bit divides are MUL AB / DIV AB
+# in line, and a power of two is a shift).  They are compiled for bank 0 and
+# are not reentrant either (their second operand lives at a fixed address),
+# so they are checked like any other function.  Keyed by (operator, signed,
+# bits) of the operation's type.
+HELPERS = {
+    ("*", False, 16): "_mulint", ("*", True, 16): "_mulint",
+    ("/", False, 16): "_divuint", ("/", True, 16): "_divsint",
+    ("%", False, 16): "_moduint", ("%", True, 16): "_modsint",
+    ("*", False, 32): "_mullong", ("*", True, 32): "_mullong",
+    ("/", False, 32): "_divulong", ("/", True, 32): "_divslong",
+    ("%", False, 32): "_modulong", ("%", True, 32): "_modslong",
+}
+
+
+def compile_graph(flags, out):
+    shim = os.path.join(out, "int32_shim.h")
+    with open(shim, "w") as f:
+        f.write(INT32_SHIM)
+    for src in SRCS:
+        subprocess.run(
+            ["gcc"] + CC_FLAGS + ["-include", shim] + flags
+            + ["-c", os.path.join(FW_DIR, "src", src), "-o", os.path.join(out, src[:-2] + ".o")],
+            cwd=out, check=True)
+    calls = read_graph(out)
+    for f, helpers in read_helpers(out).items():
+        calls.setdefault(f, set()).update(helpers)
+        for h in helpers:
+            calls.setdefault(h, set())
+    return calls
+
+
+def read_graph(out):
+    """Caller -> callees, from the .ci files in out, without the sim HAL."""
+    calls, hal = {}, set()
+    for ci in glob.glob(os.path.join(out, "*.ci")):
+        with open(ci) as f:
+            for line in f:
+                m = re.match(r'node: \{ title: "(\w+)" label: "\w+\\n([^:"]*)', line)
+                if m:
+                    calls.setdefault(m.group(1), set())
+                    if os.path.sep + "hal" + os.path.sep in m.group(2):
+                        hal.add(m.group(1))
+                    continue
+                m = re.match(r'edge: \{ sourcename: "(\w+)" targetname: "(\w+)"', line)
+                if m:
+                    calls.setdefault(m.group(1), set()).add(m.group(2))
+    for f in hal:
+        calls.pop(f, None)
+    return {f: callees - hal for f, callees in calls.items()}
+
+
+def helper_type(ctype):
+    """(signed, bits) of an integer SSA type in SDCC terms, or None."""
+    if "long long" in ctype:
+        bits = 32  # uint32_t / int32_t, see CC_FLAGS
+    elif re.search(r"\b(short|int)\b", ctype) and "long" not in ctype:
+        bits = 16  # host int is SDCC's int after promotion
+    else:
+        return None  # char (inline), sizetype (pointer arithmetic), ...
+    return "unsigned" not in ctype, bits
+
+
+def read_helpers(out):
+    """Function -> SDCC arithmetic helpers it calls, from the .ssa dumps."""
+    helpers = {}
+    for dump in glob.glob(os.path.join(out, "*.ssa")):
+        fn, types, casts = None, {}, {}
+
+        def is_byte(op):
+            """A char, a char widened by a cast, or a constant below 256."""
+            if re.match(r"^-?\d+$", op):
+                return -128 <= int(op) < 256
+            ctype = types.get(op, types.get(re.sub(r"_\d+$", "", op), ""))
+            return (re.search(r"\bu?int8_t\b|\bchar\b", ctype) is not None
+                    or (op in casts and is_byte(casts[op])))
+
+        with open(dump) as f:
+            for line in f:
+                m = re.match(r"^;; Function (\w+) ", line)
+                if m:
+                    fn, types, casts = m.group(1), {}, {}
+                    continue
+                m = re.match(r"^  ([\w ]+?) \*?([\w.]+);$", line)
+                if m:
+                    types[m.group(2)] = m.group(1)
+                    continue
+                m = re.match(r"^  ([\w.]+) = \([\w ]+\) ([\w.-]+);$", line)
+                if m:
+                    casts[m.group(1)] = m.group(2)
+                    continue
+                m = re.match(r"^  ([\w.]+) = ([\w.-]+) ([*/%]) ([\w.-]+);$", line)
+                if not (m and fn and m.group(1) in types):
+                    continue
+                kind = helper_type(types[m.group(1)])
+                op, a, b = m.group(3), m.group(2), m.group(4)
+                if kind is None or (op == "*" and is_byte(a) and is_byte(b)):
+                    continue
+                if b.isdigit() and int(b) & (int(b) - 1) == 0:
+                    continue  # a shift (or a mask)
+                helpers.setdefault(fn, set()).add(HELPERS[(op,) + kind])
+    return helpers
+
+
+def source_functions(pattern):
+    """Names matched by pattern's first group in the firmware sources."""
+    names = set()
+    for src in SRCS:
+        with open(os.path.join(FW_DIR, "src", src)) as f:
+            names |= set(re.findall(pattern, f.read(), re.MULTILINE))
+    return names
+
+
+def reachable(calls, roots):
+    seen, todo = set(), list(roots)
+    while todo:
+        f = todo.pop()
+        if f not in seen:
+            seen.add(f)
+            todo.extend(calls.get(f, ()))
+    return seen
+
+
+def check(flags):
+    with tempfile.TemporaryDirectory() as out:
+        calls = compile_graph(flags, out)
+
+    isrs = source_functions(r"^INTERRUPT(?:_USING)?\((\w+),") & set(calls)
+    banked = source_functions(r"^\w[\w ]*?\b(\w+)\([^;{]*\)\s*ISR_USING\s*\{") & set(calls)
+    from_main = reachable(calls, [MAIN])
+    errors, shared = [], set()
+
+    for isr in sorted(isrs):
+        tree = reachable(calls, [isr])
+        if INDIRECT in tree:
+            errors.append("%s reaches a call through a function pointer" % isr)
+        for f in sorted(tree & from_main - {INDIRECT}):
+            shared.add(f)
+            if f not in SHARED:
+                errors.append("%s is reachable from both %s and main()" % (f, isr))
+
+    for f in sorted(banked):
+        if f in from_main:
+            errors.append("%s is ISR_USING but reachable from main()" % f)
+        for callee in sorted(calls[f] - banked):
+            errors.append("%s is ISR_USING but calls %s, which is not" % (f, callee))
+    return errors, shared
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("-D", dest="defines", action="append", default=[],
+                    help="firmware define, e.g. -D INCLUDE_POWER_DOWN")
+    ap.add_argument("--variant", action="append", default=[], metavar="FLAGS",
+                    help="check this variant's compiler flags instead, repeatable")
+    ap.add_argument("--stale", action="store_true", help="fail on SHARED entries nothing uses")
+    args = ap.parse_args()
+
+    variants = [v.split() for v in args.variant] or [["-D" + d for d in args.defines]]
+    failed, used = False, set()
+    for flags in variants:
+        errors, shared = check(flags)
+        used |= shared
+        for e in errors:
+            print("isr_calls [%s]: %s" % (" ".join(flags) or "default", e))
+        failed |= bool(errors)
+
+    if args.stale:
+        for f in sorted(set(SHARED) - used):
+            print("isr_calls: SHARED lists %s, but no ISR shares it with main()" % f)
+            failed = True
+    if not failed:
+        print("isr_calls: %d variant(s) OK, %d function(s) shared with main()" % (len(variants), len(used)))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,2219 @@
+// +-----------------------------------------------+
+// | HOST SIMULATION: LB-202 firmware scenarios    |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// Runs the unmodified LB-202 firmware (src/main.c + src/preferences.c) against
+// the in-memory peripheral models in hal/sim_hal.c.  The firmware is treated
+// as a black box: scenarios drive the ADC inputs and switch pins, and check
+// the LM1971 attenuation, RGB LED PWM values and EEPROM contents.
+//
+// Each scenario runs in its own forked process, so firmware globals always
+// start from their power-on values.
+//
+// Usage:
+//   ladybug_sim                 run all scenarios (make check)
+//   ladybug_sim <scenario>      run one scenario
+//   ladybug_sim replay <hours>  replay a gig of the given length, report speed
+//   ladybug_sim energy          estimate current draw and battery life
+//   ladybug_sim pref_bench      Pref_Read() cost vs. the old backwards scan
+//   ladybug_sim endurance       EEPROM lifetime in switch presses
+//   ladybug_sim limiter_wav <file.wav> [gain]
+//                               limiter latencies on a recording
+//                               (INCLUDE_LIMITER builds)
+//   ladybug_sim howl_bench [file.wav ...]
+//                               howl detection latency and false positives
+//                               (INCLUDE_HOWL_DETECTOR builds)
+//   ladybug_sim loudness_wav <file.wav> [file.wav ...]
+//                               loudness trim over a set of recordings
+//                               (INCLUDE_LOUDNESS_TRIM builds)
+
+#include "globals.h" // FW_MAJOR/MINOR/PATCH, VERSION_DISPLAY_TIMING_SCALE
+#include "preferences.h"
+#include "led_gamma.h"
+#include "rvc_tables.h"
+#include "vu_colors.h"
+#include "audio.h"
+#include "sim_hal.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TICKS_PER_SECOND 100
+#define RVC_TICKS 5
+#define LEDS_PHASE 2 // src/main.c SCHED_PHASE_LEDS: handle_leds() tick of RVC_TICKS
+#define PREFS_COMMIT_TICKS (3 * TICKS_PER_SECOND + 10) // quiet period + debounce
+
+#define ADC_BATTMON 0
+#define ADC_OUTMON 4
+#define ADC_RVC 7
+
+// ATTEN_SLEW_DB_PER_MS 0.4 at 100Hz
+#define ATTEN_SLEW_STEPS_PER_TICK 4
+#define ATTEN_ZC_WINDOW 2 // +/- counts around 0x80 that are a zero crossing
+#define ATTEN_ZC_ADC_PRESCALER 7 // ADC clock while watching for a crossing
+// Total ISR load (modelled CPU run time) of any tick while slewing.  Back to
+// back zero-crossing conversions were one ADC interrupt per 96 SYSCLKs (~90%)
+#define ATTEN_ZC_LOAD_MAX 0.25
+#define ATTEN_ZC_VU_LOAD_MAX 0.45 // with VU sampling (Timer2) running as well
+#define VU_SAMPLE_HZ 4000 // Timer2 OUTMON sample rate in VU meter mode
+
+#ifdef INCLUDE_LIMITER
+// src/main.c LIMITER_* settings
+#define LIMITER_THRESHOLD 115
+#define LIMITER_MAX_DB 12
+#define LIMITER_HOLD_MS 200
+#define LIMITER_RELEASE_MS_PER_DB 50
+#endif
+
+#ifdef INCLUDE_HOWL_DETECTOR
+// src/main.c HOWL_* settings
+#define HOWL_MAX_DB 15
+#define HOWL_HOLD_MS 2000
+#define HOWL_RELEASE_MS_PER_DB 500
+#endif
+
+#ifdef INCLUDE_LOUDNESS_TRIM
+// src/main.c LOUDNESS_* settings
+#define LOUDNESS_TARGET_DBFS 18
+#define LOUDNESS_TRIM_MAX_DB 6
+#endif
+
+// src/main.c VU meter results (true peak and RMS of the last 50ms), and
+// what the LED shows (8.8 fixed point, after the ballistics)
+extern uint8_t abs_out_res;
+extern uint8_t vu_rms;
+extern uint16_t vu_display_val_fixed;
+extern volatile uint8_t timer_ticks;
+extern volatile bool vu_sampling; // src/main.c: Timer2 running
+#ifdef INCLUDE_POWER_DOWN
+// src/main.c led_mode (led_mode_t, an unsigned int enum to gcc).  No mode in
+// the SW1 cycle leaves the LED OFF, which power-down needs; handle_leds()'s
+// default case does.  power_down() does not watch led_mode (only a switch
+// changes it), so a scenario wakes it with the knob before changing it.
+extern volatile unsigned int led_mode;
+#define LED_MODE_OFF 0x7F
+extern volatile bool slow_tick; // src/main.c: power_down() in IDLE, LED lit
+#endif
+
+// src/main.c Timer0 task table, and (INCLUDE_SCHED_STATS) what it measured
+typedef struct {
+  void (*run)(void);
+  uint8_t period;
+  uint8_t phase;
+} sched_task_t;
+extern const sched_task_t sched_tasks[];
+extern const uint8_t sched_task_count;
+void task_adc_power(void);
+void task_adc_start(void);
+void task_rvc(void);
+void task_vu_meter(void);
+void handle_leds(void);
+void handle_battmon(void);
+#ifdef INCLUDE_SCHED_STATS
+typedef struct {
+  uint32_t runs;
+  uint32_t total_cost; // Timer0 counts (12 SYSCLK clocks)
+  uint16_t max_cost;
+  uint16_t overruns;
+} sched_stats_t;
+extern sched_stats_t sched_stats[];
+#endif
+
+// src/main.c LED color (perceptual levels, before led_gamma_table[])
+void set_rgb(uint8_t r, uint8_t g, uint8_t b);
+
+#define LED_BLUE 0
+#define LED_GREEN 1
+#define LED_RED 2
+
+// src/main.c LED colors as 10-bit PCA duty (led_gamma_table[] of the level)
+#define DUTY_RED 291    // LED_RED_CALIBRATION (and the low battery pulse peak)
+#define DUTY_GREEN 191  // LED_GREEN_CALIBRATION
+#define DUTY_BLUE 1023  // LED_BLUE_CALIBRATION
+#define DUTY_VU_RED 403 // bottom of the VU red zone
+
+static int s_failures;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);        \
+      s_failures++;                                                            \
+    }                                                                          \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                             \
+  do {                                                                         \
+    long _a = (long)(actual), _e = (long)(expected);                           \
+    if (_a != _e) {                                                            \
+      fprintf(stderr, "  FAIL %s:%d: %s == %ld, expected %ld\n", __FILE__,     \
+              __LINE__, #actual, _a, _e);                                      \
+      s_failures++;                                                            \
+    }                                                                          \
+  } while (0)
+
+// +---------------------------------------------------------------+
+// | HELPERS                                                       |
+// +---------------------------------------------------------------+
+
+// Reference model of the Default (with MUTE) RVC curve in handle_RVC()
+static uint8_t ref_default_atten(uint8_t rvc) {
+  if (rvc > 0xE0) {
+    return 0; // nothing plugged in
+  }
+  uint16_t lin = (uint16_t)((rvc * 255) / (255 - rvc));
+  if (lin > 255) {
+    lin = 255;
+  }
+  if (lin < 6) {
+    return 0;
+  } else if (lin > 236) {
+    return 64;
+  } else if (lin <= 192) {
+    return (uint8_t)(((lin - 6) * 14) / 192);
+  }
+  return (uint8_t)(14 + ((lin - 192) * 34) / 44);
+}
+
+// Reference model of the Traditional MA-220 RVC curve, as handle_RVC() used to
+// compute it from atten_lookup[134]
+static const int8_t ref_ma220_lookup[134] = {
+    -12, -12, -12, -12, -12, -12, -12, -12, -12, -12,  // RVC 0-9
+    -12, -12, -12, -12, -12, -12, -12, -12, -11, -11,  // RVC 10-19
+    -11, -11, -11, -11, -11, -11, -11, -11, -11, -11,  // RVC 20-29
+    -11, -11, -11, -11, -11, -11, -11, -11, -11, -11,  // RVC 30-39
+    -11, -11, -10, -10, -10, -10, -10, -10, -10, -10,  // RVC 40-49
+    -10, -10, -10, -10, -10, -10, -10,  -9,  -9,  -9,  // RVC 50-59
+     -9,  -9,  -9,  -9,  -9,  -9,  -9,  -9,  -8,  -8,  // RVC 60-69
+     -8,  -8,  -8,  -8,  -8,  -8,  -7,  -7,  -7,  -7,  // RVC 70-79
+     -7,  -7,  -7,  -6,  -6,  -6,  -6,  -6,  -6,  -6,  // RVC 80-89
+     -6,  -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,  // RVC 90-99
+     -4,  -4,  -4,  -4,  -4,  -3,  -3,  -3,  -3,  -3,  // RVC 100-109
+     -3,  -2,  -2,  -2,  -2,  -2,  -2,  -1,  -1,  -1,  // RVC 110-119
+     -1,  -1,  -1,  -1,  -1,  -1,  -1,  -1,   0,   0,  // RVC 120-129
+      0,   0,   0,   0                                 // RVC 130-133
+};
+
+static uint8_t ref_traditional_atten(uint8_t rvc) {
+  if (rvc > 0xE0) {
+    return 0; // nothing plugged in
+  }
+  uint8_t rvc_reversed = (rvc >= 133) ? 0 : (uint8_t)(133 - rvc);
+  return (uint8_t)(-ref_ma220_lookup[rvc_reversed]);
+}
+
+// Reference model of the VU colors as handle_leds() used to compute them:
+// volume_log_table[display_val], then calculate_vu_color()
+static const uint8_t ref_volume_log[128] = {
+    0,   16,   25,  48,  64,  76,  86,  95,  102, 108, 114, 120, 124, 129, 133,
+    137, 140, 144, 147, 150, 153, 155, 158, 160, 163, 165, 167, 169, 171, 173,
+    175, 177, 179, 180, 182, 184, 185, 187, 188, 190, 191, 192, 194, 195, 196,
+    198, 199, 200, 201, 202, 203, 204, 206, 207, 208, 209, 210, 211, 212, 213,
+    213, 214, 215, 216, 217, 218, 219, 220, 220, 221, 222, 223, 224, 224, 225,
+    226, 227, 227, 228, 229, 229, 230, 231, 231, 232, 233, 233, 234, 235, 235,
+    236, 237, 237, 238, 238, 239, 240, 240, 241, 241, 242, 242, 243, 243, 244,
+    244, 245, 246, 246, 247, 247, 248, 248, 249, 249, 250, 250, 250, 251, 251,
+    252, 252, 253, 253, 254, 254, 255, 255};
+
+static void ref_vu_color(uint8_t b, uint8_t *r, uint8_t *g, uint8_t *blue) {
+  if (b < 192) {
+    *r = 0;
+    *g = (uint8_t)(((uint16_t)b * 101) / 191);
+  } else if (b < 224) {
+    uint16_t t = b - 192;
+    *r = (uint8_t)((t * 122) / 31);
+    *g = (uint8_t)(101 + (t * 9) / 31);
+  } else {
+    uint16_t t = b - 224;
+    *r = (uint8_t)(167 + (t * 88) / 31);
+    *g = 0;
+  }
+  *blue = 0;
+}
+
+// Press and release a switch pin (P1.5 or P1.6), long enough to debounce
+static void press(uint8_t *pin) {
+  *pin = 0;
+  sim_run(10);
+  *pin = 1;
+  sim_run(10);
+}
+
+// Latest valid preferences byte: the newest sector by header sequence, then a
+// backwards scan of its entries (independent of Pref_Init/Pref_Read)
+static int latest_pref(void) {
+  int active = -1;
+  for (int i = 0; i < PREF_NUM_SECTORS; i++) {
+    uint8_t h = sim_iap.eeprom[PREF_SECTOR_ADDR(i)];
+    uint8_t next = sim_iap.eeprom[PREF_SECTOR_ADDR((i + 1) % PREF_NUM_SECTORS)];
+    uint8_t newer = (h == PREF_HEADER_LAST) ? PREF_HEADER_FIRST : h + 1;
+    if (h >= PREF_HEADER_FIRST && h <= PREF_HEADER_LAST && next != newer) {
+      active = i;
+    }
+  }
+  if (active < 0) {
+    return -1;
+  }
+  for (int i = PREF_SECTOR_SLOTS - 1; i >= 1; i--) {
+    uint8_t v = sim_iap.eeprom[PREF_SECTOR_ADDR(active) + i];
+    if ((v & 0x80) == 0) {
+      return v;
+    }
+  }
+  return -1;
+}
+
+static uint32_t pref_erases(int sector) {
+  return sim_iap.erases[PREF_SECTOR_ADDR(sector) / SIM_EEPROM_SECTOR_SIZE];
+}
+
+static void boot_blank(uint32_t ticks) {
+  sim_erase_eeprom();
+  sim_reset();
+  sim_power_on(ticks);
+}
+
+// Sector 0 active, holding `n` appended entries, values n-1 .. 0 (mod 0x80)
+static void fill_prefs(int n) {
+  sim_erase_eeprom();
+  sim_iap.eeprom[PREF_SECTOR_ADDR(0)] = PREF_HEADER_FIRST;
+  for (int i = 0; i < n; i++) {
+    sim_iap.eeprom[PREF_SECTOR_ADDR(0) + 1 + i] = (uint8_t)(i & 0x7F);
+  }
+}
+
+// Legacy single-sector log (firmware <= 1.1.1) holding `n` entries
+static void fill_legacy_prefs(int n) {
+  sim_erase_eeprom();
+  for (int i = 0; i < n; i++) {
+    sim_iap.eeprom[PREF_LEGACY_ADDR + i] = (uint8_t)(i & 0x7F);
+  }
+}
+
+// The original Pref_Read(): scan backwards one IAP read at a time
+static uint8_t ref_pref_read_scan(void) {
+  sim_iap.enabled = 1;
+  for (int i = PREF_SECTOR_SIZE; i > 0; i--) {
+    sim_iap_cmd(SIM_IAP_CMD_READ, (uint16_t)(PREF_LEGACY_ADDR + i - 1));
+    if ((sim_iap.data & 0x80) == 0) {
+      sim_iap.enabled = 0;
+      return sim_iap.data;
+    }
+  }
+  sim_iap.enabled = 0;
+  return PREF_DEFAULT_VALUE;
+}
+
+// LED color as one number, for comparing sequences
+// (10 bits each: 0x3FF << 20 = red, 0x3FF << 10 = green, 0x3FF = blue)
+static uint32_t led_rgb(void) {
+  return ((uint32_t)sim_pca.ccap[LED_RED] << 20) |
+         ((uint32_t)sim_pca.ccap[LED_GREEN] << 10) | sim_pca.ccap[LED_BLUE];
+}
+
+#define RGB(r, g, b) (((uint32_t)(r) << 20) | ((uint32_t)(g) << 10) | (b))
+
+typedef struct {
+  uint32_t rgb;
+  int ms; // -1 = don't care
+} led_segment_t;
+
+// Runs `ticks` ticks and checks the LED goes through `expected` (runs of one
+// color).  Runs are measured in ticks, so allow one 50ms LED frame of slack.
+static void check_led_segments(uint32_t ticks, const led_segment_t *expected,
+                               int count) {
+  int seg = -1, len = 0;
+  uint32_t rgb = 0xFFFFFFFF;
+  for (uint32_t t = 0; t < ticks; t++) {
+    sim_run(1);
+    if (led_rgb() == rgb) {
+      len++;
+      continue;
+    }
+    if (seg >= 0 && seg < count && expected[seg].ms >= 0) {
+      int d = len * 10 - expected[seg].ms;
+      if (d < -50 || d > 50) {
+        fprintf(stderr, "  FAIL segment %d (%08X): %d ms, expected %d ms\n",
+                seg, rgb, len * 10, expected[seg].ms);
+        s_failures++;
+      }
+    }
+    seg++;
+    rgb = led_rgb();
+    len = 1;
+    if (seg < count) {
+      CHECK_EQ(rgb, expected[seg].rgb);
+    }
+  }
+  CHECK_EQ(seg, count - 1); // the last run lasts until the end
+}
+
+// +---------------------------------------------------------------+
+// | SCENARIOS                                                     |
+// +---------------------------------------------------------------+
+static void scenario_boot_defaults(void) {
+  boot_blank(TICKS_PER_SECOND);
+
+  CHECK_EQ(sim.ticks, TICKS_PER_SECOND);
+  CHECK_EQ(sim_lm1971.atten_db, 0); // no RVC plugged in => 0dB
+  CHECK_EQ(sim_lm1971.errors, 0);
+  CHECK_EQ(sim_adc.unpowered_conversions, 0);
+  CHECK_EQ(latest_pref(), 0x00);
+  CHECK(sim.boot_us < 10000); // the version flashes do not block main()
+  printf("  boot time to first IDLE: %.0f us\n", (double)sim.boot_us);
+
+  sim_run(2 * TICKS_PER_SECOND); // after the version flashes
+  CHECK_EQ(sim_pca.ccap[LED_GREEN], DUTY_GREEN); // battery monitor: good = GREEN
+  CHECK_EQ(sim_pca.ccap[LED_RED], 0);
+}
+
+// Pref_Init() finds the latest entry in at most PREF_NUM_SECTORS + 10 reads
+// at every fill level, and the next Pref_Write() appends right after it
+static void scenario_pref_read(void) {
+  for (int n = 1; n < PREF_SECTOR_SLOTS; n++) {
+    fill_prefs(n);
+    uint8_t expected = (uint8_t)((n - 1) & 0x7F);
+
+    Preferences_t p;
+    uint32_t reads = sim_iap.reads;
+    uint32_t writes = sim_iap.writes;
+    Pref_Init();
+    Pref_Read(&p);
+    CHECK_EQ(p.value, expected);
+    CHECK(sim_iap.reads - reads <= PREF_NUM_SECTORS + 10 + 1);
+    CHECK_EQ(sim_iap.writes, writes); // nothing written at power-up
+
+    p.value = expected ^ 0x01; // a change, so it is written
+    Pref_Write(&p);
+    if (n < PREF_SECTOR_SLOTS - 1) {
+      CHECK_EQ(sim_iap.eeprom[PREF_SECTOR_ADDR(0) + 1 + n], p.value);
+    } else {
+      // full: the value moves to sector 1, sector 0 is left as it was
+      CHECK_EQ(sim_iap.eeprom[PREF_SECTOR_ADDR(1)], PREF_HEADER_FIRST + 1);
+      CHECK_EQ(sim_iap.eeprom[PREF_SECTOR_ADDR(1) + 1], p.value);
+      CHECK_EQ(sim_iap.eeprom[PREF_SECTOR_ADDR(0) + n], expected);
+      CHECK_EQ(pref_erases(0), 0);
+    }
+    CHECK_EQ(latest_pref(), p.value);
+  }
+}
+
+// The first power-up after a firmware update keeps the legacy preferences
+static void scenario_pref_legacy(void) {
+  for (int n = 0; n <= PREF_SECTOR_SIZE; n++) {
+    fill_legacy_prefs(n);
+    uint8_t expected = ref_pref_read_scan();
+
+    Preferences_t p;
+    Pref_Init();
+    Pref_Read(&p);
+    CHECK_EQ(p.value, expected);
+    CHECK_EQ(latest_pref(), expected);
+
+    uint32_t writes = sim_iap.writes;
+    Pref_Init(); // second power-up: already formatted
+    Pref_Read(&p);
+    CHECK_EQ(p.value, expected);
+    CHECK_EQ(sim_iap.writes, writes);
+  }
+}
+
+// Laps through all the sectors, with power-ups and torn rotations
+static void scenario_pref_rotation(void) {
+  const int laps = 3;
+  const int per_lap = PREF_NUM_SECTORS * (PREF_SECTOR_SLOTS - 1);
+  Preferences_t p;
+
+  sim_erase_eeprom();
+  Pref_Init();
+  for (int i = 1; i <= laps * per_lap; i++) {
+    p.value = (uint8_t)(i & 0x7F);
+    CHECK(Pref_Write(&p));
+    if (i % 97 == 0) {
+      Pref_Init(); // power cycle
+      Pref_Read(&p);
+      CHECK_EQ(p.value, i & 0x7F);
+    }
+  }
+  CHECK_EQ(latest_pref(), (laps * per_lap) & 0x7F);
+  // the log is the whole EEPROM, and every sector of it is erased once per
+  // lap (plus formatting sector 0)
+  CHECK_EQ(PREF_NUM_SECTORS * PREF_SECTOR_SIZE, SIM_EEPROM_SIZE);
+  for (int s = 0; s < PREF_NUM_SECTORS; s++) {
+    CHECK_EQ(pref_erases(s), laps + (s == 0 ? 1 : 0));
+  }
+
+  // power fails during a rotation, after the next sector got its entry but
+  // before its header: the full sector is still the active one
+  fill_prefs(PREF_SECTOR_SLOTS - 1);
+  sim_iap.eeprom[PREF_SECTOR_ADDR(1) + 1] = 0x55;
+  Pref_Init();
+  Pref_Read(&p);
+  CHECK_EQ(p.value, (PREF_SECTOR_SLOTS - 2) & 0x7F);
+  p.value = 0x66; // and the rotation is simply done again
+  CHECK(Pref_Write(&p));
+  CHECK_EQ(sim_iap.eeprom[PREF_SECTOR_ADDR(1)], PREF_HEADER_FIRST + 1);
+  CHECK_EQ(latest_pref(), 0x66);
+
+  // the sequence number wraps from PREF_HEADER_LAST to PREF_HEADER_FIRST
+  sim_erase_eeprom();
+  sim_iap.eeprom[PREF_SECTOR_ADDR(2)] = PREF_HEADER_LAST - 1;
+  sim_iap.eeprom[PREF_SECTOR_ADDR(2) + 1] = 0x11;
+  sim_iap.eeprom[PREF_SECTOR_ADDR(3)] = PREF_HEADER_LAST;
+  sim_iap.eeprom[PREF_SECTOR_ADDR(3) + 1] = 0x22;
+  sim_iap.eeprom[PREF_SECTOR_ADDR(0)] = PREF_HEADER_FIRST;
+  sim_iap.eeprom[PREF_SECTOR_ADDR(0) + 1] = 0x33;
+  Pref_Init();
+  Pref_Read(&p);
+  CHECK_EQ(p.value, 0x33);
+}
+
+// Version flashes, RVC mode flashes and a switch held at power-up
+static void scenario_led_sequences(void) {
+  const int on = (int)(400 * VERSION_DISPLAY_TIMING_SCALE);
+  const int gap = (int)(200 * VERSION_DISPLAY_TIMING_SCALE);
+  const int pause = (int)(1600 * VERSION_DISPLAY_TIMING_SCALE);
+  const struct {
+    int flashes;
+    uint32_t rgb;
+  } groups[3] = {{FW_MAJOR, RGB(DUTY_RED, 0, 0)},
+                 {FW_MINOR, RGB(0, DUTY_GREEN, 0)},
+                 {FW_PATCH, RGB(0, 0, DUTY_BLUE)}};
+  led_segment_t version[64];
+  int n = 0;
+  for (int i = 0; i < 3; i++) {
+    for (int f = 0; f < groups[i].flashes; f++) {
+      version[n++] = (led_segment_t){groups[i].rgb, on};
+      version[n++] = (led_segment_t){0, on};
+    }
+    if (n > 0 && version[n - 1].rgb == 0) {
+      version[n - 1].ms += (i < 2) ? gap : pause;
+    }
+  }
+  version[n++] = (led_segment_t){RGB(0, DUTY_GREEN, 0), -1}; // battery good
+
+  // audio at the RVC level before the first Timer0 tick, LED still dark
+  sim_erase_eeprom();
+  sim_reset();
+  sim_adc.inputs[ADC_RVC] = 0x40;
+  sim_power_on(0);
+  CHECK_EQ(sim_lm1971.atten_db, ref_default_atten(0x40));
+  CHECK_EQ(led_rgb(), 0);
+  check_led_segments(4 * TICKS_PER_SECOND, version, n);
+
+  // RVC mode -> Traditional MA-220: two flashes
+  static const led_segment_t ma220[] = {
+      {RGB(0, DUTY_GREEN, 0), -1}, // until the release is debounced
+      {0, 500},              {RGB(0, DUTY_GREEN, 0), 200}, {0, 200},
+      {RGB(0, DUTY_GREEN, 0), 200}, {0, 700}, {RGB(0, DUTY_GREEN, 0), -1}};
+  sim_pins.p15 = 0;
+  sim_run(10);
+  sim_pins.p15 = 1;
+  check_led_segments(3 * TICKS_PER_SECOND, ma220, 7);
+  sim_run(PREFS_COMMIT_TICKS);
+
+  // a switch held at power-up is not a press, and does not hold up the boot
+  sim_reset();
+  sim_adc.inputs[ADC_RVC] = 0x40;
+  sim_pins.p16 = 0;
+  sim_power_on(TICKS_PER_SECOND);
+  CHECK(sim.boot_us < 10000);
+  CHECK_EQ(sim_lm1971.atten_db, ref_traditional_atten(0x40)); // from EEPROM
+  sim_pins.p16 = 1;
+  sim_run(3 * TICKS_PER_SECOND);
+  CHECK_EQ(led_rgb(), RGB(0, DUTY_GREEN, 0)); // still battery monitor mode
+  press(&sim_pins.p16);                 // the next press does count
+  sim_run(PREFS_COMMIT_TICKS);
+  CHECK_EQ(latest_pref() & 0x06, 0x02);
+}
+
+static void scenario_rvc_default_curve(void) {
+  boot_blank(TICKS_PER_SECOND);
+
+  for (int v = 0; v <= 0xFF; v++) {
+    sim_adc.inputs[ADC_RVC] = (uint8_t)v;
+    sim_run(2 * 5 + 64 / ATTEN_SLEW_STEPS_PER_TICK); // RVC update + slew
+    CHECK_EQ(sim_lm1971.atten_db, ref_default_atten((uint8_t)v));
+  }
+  CHECK_EQ(sim_lm1971.errors, 0);
+  CHECK_EQ(sim_adc.unpowered_conversions, 0);
+}
+
+static uint32_t s_slew_writes;
+static uint32_t s_slew_steps_max;
+
+static void count_slew_steps(uint32_t tick) {
+  uint32_t steps = sim_lm1971.writes - s_slew_writes;
+  s_slew_steps_max = (steps > s_slew_steps_max) ? steps : s_slew_steps_max;
+  s_slew_writes = sim_lm1971.writes;
+}
+
+// Exhaustive check of the generated tables against the original formulas
+static void scenario_rvc_tables(void) {
+  for (int v = 0; v <= 0xFF; v++) {
+    CHECK_EQ(rvc_atten_table[0][v], ref_default_atten((uint8_t)v));
+    CHECK_EQ(rvc_atten_table[1][v], ref_traditional_atten((uint8_t)v));
+  }
+
+  // and through the firmware, in Traditional MA-220 mode
+  boot_blank(TICKS_PER_SECOND);
+  press(&sim_pins.p15);
+  for (int v = 0; v <= 0xFF; v++) {
+    sim_adc.inputs[ADC_RVC] = (uint8_t)v;
+    sim_run(2 * 5 + 64 / ATTEN_SLEW_STEPS_PER_TICK);
+    CHECK_EQ(sim_lm1971.atten_db, ref_traditional_atten((uint8_t)v));
+  }
+}
+
+static void scenario_rvc_ramp_to_mute(void) {
+  boot_blank(TICKS_PER_SECOND);
+  CHECK_EQ(sim_lm1971.atten_db, 0);
+
+  uint32_t writes = sim_lm1971.writes;
+  uint32_t ticks = 0;
+  s_slew_writes = writes;
+  sim.on_tick = count_slew_steps;
+  sim.isr_busy_us_max = 0;
+  sim_adc.inputs[ADC_RVC] = 0xD0; // far end of the pot => MUTE
+  while (sim_lm1971.atten_db != 64 && ticks < TICKS_PER_SECOND) {
+    sim_run(1);
+    ticks++;
+  }
+  sim_run(1);
+  count_slew_steps(0);
+
+  CHECK_EQ(sim_lm1971.atten_db, 64);
+  CHECK_EQ(sim_lm1971.writes - writes, 64); // 1dB steps, no zipper jumps
+  CHECK(s_slew_steps_max <= ATTEN_SLEW_STEPS_PER_TICK);
+  // sampled up to one RVC period late, one tick ahead of use, then slewed
+  CHECK(ticks <= 2 * RVC_TICKS + 64 / ATTEN_SLEW_STEPS_PER_TICK);
+  // Timer0_Routine() no longer waits out the ramp.  This is the modelled
+  // blocking time inside Timer0 only: the steps themselves now run in
+  // ADC_Routine(), and atten_zero_crossing bounds their ISR load.
+  CHECK_EQ(sim.isr_busy_us_max, 0);
+  printf("  0 -> 64dB in %u ticks, longest Timer0 wait while ramping: %u us\n",
+         ticks, sim.isr_busy_us_max);
+}
+
+// OUTMON test tone for atten_zero_crossing: a sine around 0x80
+static double s_tone_hz;
+static double s_tone_amplitude;
+static uint32_t s_zc_window_us;
+static uint32_t s_zc_steps, s_zc_steps_in_window;
+static double s_zc_level_sum;
+static uint32_t s_zc_tick_steps; // s_zc_steps at the previous tick
+static uint64_t s_zc_run_us, s_zc_total_us;
+static double s_zc_load_max;
+
+static uint8_t tone_source(uint64_t time_us) {
+  return (uint8_t)lround(0x80 + s_tone_amplitude *
+                                    sin(2 * M_PI * s_tone_hz * time_us / 1e6));
+}
+
+// each latched step: how far from the nearest zero crossing of the tone
+static void tone_zc_step(uint8_t atten_db) {
+  double half_us = 1e6 / (2 * s_tone_hz);
+  double from_zc = fmod((double)sim.time_us, half_us);
+  from_zc = (from_zc < half_us - from_zc) ? from_zc : half_us - from_zc;
+
+  s_zc_steps++;
+  if (from_zc <= s_zc_window_us) {
+    s_zc_steps_in_window++;
+  }
+  s_zc_level_sum += abs(tone_source(sim.time_us) - 0x80);
+}
+
+// before each tick: the CPU load of the one before (Timer0 and every Timer2,
+// ADC and port interrupt, from the energy model), if it made a step
+static void zc_tick_load(uint32_t tick) {
+  uint64_t total_us = sim_energy.run_us + sim_energy.idle_us;
+
+  if (s_zc_steps != s_zc_tick_steps && total_us > s_zc_total_us) {
+    double load = (double)(sim_energy.run_us - s_zc_run_us) /
+                  (total_us - s_zc_total_us);
+    s_zc_load_max = (load > s_zc_load_max) ? load : s_zc_load_max;
+  }
+  s_zc_tick_steps = s_zc_steps;
+  s_zc_run_us = sim_energy.run_us;
+  s_zc_total_us = total_us;
+}
+
+// Slew to `rvc` (=> atten_db `target`) with a tone on OUTMON; returns ticks
+static uint32_t zc_ramp(double hz, uint8_t rvc, uint8_t target) {
+  uint8_t steps = (uint8_t)abs(target - sim_lm1971.atten_db);
+  // one zero-crossing sample: SIM_ADC_CONV_CLOCKS at the slower ADC clock
+  double zc_sample_us = SIM_ADC_CONV_CLOCKS * 2.0 *
+                        (ATTEN_ZC_ADC_PRESCALER + 1) * 1e6 / SIM_SYSCLOCK_HZ;
+
+  s_tone_hz = hz;
+  // a step lands within half a sample of the crossing it predicted (a sine
+  // is not a straight line: allow a whole one), or up to ATTEN_ZC_WINDOW
+  // counts early
+  s_zc_window_us = (uint32_t)(zc_sample_us +
+                              (ATTEN_ZC_WINDOW + 0.5) /
+                                  (s_tone_amplitude * 2 * M_PI * hz / 1e6));
+  s_zc_steps = s_zc_steps_in_window = 0;
+  s_zc_level_sum = 0;
+  s_zc_tick_steps = 0;
+  s_zc_run_us = sim_energy.run_us;
+  s_zc_total_us = sim_energy.run_us + sim_energy.idle_us;
+  s_zc_load_max = 0;
+  sim.on_atten = tone_zc_step;
+  sim.on_tick = zc_tick_load;
+
+  uint32_t ticks = 0;
+  sim_adc.inputs[ADC_RVC] = rvc;
+  while (sim_lm1971.atten_db != target && ticks < TICKS_PER_SECOND) {
+    sim_run(1);
+    ticks++;
+  }
+  sim_run(1); // the load of the last tick that stepped
+  sim.on_atten = NULL;
+  sim.on_tick = NULL;
+  CHECK_EQ(sim_lm1971.atten_db, target);
+  CHECK_EQ(s_zc_steps, steps);
+  printf("  %4.0f Hz: %2u/%u steps within %u us of a zero crossing, "
+         "mean |OUTMON - 0x80| at a step %4.1f of %.0f, %u ticks, "
+         "ISR load %.1f%%\n",
+         hz, s_zc_steps_in_window, s_zc_steps, s_zc_window_us,
+         s_zc_level_sum / s_zc_steps, s_tone_amplitude, ticks,
+         100.0 * s_zc_load_max);
+  return ticks;
+}
+
+static void scenario_atten_zero_crossing(void) {
+  // sampled up to one RVC period late, one tick ahead of use, then slewed
+  const uint32_t ramp_ticks = 2 * RVC_TICKS + 64 / ATTEN_SLEW_STEPS_PER_TICK;
+
+  boot_blank(TICKS_PER_SECOND);
+  s_tone_amplitude = 0x60;
+  sim_adc.source[ADC_OUTMON] = tone_source;
+  // the limiter and the howl detector keep VU sampling on
+  double load_max = vu_sampling ? ATTEN_ZC_VU_LOAD_MAX : ATTEN_ZC_LOAD_MAX;
+
+  // every step at a zero crossing, at the full slew rate
+  CHECK(zc_ramp(1000, 0xD0, 64) <= ramp_ticks); // 0dB -> MUTE
+  CHECK_EQ(s_zc_steps_in_window, 64);
+  CHECK(s_zc_load_max <= load_max);
+  CHECK(zc_ramp(440, 0xFF, 0) <= ramp_ticks); // MUTE -> 0dB
+  CHECK_EQ(s_zc_steps_in_window, 64);
+  CHECK(s_zc_load_max <= load_max);
+
+  // 50Hz crosses every 10ms: most steps time out, the ramp is not slower.
+  // OUTMON is watched all tick long, so this is the heaviest ISR load
+  CHECK(zc_ramp(50, 0xD0, 64) <= ramp_ticks);
+  CHECK(s_zc_steps_in_window < 64);
+  CHECK(s_zc_load_max <= load_max);
+
+  // the same with VU meter sampling (Timer2) running as well
+  press(&sim_pins.p16); // LED mode -> VU meter
+  CHECK(zc_ramp(50, 0xFF, 0) <= ramp_ticks);
+  CHECK(s_zc_load_max <= ATTEN_ZC_VU_LOAD_MAX);
+}
+
+// Every LM1971 frame meets the datasheet timing, and each delay is as short
+// as the spec allows: the tightest spacing seen is the spec rounded up to
+// whole clocks, or the pin writes that must sit between the edges anyway.
+static void scenario_atten_timing(void) {
+  static const uint32_t writes_between[SIM_LM1971_T_COUNT] = {1, 1, 2, 1};
+
+  boot_blank(TICKS_PER_SECOND);
+  sim_adc.inputs[ADC_RVC] = 0xD0; // ramp 0dB -> MUTE, every bit pattern
+  sim_run(TICKS_PER_SECOND);
+
+  CHECK(sim_lm1971.writes >= 64);
+  CHECK_EQ(sim_lm1971.errors, 0);
+  CHECK_EQ(sim_lm1971.order_errors, 0);
+  for (int t = 0; t < SIM_LM1971_T_COUNT; t++) {
+    uint64_t spec = ((uint64_t)sim_lm1971_min_ns[t] * SIM_SYSCLOCK_HZ +
+                     999999999ULL) / 1000000000ULL;
+    uint32_t tightest = spec > writes_between[t] ? (uint32_t)spec
+                                                 : writes_between[t];
+    CHECK_EQ(sim_lm1971.timing_errors[t], 0);
+    CHECK_EQ(sim_lm1971.min_clocks[t], tightest);
+    printf("  %-22s >= %3u ns: %u clocks = %4u ns\n", sim_lm1971_names[t],
+           sim_lm1971_min_ns[t], sim_lm1971.min_clocks[t],
+           sim_lm1971_clocks_to_ns(sim_lm1971.min_clocks[t]));
+  }
+  printf("  frame at %.3f MHz: %u clocks = %.1f us\n", SIM_SYSCLOCK_HZ / 1e6,
+         sim_lm1971.frame_clocks,
+         sim_lm1971_clocks_to_ns(sim_lm1971.frame_clocks) / 1000.0);
+}
+
+static void scenario_adc_background(void) {
+  boot_blank(TICKS_PER_SECOND);
+  press(&sim_pins.p16); // LED mode -> VU meter
+  sim_run(TICKS_PER_SECOND);
+
+  uint32_t rvc = sim_adc.conversions[ADC_RVC];
+  uint32_t outmon = sim_adc.conversions[ADC_OUTMON];
+  uint32_t battmon = sim_adc.conversions[ADC_BATTMON];
+  uint32_t irqs = sim_adc.interrupts;
+  uint32_t vu_irqs = sim_cpu.timer2_irqs;
+  sim.isr_busy_us_max = 0;
+  sim_adc.inputs[ADC_OUTMON] = 0x80 + 0x70; // loud
+  sim_run(TICKS_PER_SECOND + 1);
+
+  // one sequence every 5 ticks, BATTMON once a second, and one OUTMON sample
+  // per Timer2 interrupt
+  uint32_t vu_samples = VU_SAMPLE_HZ * (TICKS_PER_SECOND + 1) / TICKS_PER_SECOND;
+  CHECK_EQ(sim_adc.conversions[ADC_RVC] - rvc, 20);
+  CHECK_EQ(sim_cpu.timer2_irqs - vu_irqs, vu_samples);
+  CHECK_EQ(sim_adc.conversions[ADC_OUTMON] - outmon, vu_samples);
+  CHECK_EQ(sim_adc.conversions[ADC_BATTMON] - battmon, 1);
+  CHECK_EQ(sim_adc.interrupts - irqs, 20 + vu_samples + 1);
+  CHECK_EQ(sim_adc.unpowered_conversions, 0);
+  CHECK_EQ(sim.isr_busy_us_max, 0); // Timer0 ISR never waits for the ADC
+  CHECK(sim_pca.ccap[LED_RED] >= DUTY_VU_RED); // VU meter sees the loud signal (red zone)
+  CHECK_EQ(sim_pca.ccap[LED_GREEN], 0);
+}
+
+// OUTMON test signal for vu_sampling: a tone, plus an optional 300us spike
+// every 500ms (shorter than a Timer0 tick, between the old 20-sample bursts)
+static uint8_t s_vu_max_peak;
+
+static uint8_t vu_signal(uint64_t time_us) {
+  if (s_tone_hz == 0) {
+    return (time_us % 500000 >= 20000 && time_us % 500000 < 20300) ? 0x80 + 0x70
+                                                                    : 0x80;
+  }
+  return tone_source(time_us);
+}
+
+static void track_vu_peak(uint32_t tick) {
+  s_vu_max_peak = (abs_out_res > s_vu_max_peak) ? abs_out_res : s_vu_max_peak;
+}
+
+static void scenario_vu_sampling(void) {
+  boot_blank(TICKS_PER_SECOND);
+  press(&sim_pins.p16); // LED mode -> VU meter
+  sim_adc.source[ADC_OUTMON] = vu_signal;
+
+  // a steady tone: true peak and RMS (A / sqrt(2))
+  s_tone_hz = 1234;
+  s_tone_amplitude = 0x50;
+  sim_run(TICKS_PER_SECOND);
+  CHECK(abs_out_res >= 0x50 - 3 && abs_out_res <= 0x50);
+  CHECK(abs(vu_rms - (int)lround(0x50 / M_SQRT2)) <= 2);
+  printf("  %.0f Hz tone, amplitude %d: peak %u, RMS %u (expected %.1f)\n",
+         s_tone_hz, 0x50, abs_out_res, vu_rms, 0x50 / M_SQRT2);
+
+  // a 300us spike between ticks is seen every time
+  s_tone_hz = 0;
+  sim_run(TICKS_PER_SECOND / 2);
+  uint32_t vu_irqs = sim_cpu.timer2_irqs;
+  uint32_t adc_irqs = sim_adc.interrupts;
+  uint32_t spikes = 0;
+  for (int i = 0; i < 4; i++) {
+    s_vu_max_peak = 0;
+    sim.on_tick = track_vu_peak;
+    sim_run(TICKS_PER_SECOND / 2);
+    spikes += (s_vu_max_peak >= 0x70);
+  }
+  sim.on_tick = NULL;
+  CHECK_EQ(spikes, 4);
+
+  // CPU cost: per sample, one Timer2 + one ADC interrupt, over 2 seconds
+  double irqs_per_s = (sim_cpu.timer2_irqs - vu_irqs + sim_adc.interrupts -
+                       adc_irqs) / 2.0;
+  printf("  %u/4 spikes seen; %.0f interrupts/s x %d clocks = %.1f%% CPU\n",
+         spikes, irqs_per_s, SIM_RUN_CLOCKS_PER_IRQ,
+         100.0 * irqs_per_s * SIM_RUN_CLOCKS_PER_IRQ / SIM_SYSCLOCK_HZ);
+}
+
+// VU meter ballistics: a tone burst, traced once per 50ms frame through the
+// firmware, and through the old ones (max of the last 4 frames, then x15/16
+// per frame through a uint32_t) for comparison.  Clocks per update are a
+// hand count of the SDCC code on the 1T core (32-bit multiply helper, the
+// int % 4 helper and the window loop vs. a few 16-bit shifts and adds); use
+// `make bench-s51` (phase `vu`) for the whole ISR.
+#define BALLISTICS_OLD_CLOCKS 240
+#define BALLISTICS_NEW_CLOCKS 60
+#define BALLISTICS_FRAMES 200
+
+static struct {
+  uint32_t frames;
+  uint64_t us[BALLISTICS_FRAMES];
+  uint16_t fw[BALLISTICS_FRAMES];
+  uint16_t old[BALLISTICS_FRAMES];
+  uint16_t old_x;
+  uint8_t window[4], window_index;
+  uint64_t on_us, off_us; // the burst, starting between ticks
+} s_bal;
+
+static uint8_t burst_source(uint64_t time_us) {
+  return (time_us >= s_bal.on_us && time_us < s_bal.off_us)
+             ? tone_source(time_us)
+             : 0x80;
+}
+
+static void ballistics_frame(uint32_t tick) {
+  // before each tick: did the previous one run handle_leds()?
+  if (timer_ticks % RVC_TICKS != (LEDS_PHASE + 1) % RVC_TICKS ||
+      s_bal.frames >= BALLISTICS_FRAMES) {
+    return;
+  }
+  s_bal.window[s_bal.window_index] = abs_out_res;
+  s_bal.window_index = (s_bal.window_index + 1) % 4;
+  uint16_t in = 0;
+  for (int i = 0; i < 4; i++) {
+    in = (s_bal.window[i] > in) ? s_bal.window[i] : in;
+  }
+  in <<= 8;
+  if (in >= s_bal.old_x) {
+    s_bal.old_x = in;
+  } else {
+    s_bal.old_x = (uint16_t)((uint32_t)s_bal.old_x * 15 / 16);
+    s_bal.old_x = (s_bal.old_x < 256) ? 0 : s_bal.old_x;
+  }
+  s_bal.us[s_bal.frames] = sim.time_us;
+  s_bal.fw[s_bal.frames] = vu_display_val_fixed;
+  s_bal.old[s_bal.frames] = s_bal.old_x;
+  s_bal.frames++;
+}
+
+// ms from `from_us` to the first frame at or above (rise) / at or below
+// (fall) `level`
+static double ballistics_ms(const uint16_t *trace, uint64_t from_us,
+                            double level, bool rise) {
+  for (uint32_t i = 0; i < s_bal.frames; i++) {
+    if (s_bal.us[i] > from_us &&
+        (rise ? trace[i] >= level : trace[i] <= level)) {
+      return (s_bal.us[i] - from_us) / 1000.0;
+    }
+  }
+  return 1e9;
+}
+
+static void scenario_vu_ballistics(void) {
+  boot_blank(TICKS_PER_SECOND);
+  press(&sim_pins.p16); // LED mode -> VU meter (starts at full scale)
+  memset(&s_bal, 0, sizeof(s_bal));
+  s_bal.on_us = s_bal.off_us = UINT64_MAX;
+  sim_adc.source[ADC_OUTMON] = burst_source;
+  s_tone_hz = 1234; // not a divisor of VU_SAMPLE_HZ: the samples find the peak
+  s_tone_amplitude = 100;
+  sim_run(6 * TICKS_PER_SECOND); // (type IIa falls from full scale in ~5s)
+  CHECK_EQ(vu_display_val_fixed, 0);
+
+  uint64_t on_us = s_bal.on_us = sim.time_us + 503000; // between ticks
+  uint64_t off_us = s_bal.off_us = on_us + 2000000;
+  sim.on_tick = ballistics_frame;
+  sim_run(8 * TICKS_PER_SECOND);
+  sim.on_tick = NULL;
+  uint32_t steady = 0; // last frame of the burst
+  while (steady + 1 < s_bal.frames && s_bal.us[steady + 1] < off_us) {
+    steady++;
+  }
+
+  double fw = s_bal.fw[steady], old = s_bal.old[steady];
+#if VU_METER_BALLISTICS == VU_BALLISTICS_VU
+  // IEC 60268-17: 99% in 300ms +/-10%, either way; a frame of latency
+  const char *name = "VU";
+  double fall_db = 40;
+  CHECK(fabs(fw / 256 - 100) <= 3); // RMS x 1.41 reads the sine's peak
+  double rise = ballistics_ms(s_bal.fw, on_us, 0.99 * fw, true);
+  double fall = ballistics_ms(s_bal.fw, off_us, 0.01 * fw, false);
+  CHECK(rise >= 270 && rise <= 330 + 50);
+  CHECK(fall >= 270 && fall <= 330 + 50);
+#else
+  // IEC 60268-10: rise within a frame; 20dB (type I) / 24dB (type IIa)
+  // fall in 1.5s / 2.8s, +/-10%
+#if VU_METER_BALLISTICS == VU_BALLISTICS_PPM_BBC
+  const char *name = "PPM type IIa (BBC)";
+  double fall_db = 24, fall_ms = 2800;
+#else
+  const char *name = "PPM type I (DIN)";
+  double fall_db = 20, fall_ms = 1500;
+#endif
+  CHECK(fabs(fw / 256 - 100) <= 3); // true peak
+  double rise = ballistics_ms(s_bal.fw, on_us, 0.99 * fw, true);
+  double fall =
+      ballistics_ms(s_bal.fw, off_us, fw * pow(10, -fall_db / 20), false);
+  CHECK(rise <= 50 + 50);
+  CHECK(fall >= 0.9 * fall_ms && fall <= 1.1 * fall_ms + 50);
+#endif
+  double old_rise = ballistics_ms(s_bal.old, on_us, 0.99 * old, true);
+  double old_fall =
+      ballistics_ms(s_bal.old, off_us, old * pow(10, -fall_db / 20), false);
+  printf("  %s: 99%% rise %.0f ms, %.0f dB fall %.0f ms, ~%d clocks/frame\n",
+         name, rise, fall_db, fall, BALLISTICS_NEW_CLOCKS);
+  printf("  old (4-frame max, x15/16): 99%% rise %.0f ms, %.0f dB fall %.0f ms,"
+         " ~%d clocks/frame\n",
+         old_rise, fall_db, old_fall, BALLISTICS_OLD_CLOCKS);
+}
+
+// VU colors: the generated table, entry by entry, against the old per-update
+// code, then what the firmware shows for every display value the band reaches
+static uint32_t s_vu_color_ticks, s_vu_color_seen[4];
+
+static void check_vu_color(uint32_t tick) {
+  uint8_t display_val = (uint8_t)((vu_display_val_fixed + 0x80) >> 8);
+  uint8_t r, g, blue;
+  ref_vu_color(ref_volume_log[display_val > 127 ? 127 : display_val], &r, &g,
+               &blue);
+  CHECK_EQ(sim_pca.ccap[LED_RED], led_gamma_table[r]);
+  CHECK_EQ(sim_pca.ccap[LED_GREEN], led_gamma_table[g]);
+  CHECK_EQ(sim_pca.ccap[LED_BLUE], led_gamma_table[blue]);
+  s_vu_color_seen[display_val >> 5] |= 1u << (display_val & 31);
+  s_vu_color_ticks++;
+}
+
+static void scenario_vu_colors(void) {
+  for (int v = 0; v < VU_COLOR_ENTRIES; v++) {
+    uint8_t r, g, blue;
+    ref_vu_color(ref_volume_log[v], &r, &g, &blue);
+    CHECK_EQ(vu_color_table[v].r, r);
+    CHECK_EQ(vu_color_table[v].g, g);
+    CHECK_EQ(blue, 0);
+  }
+
+  boot_blank(TICKS_PER_SECOND);
+  press(&sim_pins.p16); // LED mode -> VU meter
+  sim_audio_synth(SIM_AUDIO_BAND, 8.0);
+  sim_audio.gain = 1.0;
+  sim_adc.source[ADC_OUTMON] = sim_audio_outmon;
+  sim_run(TICKS_PER_SECOND);
+  memset(s_vu_color_seen, 0, sizeof(s_vu_color_seen));
+  s_vu_color_ticks = 0;
+  sim.on_tick = check_vu_color;
+  sim_run(8 * TICKS_PER_SECOND);
+  sim.on_tick = NULL;
+
+  int seen = 0;
+  for (int i = 0; i < 4; i++) {
+    seen += __builtin_popcount(s_vu_color_seen[i]);
+  }
+  CHECK(seen >= 16); // (fewest with VU ballistics, which barely move on drums)
+  printf("  %d entries match; %d display values seen in %u ticks of the band\n",
+         VU_COLOR_ENTRIES, seen, s_vu_color_ticks);
+}
+
+#ifdef INCLUDE_LIMITER
+// Limiter latencies, from what the ADC sees on OUTMON and what the LM1971
+// latches.  Attack: first near-clip sample to the first added step.
+// Release: last near-clip sample to back at the RVC setting.
+static struct {
+  uint8_t rvc_db;         // attenuation without the limiter
+  uint8_t atten_db;       // latched, as of the last step
+  uint8_t max_gr;         // deepest limiting seen, dB
+  uint64_t over_first_us; // onset (0 = not waiting for an attack)
+  uint64_t over_last_us;
+  uint32_t samples, over_samples;
+  uint32_t attacks, releases;
+  uint64_t attack_us_sum, attack_us_max;
+  uint64_t release_us_sum, release_us_max;
+} s_lim;
+
+static uint8_t limiter_outmon(uint64_t time_us) {
+  uint8_t v = sim_audio_outmon(time_us);
+  s_lim.samples++;
+  if (abs(v - 0x80) >= LIMITER_THRESHOLD) {
+    s_lim.over_samples++;
+    s_lim.over_last_us = time_us;
+    if (s_lim.atten_db == s_lim.rvc_db && s_lim.over_first_us == 0) {
+      s_lim.over_first_us = time_us;
+    }
+  }
+  if (s_lim.over_first_us != 0 && s_lim.atten_db == s_lim.rvc_db &&
+      time_us - s_lim.over_first_us > 50000) {
+    s_lim.over_first_us = 0; // a lone peak: no attack, as intended
+  }
+  return v;
+}
+
+static void limiter_step(uint8_t atten_db) {
+  if (s_lim.atten_db == s_lim.rvc_db && atten_db > s_lim.rvc_db &&
+      s_lim.over_first_us != 0) {
+    uint64_t us = sim.time_us - s_lim.over_first_us;
+    s_lim.attacks++;
+    s_lim.attack_us_sum += us;
+    s_lim.attack_us_max = (us > s_lim.attack_us_max) ? us : s_lim.attack_us_max;
+    s_lim.over_first_us = 0;
+  }
+  if (s_lim.atten_db > s_lim.rvc_db && atten_db == s_lim.rvc_db) {
+    uint64_t us = sim.time_us - s_lim.over_last_us;
+    s_lim.releases++;
+    s_lim.release_us_sum += us;
+    s_lim.release_us_max =
+        (us > s_lim.release_us_max) ? us : s_lim.release_us_max;
+  }
+  if (atten_db > s_lim.rvc_db && atten_db - s_lim.rvc_db > s_lim.max_gr) {
+    s_lim.max_gr = atten_db - s_lim.rvc_db;
+  }
+  s_lim.atten_db = atten_db;
+}
+
+// Boot with the RVC at 0dB and the program on OUTMON, measuring from here on
+static void limiter_start(double gain) {
+  boot_blank(TICKS_PER_SECOND);
+  memset(&s_lim, 0, sizeof(s_lim));
+  s_lim.rvc_db = s_lim.atten_db = sim_lm1971.atten_db;
+  CHECK_EQ(s_lim.rvc_db, ref_default_atten(sim_adc.inputs[ADC_RVC]));
+  sim_audio.gain = gain;
+  sim_adc.source[ADC_OUTMON] = limiter_outmon;
+  sim.on_atten = limiter_step;
+}
+
+static void limiter_report(const char *label) {
+  printf("  %s: %u attack(s), mean %.1f ms, max %.1f ms; %u release(s), "
+         "mean %.0f ms, max %.0f ms; up to %u dB\n",
+         label, s_lim.attacks,
+         s_lim.attacks ? s_lim.attack_us_sum / 1e3 / s_lim.attacks : 0.0,
+         s_lim.attack_us_max / 1e3, s_lim.releases,
+         s_lim.releases ? s_lim.release_us_sum / 1e3 / s_lim.releases : 0.0,
+         s_lim.release_us_max / 1e3, s_lim.max_gr);
+}
+
+// A band loop: 2s at -6dB, 1s at +6dB (would clip), 2s at -6dB
+static void scenario_limiter(void) {
+  sim_audio_synth(SIM_AUDIO_BAND, 8.0);
+  limiter_start(0.5);
+
+  sim_run(2 * TICKS_PER_SECOND); // program peaks well below clipping
+  CHECK_EQ(s_lim.over_samples, 0);
+  CHECK_EQ(s_lim.attacks, 0);
+  CHECK_EQ(sim_lm1971.atten_db, s_lim.rvc_db);
+
+  sim_audio.gain = 2.0; // 6dB too hot
+  sim_run(TICKS_PER_SECOND / 2);
+  uint32_t over_attack = s_lim.over_samples;
+  CHECK_EQ(s_lim.attacks, 1);
+  // near-clip hits counted up to the next tick, then at most one tick of
+  // zero-crossing steps
+  CHECK(s_lim.attack_us_max <= 2 * 1000000 / TICKS_PER_SECOND);
+  // sustained peaks limited; the rare highest ones are let through rather
+  // than pinning it at LIMITER_MAX_DB
+  CHECK(s_lim.max_gr >= 3 && s_lim.max_gr < LIMITER_MAX_DB);
+  uint32_t samples = s_lim.samples, over = s_lim.over_samples;
+  sim_run(TICKS_PER_SECOND / 2);
+  double held_pct = 100.0 * (s_lim.over_samples - over) /
+                    (s_lim.samples - samples);
+  CHECK(held_pct < 1.0); // the rest of the loud part: (almost) no clipping
+
+  sim_audio.gain = 0.5;
+  sim_run(2 * TICKS_PER_SECOND);
+  CHECK_EQ(sim_lm1971.atten_db, s_lim.rvc_db);
+  CHECK(s_lim.releases >= 1);
+  // hold, then 1dB per LIMITER_RELEASE_MS_PER_DB, and up to two ticks
+  CHECK(s_lim.release_us_max >= LIMITER_HOLD_MS * 1000ULL);
+  CHECK(s_lim.release_us_max <=
+        (LIMITER_HOLD_MS + s_lim.max_gr * LIMITER_RELEASE_MS_PER_DB + 20) *
+            1000ULL);
+  CHECK_EQ(sim_lm1971.errors, 0);
+
+  limiter_report("band loop");
+  printf("  near-clip samples: %u in the first 500 ms of +6dB, %.2f%% after\n",
+         over_attack, held_pct);
+}
+
+// One pass of a recording: `ladybug_sim limiter_wav song.wav [gain]`
+static void limiter_wav(const char *path, double gain) {
+  if (!sim_audio_load_wav(path)) {
+    s_failures++;
+    return;
+  }
+  limiter_start(gain);
+  uint32_t samples = s_lim.samples; // boot-time conversions do not count
+  sim_run((uint32_t)(sim_audio_length_us() / (1000000 / TICKS_PER_SECOND)));
+  limiter_report(path);
+  printf("  %.1f s at gain %.2f: %.3f%% of OUTMON samples near clipping\n",
+         sim_audio_length_us() / 1e6, gain,
+         100.0 * s_lim.over_samples / (s_lim.samples - samples));
+}
+#endif
+
+#ifdef INCLUDE_HOWL_DETECTOR
+// Howl detection: latency from the feedback tone reaching the program's RMS
+// level (clearly audible) to the first added LM1971 step, and false
+// positives (steps up from the RVC setting with no feedback)
+static struct {
+  uint8_t rvc_db;       // attenuation without the detector
+  uint8_t atten_db;     // latched, as of the last step
+  uint32_t engages;     // steps up from rvc_db
+  uint8_t max_db;       // most attenuation added
+  double audible_db;    // program RMS, dBFS
+  uint64_t audible_us;  // feedback reached audible_db (0 = not yet)
+  uint64_t step_us;     // first step up since sim_howl_start() (0 = none)
+} s_howl;
+
+static uint8_t howl_outmon(uint64_t time_us) {
+  uint8_t v = sim_audio_outmon(time_us);
+  if (sim_howl.hz != 0 && s_howl.audible_us == 0 &&
+      sim_howl.level_db >= s_howl.audible_db) {
+    s_howl.audible_us = time_us;
+  }
+  return v;
+}
+
+static void howl_step(uint8_t atten_db) {
+  if (s_howl.atten_db == s_howl.rvc_db && atten_db > s_howl.rvc_db) {
+    s_howl.engages++;
+    if (sim_howl.hz != 0 && s_howl.step_us == 0) {
+      s_howl.step_us = sim.time_us;
+    }
+  }
+  if (atten_db > s_howl.rvc_db && atten_db - s_howl.rvc_db > s_howl.max_db) {
+    s_howl.max_db = atten_db - s_howl.rvc_db;
+  }
+  s_howl.atten_db = atten_db;
+}
+
+// Boot with the RVC at 0dB, then play `program` (the one loaded, if < 0)
+static void howl_boot(void) {
+  boot_blank(TICKS_PER_SECOND);
+  memset(&s_howl, 0, sizeof(s_howl));
+  s_howl.rvc_db = s_howl.atten_db = sim_lm1971.atten_db;
+  memset(&sim_howl, 0, sizeof(sim_howl));
+  sim_adc.source[ADC_OUTMON] = howl_outmon;
+  sim.on_atten = howl_step;
+}
+
+static void howl_program(int program, double gain) {
+  if (program >= 0) {
+    sim_audio_synth((sim_audio_program_t)program, 20.0);
+  }
+  sim_audio.gain = gain;
+  s_howl.audible_db = sim_audio_rms_db();
+}
+
+// Wait for the attenuation to be fully released, then count false positives
+// over `seconds`; returns steps up per minute
+static double howl_false_positives(uint32_t seconds) {
+  sim_howl.hz = 0;
+  for (uint32_t i = 0; i < 20 && sim_lm1971.atten_db != s_howl.rvc_db; i++) {
+    sim_run(TICKS_PER_SECOND);
+  }
+  sim_run(TICKS_PER_SECOND); // and no pending detection
+  if (seconds == 0) {
+    return 0;
+  }
+  uint32_t engages = s_howl.engages;
+  sim_run(seconds * TICKS_PER_SECOND);
+  return (s_howl.engages - engages) * 60.0 / seconds;
+}
+
+// Feedback at `hz`, 2dB per trip, from -60dBFS; returns the latency in ms
+// (negative: attenuated before it was audible, or never: 1e9)
+static double howl_latency(double hz) {
+  howl_false_positives(0); // released, and quiet
+  s_howl.audible_us = s_howl.step_us = 0;
+  s_howl.max_db = 0;
+  sim_howl_start(hz, 2.0, -60.0);
+  for (uint32_t i = 0; i < 2 * TICKS_PER_SECOND && s_howl.step_us == 0; i++) {
+    sim_run(1);
+  }
+  sim_run(TICKS_PER_SECOND); // let it die away
+  if (s_howl.step_us == 0 || s_howl.audible_us == 0) {
+    return (s_howl.step_us != 0) ? -1e9 : 1e9;
+  }
+  return ((double)s_howl.step_us - (double)s_howl.audible_us) / 1000.0;
+}
+
+// Band loop at -6dB: no false positives; 1kHz and 2.5kHz feedback pulled
+// down within 100ms of being audible, before it saturates, and dying away
+static void scenario_howl(void) {
+  static const double hz[] = {1000, 2500};
+
+  howl_boot();
+  howl_program(SIM_AUDIO_BAND, 0.5);
+  CHECK_EQ(howl_false_positives(10), 0);
+
+  for (size_t i = 0; i < sizeof(hz) / sizeof(hz[0]); i++) {
+    double ms = howl_latency(hz[i]);
+    CHECK(ms > -1e8 && ms <= 100);
+    CHECK(sim_howl.max_db < 0);
+    CHECK(s_howl.max_db > 0 && s_howl.max_db <= HOWL_MAX_DB);
+    CHECK(sim_howl.level_db <= -40); // loop gain < 1 now
+    printf("  %4.0f Hz feedback: attenuated %.0f ms after reaching the "
+           "program RMS (%.1f dBFS), peak %.0f dBFS, +%u dB\n",
+           hz[i], ms, s_howl.audible_db, sim_howl.max_db, s_howl.max_db);
+  }
+
+  // held, then released back to the RVC setting
+  sim_howl.hz = 0;
+  CHECK(sim_lm1971.atten_db > s_howl.rvc_db);
+  sim_run((HOWL_HOLD_MS + HOWL_MAX_DB * HOWL_RELEASE_MS_PER_DB) /
+          (1000 / TICKS_PER_SECOND));
+  CHECK_EQ(sim_lm1971.atten_db, s_howl.rvc_db);
+  CHECK_EQ(sim_lm1971.errors, 0);
+}
+
+static const double s_howl_hz[] = {315, 630, 1000, 1600, 2500, 3150};
+#define HOWL_FREQS (sizeof(s_howl_hz) / sizeof(s_howl_hz[0]))
+
+static void howl_bench_row(const char *name, int program) {
+  howl_program(program, 0.5);
+  double fp = howl_false_positives(60);
+  printf("  %-12s %6.1f dBFS %5.1f/min", name, s_howl.audible_db, fp);
+  for (size_t f = 0; f < HOWL_FREQS; f++) {
+    double ms = howl_latency(s_howl_hz[f]);
+    if (ms > 1e8) {
+      printf("     miss");
+    } else if (ms < -1e8) {
+      printf("    early");
+    } else {
+      printf(" %5.0f/%-2.0f", ms, sim_howl.max_db);
+    }
+  }
+  printf("\n");
+}
+
+// `ladybug_sim howl_bench [file.wav ...]`: every synthesized program, and
+// any recordings, at -6dB
+static void howl_bench(int files, char **paths) {
+  howl_boot();
+  printf("  latency ms / peak dBFS of 2dB-per-trip feedback at:\n");
+  printf("  %-12s %11s %9s", "program", "RMS", "false pos");
+  for (size_t f = 0; f < HOWL_FREQS; f++) {
+    printf(" %6.0f Hz", s_howl_hz[f]);
+  }
+  printf("\n");
+  for (int p = 0; p < SIM_AUDIO_PROGRAMS; p++) {
+    howl_bench_row(sim_audio_names[p], p);
+  }
+  for (int i = 0; i < files; i++) {
+    if (sim_audio_load_wav(paths[i])) {
+      const char *name = strrchr(paths[i], '/');
+      howl_bench_row(name ? name + 1 : paths[i], -1);
+    }
+  }
+}
+#endif
+
+#ifdef INCLUDE_LOUDNESS_TRIM
+// Loudness trim: the LM1971 setting minus the RVC's (no limiter or howl
+// detector in this build)
+static uint8_t s_loud_rvc_db;
+
+static int loudness_trim(void) {
+  return (int)sim_lm1971.atten_db - s_loud_rvc_db;
+}
+
+// Power up with SW2 (P1.5) held down, to toggle the loudness trim, and the
+// RVC at about 10dB; the program plays on OUTMON
+static void loudness_boot(bool blank) {
+  if (blank) {
+    sim_erase_eeprom();
+  }
+  sim_reset();
+  for (int v = 0; v <= 0xE0; v++) {
+    if (ref_default_atten((uint8_t)v) == 10) {
+      sim_adc.inputs[ADC_RVC] = (uint8_t)v;
+      break;
+    }
+  }
+  s_loud_rvc_db = ref_default_atten(sim_adc.inputs[ADC_RVC]);
+  sim_pins.p15 = 0;
+  sim_power_on(TICKS_PER_SECOND);
+  sim_pins.p15 = 1;
+  sim_run(PREFS_COMMIT_TICKS);
+  sim_audio.gain = 1.0;
+  sim_adc.source[ADC_OUTMON] = sim_audio_outmon;
+}
+
+// Play `seconds` of the loaded program, printing the trim once a second;
+// returns the seconds until it last changed
+static uint32_t loudness_play(const char *label, uint32_t seconds) {
+  uint32_t settled = 0;
+  int trim = loudness_trim();
+  printf("  %-12s %6.1f dBFS: trim", label, sim_audio_rms_db());
+  for (uint32_t i = 1; i <= seconds; i++) {
+    sim_run(TICKS_PER_SECOND);
+    if (loudness_trim() != trim) {
+      trim = loudness_trim();
+      settled = i;
+    }
+    printf(" %+d", trim);
+  }
+  printf(" (settled after %u s)\n", settled);
+  return settled;
+}
+
+// The band loop as five songs, 20s each, at the target RMS, then 4dB louder,
+// 4dB quieter, 12dB louder and 12dB quieter: the trim follows each one
+// within a few seconds, 1dB per step, within +/-LOUDNESS_TRIM_MAX_DB
+static void scenario_loudness(void) {
+  static const int songs_db[] = {0, 4, -4, 12, -12};
+
+  loudness_boot(true);
+  CHECK_EQ(latest_pref() & 0x10, 0x10); // turned on, and saved
+  CHECK_EQ(loudness_trim(), 0);
+
+  sim_audio_synth(SIM_AUDIO_BAND, 8.0);
+  double rms_db = sim_audio_rms_db(); // at gain 1.0
+  int offset = 0; // trim for the band at the target (frames vs. song RMS)
+  uint32_t max_settled = 0;
+  for (size_t i = 0; i < sizeof(songs_db) / sizeof(songs_db[0]); i++) {
+    char label[16];
+    sim_audio.gain =
+        pow(10, (songs_db[i] - LOUDNESS_TARGET_DBFS - rms_db) / 20.0);
+    snprintf(label, sizeof(label), "band %+ddB", songs_db[i]);
+    uint32_t settled = loudness_play(label, 20);
+    max_settled = (settled > max_settled) ? settled : max_settled;
+    if (i == 0) {
+      offset = loudness_trim();
+      CHECK(abs(offset) <= 3);
+    }
+    int expected = songs_db[i] + offset;
+    expected = (expected > LOUDNESS_TRIM_MAX_DB) ? LOUDNESS_TRIM_MAX_DB
+               : (expected < -LOUDNESS_TRIM_MAX_DB) ? -LOUDNESS_TRIM_MAX_DB
+                                                     : expected;
+    CHECK(abs(loudness_trim() - expected) <= 1);
+  }
+  CHECK(max_settled <= 15);
+
+  // silence between songs: the trim stays where it was
+  int trim = loudness_trim();
+  sim_audio.gain = 0;
+  sim_run(5 * TICKS_PER_SECOND);
+  CHECK_EQ(loudness_trim(), trim);
+
+  // power cycle with SW2 held again: off, and the RVC's attenuation alone
+  loudness_boot(false);
+  CHECK_EQ(latest_pref() & 0x10, 0);
+  sim_audio.gain = 1.0;
+  sim_run(10 * TICKS_PER_SECOND);
+  CHECK_EQ(loudness_trim(), 0);
+  CHECK_EQ(sim_lm1971.errors, 0);
+}
+
+// `ladybug_sim loudness_wav a.wav b.wav ...`: each recording once, in order,
+// at its own level, like a set list
+static void loudness_wav(int files, char **paths) {
+  loudness_boot(true);
+  clock_t start = clock();
+  double played = 0;
+  for (int i = 0; i < files; i++) {
+    if (!sim_audio_load_wav(paths[i])) {
+      s_failures++;
+      continue;
+    }
+    const char *name = strrchr(paths[i], '/');
+    uint32_t seconds = (uint32_t)(sim_audio_length_us() / 1000000);
+    loudness_play(name ? name + 1 : paths[i], seconds);
+    played += seconds;
+  }
+  double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+  printf("  %.0f s of audio in %.2f s (%.0fx real time)\n", played, elapsed,
+         played / elapsed);
+}
+#endif
+
+static void scenario_led_mode_switch(void) {
+  boot_blank(TICKS_PER_SECOND);
+
+  press(&sim_pins.p16); // user's LEFT switch: LED mode -> VU meter
+  sim_run(PREFS_COMMIT_TICKS);
+  CHECK_EQ(latest_pref() & 0x06, 0x02);
+
+  press(&sim_pins.p16); // LED mode -> solid RED
+  sim_run(5);
+  CHECK_EQ(sim_pca.ccap[LED_RED], DUTY_RED);
+  CHECK_EQ(sim_pca.ccap[LED_GREEN], 0);
+  sim_run(PREFS_COMMIT_TICKS);
+  CHECK_EQ(latest_pref() & 0x06, 0x04);
+}
+
+// Preferences are written once, from the main loop, after the presses stop
+static void scenario_prefs_write_behind(void) {
+  boot_blank(TICKS_PER_SECOND);
+  uint32_t writes = sim_iap.writes;
+
+  for (int i = 0; i < 5; i++) {
+    press(&sim_pins.p16); // cycle through the LED modes, to solid WHITE
+    sim_run(TICKS_PER_SECOND / 2);
+  }
+  sim_run(3 * TICKS_PER_SECOND - TICKS_PER_SECOND / 2 - 10);
+  CHECK_EQ(sim_iap.writes, writes); // still within the quiet period
+  sim_run(20);
+  CHECK_EQ(sim_iap.writes, writes + 1);
+  CHECK_EQ(latest_pref() & 0x06, (5 & 0x3) << 1);
+
+  // committed: the main loop's check after every wake-up leaves EA alone
+  press(&sim_pins.p16); // ... -> BATTERY MONITOR
+  sim_run(TICKS_PER_SECOND / 2);
+  press(&sim_pins.p16); // -> VU meter (Timer2 wake-ups at VU_SAMPLE_HZ)
+  sim_run(PREFS_COMMIT_TICKS);
+  uint32_t ea_offs = sim_cpu.ea_offs;
+  sim_run(TICKS_PER_SECOND);
+  CHECK_EQ(sim_cpu.ea_offs - ea_offs, 0);
+
+  // a full sector: the rotation erase happens outside the ISR too
+  sim_erase_eeprom();
+  sim_iap.eeprom[PREF_SECTOR_ADDR(0)] = PREF_HEADER_FIRST;
+  memset(&sim_iap.eeprom[PREF_SECTOR_ADDR(0) + 1], 0x00, PREF_SECTOR_SLOTS - 1);
+  sim_reset();
+  sim_power_on(TICKS_PER_SECOND);
+  sim.isr_busy_us_max = 0;
+  press(&sim_pins.p15); // RVC curve -> Traditional MA-220
+  sim_run(PREFS_COMMIT_TICKS);
+  CHECK_EQ(pref_erases(1), 1);
+  CHECK_EQ(latest_pref(), 0x08);
+  CHECK_EQ(sim_iap.isr_writes, 0);
+  CHECK_EQ(sim_iap.isr_erases, 0);
+  CHECK(sim.isr_busy_us_max < 1000);
+}
+
+static void scenario_rvc_mode_persists(void) {
+  boot_blank(TICKS_PER_SECOND);
+
+  sim_adc.inputs[ADC_RVC] = 0xC0; // RVC turned all the way down
+  sim_run(TICKS_PER_SECOND);
+  CHECK_EQ(sim_lm1971.atten_db, 64); // Default curve => MUTE
+
+  press(&sim_pins.p15); // user's RIGHT switch: Traditional MA-220 curve
+  sim_run(PREFS_COMMIT_TICKS);
+  CHECK_EQ(sim_lm1971.atten_db, 12); // Traditional curve => -12dB, not MUTE
+  CHECK_EQ(latest_pref() & 0x08, 0x08);
+
+  // power cycle: the curve must come back from EEPROM
+  sim_reset();
+  sim_adc.inputs[ADC_RVC] = 0xC0;
+  sim_power_on(TICKS_PER_SECOND);
+  CHECK_EQ(sim_lm1971.atten_db, 12);
+}
+
+static void scenario_low_battery(void) {
+  boot_blank(TICKS_PER_SECOND);
+
+  sim_adc.inputs[ADC_BATTMON] = 60; // about 4V
+  sim_run(2 * TICKS_PER_SECOND);
+
+  uint16_t lo = 0xFFFF, hi = 0;
+  for (int i = 0; i < 40; i++) {
+    sim_run(5);
+    uint16_t r = sim_pca.ccap[LED_RED];
+    lo = (r < lo) ? r : lo;
+    hi = (r > hi) ? r : hi;
+    CHECK_EQ(sim_pca.ccap[LED_GREEN], 0);
+  }
+  CHECK(hi > lo); // pulsing, not solid
+  CHECK_EQ(hi, DUTY_RED);
+  CHECK_EQ(lo, 0);
+}
+
+// Perceived brightness (0-1) of `duty` counts out of `full`
+static double led_lightness(double duty, double full) {
+  return pow(duty / full, 1 / 2.2);
+}
+
+// Largest / smallest change in perceived brightness between the lit steps of
+// a fade (duties out of `full`, in order, repeats already removed)
+static double fade_step_ratio(const uint16_t *duty, int count, double full) {
+  double lo = 1, hi = 0;
+  for (int i = 1; i < count; i++) {
+    if (duty[i - 1] == 0 || duty[i] == 0) {
+      continue;
+    }
+    double d = fabs(led_lightness(duty[i], full) - led_lightness(duty[i - 1], full));
+    lo = (d < lo) ? d : lo;
+    hi = (d > hi) ? d : hi;
+  }
+  return hi / lo;
+}
+
+// The gamma table, exhaustively against the formula in tools/gen_led_gamma.py,
+// then the dim end of the VU green ramp and the low battery pulse against the
+// old 8-bit linear PWM (green = b * 33 / 191, red 6-78 in steps of 6, out of
+// 256).  Clocks per set_rgb() are a hand count of the SDCC code on the 1T core
+// (three MOVs to CCAPnH vs. three 16-bit MOVC lookups, each with a
+// read-modify-write of XCCAPnH in PCA_PWMn); use `make bench-s51` for the ISR.
+#define SET_RGB_OLD_CLOCKS 12
+#define SET_RGB_NEW_CLOCKS 84
+static void scenario_led_gamma(void) {
+  for (int p = 0; p <= 0xFF; p++) {
+    int ref = (int)(LED_GAMMA_DUTY_MAX * pow(p / 255.0, 2.2) + 0.5);
+    ref = (p != 0 && ref == 0) ? 1 : ref;
+    CHECK_EQ(led_gamma_table[p], ref);
+  }
+
+  // VU green ramp, bottom half of the green zone: how many distinct
+  // brightnesses, how bright the first lit one is, and the largest jump
+  boot_blank(TICKS_PER_SECOND);
+  int old_levels = 0, new_levels = 0;
+  uint16_t old_prev = 0, new_prev = 0;
+  double old_first = 0, new_first = 0, old_jump = 0, new_jump = 0;
+  for (int b = 1; b < 96; b++) {
+    uint8_t r, g, blue;
+    ref_vu_color((uint8_t)b, &r, &g, &blue);
+    set_rgb(r, g, blue);
+    CHECK_EQ(sim_pca.ccap[LED_GREEN], led_gamma_table[g]);
+    CHECK_EQ(sim_pca.ccap[LED_RED] + sim_pca.ccap[LED_BLUE], 0);
+
+    uint16_t old_duty = (uint16_t)(b * 33 / 191);
+    uint16_t new_duty = sim_pca.ccap[LED_GREEN];
+    if (old_duty != old_prev) {
+      double jump = led_lightness(old_duty, 256) - led_lightness(old_prev, 256);
+      old_first = (old_prev == 0) ? jump : old_first;
+      old_jump = (old_prev != 0 && jump > old_jump) ? jump : old_jump;
+      old_levels++;
+    }
+    if (new_duty != new_prev) {
+      double jump = led_lightness(new_duty, 1024) - led_lightness(new_prev, 1024);
+      new_first = (new_prev == 0) ? jump : new_first;
+      new_jump = (new_prev != 0 && jump > new_jump) ? jump : new_jump;
+      new_levels++;
+    }
+    old_prev = old_duty;
+    new_prev = new_duty;
+  }
+  CHECK(new_levels > old_levels);
+  CHECK(new_first < old_first);
+  CHECK(new_jump < old_jump);
+  printf("  VU green, b 1-95: %d levels, first %.1f%%, max step %.1f%%"
+         " (8-bit linear: %d levels, first %.1f%%, max step %.1f%%)\n",
+         new_levels, 100 * new_first, 100 * new_jump, old_levels,
+         100 * old_first, 100 * old_jump);
+
+  // low battery pulse: every step the same change in brightness
+  sim_adc.inputs[ADC_BATTMON] = 60; // about 4V
+  sim_run(2 * TICKS_PER_SECOND);
+  uint16_t pulse[64];
+  int n = 0;
+  for (int i = 0; i < 300 && n < 64; i++) {
+    sim_run(1);
+    if (n == 0 || sim_pca.ccap[LED_RED] != pulse[n - 1]) {
+      pulse[n++] = sim_pca.ccap[LED_RED];
+    }
+  }
+  uint16_t old_pulse[13];
+  for (int i = 0; i < 13; i++) {
+    old_pulse[i] = (uint16_t)(6 * (i + 1));
+  }
+  double ratio = fade_step_ratio(pulse, n, 1024);
+  double old_ratio = fade_step_ratio(old_pulse, 13, 256);
+  CHECK(ratio < 1.5);
+  CHECK(ratio < old_ratio);
+  printf("  low battery pulse: largest/smallest step %.2f (8-bit linear: %.2f)\n",
+         ratio, old_ratio);
+
+  // cost: set_rgb() runs once per LED frame, whatever the mode
+  press(&sim_pins.p16); // LED mode -> VU meter (the battery is fine again)
+  sim_adc.inputs[ADC_BATTMON] = 0xFF;
+  sim_run(TICKS_PER_SECOND);
+  uint32_t updates = sim_pca.updates;
+  sim_run(10 * TICKS_PER_SECOND);
+  double per_s = (sim_pca.updates - updates) / 3 / 10.0;
+  double share = 100.0 * per_s * SET_RGB_NEW_CLOCKS / SIM_SYSCLOCK_HZ;
+  double old_share = 100.0 * per_s * SET_RGB_OLD_CLOCKS / SIM_SYSCLOCK_HZ;
+  CHECK(share - old_share < 0.1);
+  printf("  %.0f set_rgb()/s x ~%d clocks = %.3f%% CPU (8-bit: ~%d clocks ="
+         " %.3f%%); table %u bytes of code\n",
+         per_s, SET_RGB_NEW_CLOCKS, share, SET_RGB_OLD_CLOCKS, old_share,
+         (unsigned)sizeof(led_gamma_table));
+}
+
+// Solid LED, RVC left alone
+static double steady_energy(uint32_t seconds) {
+  boot_blank(TICKS_PER_SECOND);
+  sim_adc.inputs[ADC_RVC] = 0x40;
+  press(&sim_pins.p16); // LED mode -> VU meter
+  press(&sim_pins.p16); // LED mode -> solid RED
+  memset(&sim_energy, 0, sizeof(sim_energy));
+  sim_energy.adc_on_since_us = sim.time_us; // in case it is ON already
+  sim_run(seconds * TICKS_PER_SECOND);
+  return sim_energy_report("solid RED, steady RVC");
+}
+
+#ifdef INCLUDE_POWER_DOWN
+// The same with the LED OFF: the case power-down is for
+static double dark_energy(uint32_t seconds) {
+  boot_blank(TICKS_PER_SECOND);
+  sim_adc.inputs[ADC_RVC] = 0x40;
+  led_mode = LED_MODE_OFF;
+  sim_run(5);
+  memset(&sim_energy, 0, sizeof(sim_energy));
+  sim_energy.adc_on_since_us = sim.time_us;
+  sim_run(seconds * TICKS_PER_SECOND);
+  return sim_energy_report("LED OFF, steady RVC");
+}
+#endif
+
+static void scenario_energy(void) {
+  double ua = steady_energy(60);
+  CHECK(ua > 0);
+  CHECK_EQ(sim_energy.power_down_us, 0); // the LED is lit: IDLE
+  CHECK_EQ(sim_pca.ccap[LED_RED], DUTY_RED);
+#ifdef INCLUDE_POWER_DOWN
+  CHECK(slow_tick);
+  CHECK(sim_energy.wakes < 60 * 50); // 40/s from 3s on, not 100/s
+  ua = dark_energy(60);
+  CHECK(ua > 0);
+  CHECK(sim_energy.power_down_us > 50 * 1000000ULL); // asleep after 3s
+  // the ADC draws its current through each 10ms settle sleep too
+  CHECK(sim_energy.adc_on_us >= 59 * 1000000ULL / 5);
+#endif
+}
+
+#ifdef INCLUDE_POWER_DOWN
+static void scenario_power_down(void) {
+  boot_blank(TICKS_PER_SECOND);
+  sim_adc.inputs[ADC_RVC] = 0x40;
+  press(&sim_pins.p16); // LED mode -> VU meter: never powers down
+  sim_run(5 * TICKS_PER_SECOND);
+  CHECK_EQ(sim_cpu.power_downs, 0);
+
+  press(&sim_pins.p16); // LED mode -> solid RED: lit, IDLE on a slow Timer0
+  sim_run(5 * TICKS_PER_SECOND);
+  CHECK_EQ(sim_cpu.power_downs, 0);
+  CHECK(slow_tick);
+  CHECK_EQ(sim_pca.running, 1);
+  CHECK_EQ(sim_pca.ccap[LED_RED], DUTY_RED);
+
+  // still 20Hz RVC sampling with a settled ADC, two wakes per 50ms
+  uint32_t unsettled = sim_adc.unsettled_conversions;
+  uint32_t rvc = sim_adc.conversions[ADC_RVC];
+  uint32_t wakes = sim_energy.wakes;
+  sim_run(2 * TICKS_PER_SECOND);
+  CHECK_EQ(sim_adc.conversions[ADC_RVC] - rvc, 2 * 20);
+  CHECK_EQ(sim_adc.unsettled_conversions, unsettled);
+  CHECK_EQ(sim_energy.wakes - wakes, 2 * 40);
+  CHECK_EQ(sim_pca.ccap[LED_RED], DUTY_RED);
+
+  // the knob wakes it back to 100Hz
+  sim_adc.inputs[ADC_RVC] = 0x50;
+  sim_run(2 * 5 + 64 / ATTEN_SLEW_STEPS_PER_TICK);
+  CHECK(!slow_tick);
+  CHECK_EQ(sim_lm1971.atten_db, ref_default_atten(0x50));
+
+  led_mode = LED_MODE_OFF;
+  sim_run(5 * TICKS_PER_SECOND);
+  CHECK(sim_cpu.power_downs > 0);
+  CHECK_EQ(sim_pca.running, 0);
+  CHECK_EQ(latest_pref() & 0x06, 0x04); // committed before sleeping
+  uint8_t atten = sim_lm1971.atten_db;
+
+  // asleep, each wake gives the ADC POWER_DOWN_ADC_SETTLE_MS from power-on
+  unsettled = sim_adc.unsettled_conversions;
+  rvc = sim_adc.conversions[ADC_RVC];
+  sim_run(2 * TICKS_PER_SECOND);
+  CHECK_EQ(sim_adc.conversions[ADC_RVC] - rvc, 2 * 20); // still 20Hz
+  CHECK_EQ(sim_adc.unsettled_conversions, unsettled);
+  CHECK_EQ(sim_pca.running, 0);
+
+  // turning the knob wakes it up; the attenuator follows as usual
+  sim_adc.inputs[ADC_RVC] = 0x70;
+  sim_run(2 * 5 + 64 / ATTEN_SLEW_STEPS_PER_TICK);
+  CHECK(sim_lm1971.atten_db != atten);
+  CHECK_EQ(sim_lm1971.atten_db, ref_default_atten(0x70));
+  CHECK_EQ(sim_pca.running, 1);
+  CHECK_EQ(led_rgb(), 0);
+
+  // a switch press from power-down is still debounced and handled
+  sim_run(5 * TICKS_PER_SECOND);
+  CHECK_EQ(sim_pca.running, 0);
+  press(&sim_pins.p16); // LED mode -> solid RED again
+  sim_run(5);
+  CHECK_EQ(sim_pca.ccap[LED_RED], DUTY_RED);
+  uint32_t power_downs = sim_cpu.power_downs;
+  sim_run(5 * TICKS_PER_SECOND);
+  CHECK_EQ(sim_cpu.power_downs, power_downs); // lit again: IDLE
+  CHECK(slow_tick);
+  CHECK_EQ(sim_pca.ccap[LED_RED], DUTY_RED);
+
+  // a low battery is still noticed (once a second) and shown
+  sim_adc.inputs[ADC_RVC] = 0x60;
+  sim_run(2 * 5);
+  led_mode = LED_MODE_OFF;
+  sim_run(5 * TICKS_PER_SECOND);
+  CHECK_EQ(sim_pca.running, 0);
+  sim_adc.inputs[ADC_BATTMON] = 60;
+  sim_run(3 * TICKS_PER_SECOND);
+  CHECK_EQ(sim_pca.running, 1);
+  CHECK_EQ(sim_cpu.et0, 1);
+  CHECK_EQ(sim_lm1971.errors, 0);
+  CHECK_EQ(sim_adc.unpowered_conversions, 0);
+}
+#endif
+
+#ifdef INCLUDE_DISPLAY
+// src/i2c_queue.c state, and what src/ssd1306.c sends
+extern volatile bool i2c_busy;
+extern volatile uint8_t i2c_errors;
+extern volatile uint8_t i2c_head, i2c_tail, i2c_reap;
+bool i2c_write_byte(uint8_t dev, uint8_t reg, uint8_t value, void (*done)(uint8_t));
+void I2C_Routine(void);
+#define I2C_MSIF 0x40          // I2CMSST: the last command is done
+#define I2C_PORT_PINS 0x30     // P2.5/P2.4: I2C_PORT in sim/Makefile
+#define I2C_PORT_GPIO 2
+#define I2C_PORT_SELECT 0x01   // I2C_AlterPort_P25_P24
+#define SSD1306_I2C_ADDR 0x78
+#define SSD1306_NOP 0xE3
+#define DISPLAY_START_TICKS 10 // src/main.c DISPLAY_START_TICK: 100ms
+#define SSD1306_INIT_BYTES 31  // SSD1306_InitCommands[]
+#define SSD1306_WINDOW_BYTES 6 // SSD1306_Window[]
+#define SSD1306_FRAME_BYTES (128 * 32 / 8)
+#define I2C_TIMEOUT_TICKS 2
+
+// Ticks are due every 10ms from the first one; a tick that starts later was
+// held up by main() or another ISR
+static uint64_t s_tick_late_us_max;
+
+static void track_tick_late(uint32_t tick) {
+  uint64_t due_us = sim.boot_us + (uint64_t)tick * 1000000 / TICKS_PER_SECOND;
+  if (sim.time_us > due_us && sim.time_us - due_us > s_tick_late_us_max) {
+    s_tick_late_us_max = sim.time_us - due_us;
+  }
+}
+
+// The SSD1306 is started 100ms after the first Timer0 tick: its init
+// sequence, window and blank frame (one control byte + 512 bytes) go out from
+// the I2C interrupt, one interrupt per command, while every 100Hz tick still
+// starts on time.  The frame takes longer than a tick on the bus, which
+// FwLib's I2C_Write() would have spent busy-waiting.
+static void scenario_display_i2c(void) {
+  s_tick_late_us_max = 0;
+  boot_blank(DISPLAY_START_TICKS - 1);
+  sim.on_tick = track_tick_late;
+  CHECK_EQ(sim_i2c.log_len, 0);
+
+  uint32_t start = sim.ticks;
+  while (sim_i2c.transfers < 3 && sim.ticks < start + TICKS_PER_SECOND) {
+    sim_run(1);
+  }
+  uint32_t ticks = sim.ticks - start;
+  sim_run(3 * TICKS_PER_SECOND); // after the version flashes
+  sim.on_tick = NULL;
+
+  uint32_t sent = SSD1306_INIT_BYTES + SSD1306_WINDOW_BYTES + SSD1306_FRAME_BYTES;
+  CHECK_EQ(sim_i2c.transfers, 3);
+  CHECK_EQ(sim_i2c.nacks, 0);
+  CHECK_EQ(sim_i2c.log_len, sent + 3); // + a control byte each
+  CHECK_EQ(sim_i2c.irqs, sent + 3 * 3); // + address, control byte, STOP each
+  CHECK_EQ(sim_cpu.xfr_errors, 0);
+  CHECK_EQ(i2c_errors, 0);
+  CHECK(!i2c_busy);
+  CHECK_EQ((sim_cpu.p_sw2 >> 4) & 0x03, I2C_PORT_SELECT); // i2c_init()
+  CHECK_EQ(sim_cpu.od_pins[I2C_PORT_GPIO], I2C_PORT_PINS);
+
+  const uint8_t *log = sim_i2c.log;
+  CHECK_EQ(log[0], 0x00); // commands
+  CHECK_EQ(log[1], 0xAE); // display off...
+  CHECK_EQ(log[SSD1306_INIT_BYTES], 0xAF); // ...and on again
+  const uint8_t *window = log + SSD1306_INIT_BYTES + 1;
+  CHECK_EQ(window[0], 0x00);
+  CHECK_EQ(window[1], 0x21);
+  CHECK_EQ(window[3], 127);
+  CHECK_EQ(window[4], 0x22);
+  CHECK_EQ(window[6], 3);
+  const uint8_t *frame = window + SSD1306_WINDOW_BYTES + 1;
+  CHECK_EQ(frame[0], 0x40); // data
+  int lit = 0;
+  for (int i = 1; i <= SSD1306_FRAME_BYTES; i++) {
+    lit += frame[i] != 0;
+  }
+  CHECK_EQ(lit, 0); // cleared
+
+  CHECK(sim_i2c.busy_us > 1000000 / TICKS_PER_SECOND);
+  CHECK(ticks > 1);
+  CHECK_EQ(s_tick_late_us_max, 0);
+  CHECK_EQ(sim_pca.ccap[LED_GREEN], DUTY_GREEN); // battery monitor as usual
+  printf("  %u bytes in %u transfers: %.1f ms on the bus over %u ticks, "
+         "%u interrupts, no tick late\n",
+         sent + 3, sim_i2c.transfers, sim_i2c.busy_us / 1000.0, ticks, sim_i2c.irqs);
+}
+
+// A device holding SCL low: every queued transfer is abandoned after
+// I2C_TIMEOUT_TICKS without an interrupt, the I2C peripheral is reset, and
+// the rest of the firmware carries on
+static void scenario_display_i2c_stuck(void) {
+  s_tick_late_us_max = 0;
+  boot_blank(1);
+  sim_i2c.stuck = true;
+  sim.on_tick = track_tick_late;
+  sim_run(DISPLAY_START_TICKS + 3 * (I2C_TIMEOUT_TICKS + 1));
+  CHECK_EQ(sim_i2c.resets, 3);
+  CHECK_EQ(i2c_errors, 3);
+  CHECK(!i2c_busy);
+
+  sim_run(3 * TICKS_PER_SECOND); // after the version flashes
+  sim.on_tick = NULL;
+  CHECK_EQ(sim_i2c.resets, 3); // nothing queued since
+  CHECK_EQ(sim_i2c.transfers, 0);
+  CHECK_EQ(s_tick_late_us_max, 0);
+  CHECK_EQ(sim_lm1971.atten_db, 0);
+  CHECK_EQ(sim_pca.ccap[LED_GREEN], DUTY_GREEN);
+}
+
+// A stray I2C interrupt with nothing on the bus (after i2c_init()'s Wait
+// command, or a reset) changes nothing: no command, no slot taken or freed.
+// The next transfer then goes out as usual.
+static void scenario_display_i2c_spurious(void) {
+  boot_blank(DISPLAY_START_TICKS + TICKS_PER_SECOND);
+  CHECK_EQ(sim_i2c.transfers, 3);
+  CHECK(!i2c_busy);
+  uint8_t head = i2c_head, tail = i2c_tail, reap = i2c_reap;
+  uint32_t log_len = sim_i2c.log_len;
+
+  for (int i = 0; i < 3; i++) {
+    sim_i2c.msst |= I2C_MSIF;
+    sim_cpu.in_isr = 1;
+    I2C_Routine();
+    sim_cpu.in_isr = 0;
+    CHECK(!(sim_i2c.msst & I2C_MSIF));
+  }
+  CHECK_EQ(sim_i2c.cmd, 0);
+  CHECK(!i2c_busy);
+  CHECK_EQ(i2c_head, head);
+  CHECK_EQ(i2c_tail, tail);
+  CHECK_EQ(i2c_reap, reap);
+  CHECK_EQ(sim_i2c.transfers, 3);
+  CHECK_EQ(sim_i2c.log_len, log_len);
+  CHECK_EQ(sim_cpu.xfr_errors, 0);
+
+  CHECK(i2c_write_byte(SSD1306_I2C_ADDR, 0x00, SSD1306_NOP, NULL));
+  sim_run(2);
+  CHECK_EQ(sim_i2c.transfers, 4);
+  CHECK_EQ(sim_i2c.log_len, log_len + 2); // control byte + NOP
+  CHECK_EQ(sim_i2c.log[log_len + 1], SSD1306_NOP);
+  CHECK_EQ(i2c_errors, 0);
+  CHECK(!i2c_busy);
+  CHECK_EQ(i2c_reap, i2c_tail); // reaped by i2c_poll()
+}
+#endif
+
+// The Timer0 task table: every period divides the 1s cycle, and the heavy
+// tasks of the 20Hz frame (RVC, VU meter, LEDs, and the battery monitor once
+// a second) never share a tick.  With INCLUDE_SCHED_STATS, 10s of VU meter
+// mode with the RVC moving: run counts match the table and nothing overruns.
+// The sim's Timer0 only counts modelled time (ADC waits, IAP, LM1971 pin
+// clocks), so every cost must be 0; make bench-s51 counts cycles.
+static const struct {
+  void (*run)(void);
+  const char *name;
+  bool heavy;
+} s_sched_names[] = {
+    {task_adc_power, "adc_power", false}, {task_adc_start, "adc_start", false},
+    {task_rvc, "rvc", true},              {task_vu_meter, "vu_meter", true},
+    {handle_leds, "leds", true},          {handle_battmon, "battmon", true},
+};
+
+static int sched_name(void (*run)(void)) {
+  for (size_t n = 0; n < sizeof(s_sched_names) / sizeof(s_sched_names[0]); n++) {
+    if (s_sched_names[n].run == run) {
+      return (int)n;
+    }
+  }
+  return -1;
+}
+
+static void scenario_scheduler(void) {
+  int busiest = 0;
+  for (int tick = 0; tick < TICKS_PER_SECOND; tick++) {
+    int heavy = 0;
+    for (int i = 0; i < sched_task_count; i++) {
+      int n = sched_name(sched_tasks[i].run);
+      if (tick % sched_tasks[i].period == sched_tasks[i].phase && n >= 0 &&
+          s_sched_names[n].heavy) {
+        heavy++;
+      }
+    }
+    busiest = (heavy > busiest) ? heavy : busiest;
+  }
+  CHECK_EQ(busiest, 1); // (the old modulo chain: RVC, VU and LEDs on one tick)
+  for (int i = 0; i < sched_task_count; i++) {
+    CHECK(sched_tasks[i].period > 0 &&
+          TICKS_PER_SECOND % sched_tasks[i].period == 0 &&
+          sched_tasks[i].phase < sched_tasks[i].period);
+    int n = sched_name(sched_tasks[i].run);
+    if (sched_tasks[i].period > 1) {
+      CHECK(n >= 0);
+      printf("  %-10s every %3u ticks, at %u\n", n >= 0 ? s_sched_names[n].name : "?",
+             sched_tasks[i].period, sched_tasks[i].phase);
+    }
+  }
+
+#ifdef INCLUDE_SCHED_STATS
+  boot_blank(TICKS_PER_SECOND);
+  press(&sim_pins.p16); // LED mode -> VU meter
+  sim_adc.source[ADC_OUTMON] = tone_source;
+  s_tone_hz = 440;
+  s_tone_amplitude = 100;
+  sched_stats_t before[32];
+  CHECK(sched_task_count <= 32);
+  memcpy(before, sched_stats, sched_task_count * sizeof(sched_stats_t));
+  for (int i = 0; i < 10; i++) {
+    sim_adc.inputs[ADC_RVC] = (i & 1) ? 0xA0 : 0x20; // 1dB steps every tick
+    sim_run(TICKS_PER_SECOND);
+  }
+  sim_adc.source[ADC_OUTMON] = NULL;
+
+  for (int i = 0; i < sched_task_count; i++) {
+    const sched_stats_t *st = &sched_stats[i];
+    CHECK_EQ(st->runs - before[i].runs,
+             10 * TICKS_PER_SECOND / sched_tasks[i].period);
+    CHECK_EQ(st->overruns, 0);
+    CHECK_EQ(st->max_cost, 0); // nothing blocks (ADC waits, IAP) in the ISR
+  }
+  printf("  sched_stats: %u tasks, runs as scheduled, no overruns, no blocking\n",
+         sched_task_count);
+#endif
+}
+
+// Hours of gig behavior: the caller rides the RVC, now and then changes the
+// LED mode, and the battery slowly drains.
+static uint32_t s_rng = 12345;
+
+static uint32_t next_random(void) {
+  s_rng = s_rng * 1103515245u + 12345u;
+  return s_rng >> 16;
+}
+
+static void gig_tick(uint32_t tick) {
+  if (tick % 20 == 0) {
+    int v = sim_adc.inputs[ADC_RVC] + (int)(next_random() % 9) - 4;
+    sim_adc.inputs[ADC_RVC] = (uint8_t)(v < 0 ? 0 : (v > 0xC0 ? 0xC0 : v));
+  }
+  sim_adc.inputs[ADC_OUTMON] = (uint8_t)(0x80 + (int)(next_random() % 64) - 32);
+
+  // a switch press every 10 minutes
+  uint32_t phase = tick % (10 * 60 * TICKS_PER_SECOND);
+  sim_pins.p16 = (phase < 10) ? 0 : 1;
+
+  if (tick % (60 * TICKS_PER_SECOND) == 0 && sim_adc.inputs[ADC_BATTMON] > 70) {
+    sim_adc.inputs[ADC_BATTMON]--;
+  }
+}
+
+static void replay(double hours) {
+  uint32_t ticks = (uint32_t)(hours * 3600 * TICKS_PER_SECOND);
+
+  sim_erase_eeprom();
+  sim_reset();
+  sim_adc.inputs[ADC_RVC] = 0x40;
+  sim.on_tick = gig_tick;
+
+  clock_t start = clock();
+  sim_power_on(ticks);
+  double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  CHECK_EQ(sim.ticks, ticks);
+  CHECK_EQ(sim_lm1971.errors, 0);
+  CHECK_EQ(sim_adc.unpowered_conversions, 0);
+  printf("  replayed %.1f h (%u ticks) in %.2f s = %.1f Mticks/s\n", hours,
+         ticks, elapsed, ticks / elapsed / 1e6);
+  printf("  LM1971 writes: %u, EEPROM writes: %u, in ISR: %u writes %u erases\n",
+         sim_lm1971.writes, sim_iap.writes, sim_iap.isr_writes,
+         sim_iap.isr_erases);
+  printf("  ISR blocking time: max %u us, mean %.1f us\n", sim.isr_busy_us_max,
+         (double)sim.isr_busy_us_total / sim.ticks);
+  sim_energy_report("gig");
+}
+
+static void scenario_gig_replay(void) { replay(3.0); }
+
+// Boot-time cost of reading the preferences, before (backwards scan) and
+// after (binary search), by number of entries in the sector.  IAP reads are
+// counted by the sim; clocks use a hand count of the SDCC code on the 1T
+// core: ReadByte() ~65 clocks plus the loop around it.
+#define PREF_SCAN_PROBE_CLOCKS 80    // 16-bit decrement, address, bit 7 test
+#define PREF_BSEARCH_PROBE_CLOCKS 95 // 16-bit midpoint, bit 7 test, lo/hi update
+
+static void pref_bench(void) {
+  static const int fills[] = {1, 2, 64, 256, 511};
+  const double mhz =
+      __CONF_FOSC / ((__CONF_CLKDIV == 0) ? 1 : __CONF_CLKDIV) / 1e6;
+
+  printf("Pref_Read at %.3f MHz: entries, IAP reads, clocks, us\n", mhz);
+  printf("  %7s  %18s  %18s\n", "", "backwards scan", "Init + Read");
+  for (size_t i = 0; i < sizeof(fills) / sizeof(fills[0]); i++) {
+    Preferences_t p;
+    fill_legacy_prefs(fills[i]);
+    uint32_t reads = sim_iap.reads;
+    ref_pref_read_scan();
+    uint32_t scan = sim_iap.reads - reads;
+
+    fill_prefs(fills[i]);
+    reads = sim_iap.reads;
+    Pref_Init();
+    Pref_Read(&p);
+    uint32_t bsearch = sim_iap.reads - reads;
+
+    printf("  %7d  %3u %6u %7.0f  %3u %6u %7.0f\n", fills[i], scan,
+           scan * PREF_SCAN_PROBE_CLOCKS, scan * PREF_SCAN_PROBE_CLOCKS / mhz,
+           bsearch, bsearch * PREF_BSEARCH_PROBE_CLOCKS,
+           bsearch * PREF_BSEARCH_PROBE_CLOCKS / mhz);
+  }
+}
+
+// EEPROM lifetime, through the firmware: power up, change the LED mode a few
+// times, leave it alone for a while, and repeat.  The most-erased sector sets
+// the lifetime, at SIM_IAP_ENDURANCE_CYCLES erases per sector.
+#define ENDURANCE_SESSIONS 2000
+#define ENDURANCE_PRESSES_PER_SESSION 3
+
+static void endurance(void) {
+  uint32_t presses = 0;
+  uint32_t writes = 0;
+
+  sim_erase_eeprom();
+  for (int session = 0; session < ENDURANCE_SESSIONS; session++) {
+    writes += sim_iap.writes; // counted per power-up
+    sim_reset();
+    sim_power_on(TICKS_PER_SECOND);
+    for (int i = 0; i < ENDURANCE_PRESSES_PER_SESSION; i++) {
+      press(&sim_pins.p16);
+      sim_run(TICKS_PER_SECOND / 2);
+      presses++;
+    }
+    sim_run(5 * TICKS_PER_SECOND);
+  }
+  writes += sim_iap.writes;
+
+  uint32_t max_erases = 0;
+  printf("%u presses in %u power-ups: %u EEPROM writes, erases per sector:",
+         presses, ENDURANCE_SESSIONS, writes);
+  for (int s = 0; s < PREF_NUM_SECTORS; s++) {
+    printf(" %u", pref_erases(s));
+    max_erases = (pref_erases(s) > max_erases) ? pref_erases(s) : max_erases;
+  }
+  printf("\n");
+
+  // The single-sector log erased its sector every PREF_SECTOR_SIZE writes
+  // (one write per press; Pref_Init() rewrote slot 0 without using a slot)
+  double before = (double)SIM_IAP_ENDURANCE_CYCLES * PREF_SECTOR_SIZE;
+  double after = (max_erases == 0) ? 0 : (double)SIM_IAP_ENDURANCE_CYCLES *
+                                             presses / max_erases;
+  printf("projected lifetime: %.2g switch presses (single sector: %.2g)\n",
+         after, before);
+}
+
+// +---------------------------------------------------------------+
+// | RUNNER                                                        |
+// +---------------------------------------------------------------+
+typedef struct {
+  const char *name;
+  void (*fn)(void);
+} scenario_t;
+
+static const scenario_t s_scenarios[] = {
+    {"boot_defaults", scenario_boot_defaults},
+    {"led_sequences", scenario_led_sequences},
+    {"rvc_default_curve", scenario_rvc_default_curve},
+    {"rvc_tables", scenario_rvc_tables},
+    {"rvc_ramp_to_mute", scenario_rvc_ramp_to_mute},
+#ifndef INCLUDE_HOWL_DETECTOR // (its steady test tones are howls)
+    {"atten_zero_crossing", scenario_atten_zero_crossing},
+#endif
+    {"atten_timing", scenario_atten_timing},
+    {"adc_background", scenario_adc_background},
+    {"vu_sampling", scenario_vu_sampling},
+    {"vu_ballistics", scenario_vu_ballistics},
+    {"vu_colors", scenario_vu_colors},
+#ifdef INCLUDE_LIMITER
+    {"limiter", scenario_limiter},
+#endif
+#ifdef INCLUDE_HOWL_DETECTOR
+    {"howl", scenario_howl},
+#endif
+#ifdef INCLUDE_LOUDNESS_TRIM
+    {"loudness", scenario_loudness},
+#endif
+    {"led_mode_switch", scenario_led_mode_switch},
+    {"prefs_write_behind", scenario_prefs_write_behind},
+    {"rvc_mode_persists", scenario_rvc_mode_persists},
+    {"pref_read", scenario_pref_read},
+    {"pref_legacy", scenario_pref_legacy},
+    {"pref_rotation", scenario_pref_rotation},
+    {"low_battery", scenario_low_battery},
+    {"led_gamma", scenario_led_gamma},
+    {"energy", scenario_energy},
+#ifdef INCLUDE_POWER_DOWN
+    {"power_down", scenario_power_down},
+#endif
+#ifdef INCLUDE_DISPLAY
+    {"display_i2c", scenario_display_i2c},
+    {"display_i2c_stuck", scenario_display_i2c_stuck},
+    {"display_i2c_spurious", scenario_display_i2c_spurious},
+#endif
+    {"scheduler", scenario_scheduler},
+    {"gig_replay", scenario_gig_replay},
+};
+
+#define NUM_SCENARIOS (sizeof(s_scenarios) / sizeof(s_scenarios[0]))
+
+// Run a scenario in a child process, so firmware globals start fresh
+static int run_isolated(const scenario_t *sc) {
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    sc->fn();
+    fflush(stdout);
+    _exit(s_failures ? 1 : 0);
+  }
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+  bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  printf("%s %s\n", ok ? "PASS" : "FAIL", sc->name);
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  int failed = 0;
+
+  if (argc == 3 && strcmp(argv[1], "replay") == 0) {
+    replay(atof(argv[2]));
+    return s_failures ? 1 : 0;
+  }
+  if (argc == 2 && strcmp(argv[1], "endurance") == 0) {
+    endurance();
+    return 0;
+  }
+#ifdef INCLUDE_LIMITER
+  if (argc >= 3 && strcmp(argv[1], "limiter_wav") == 0) {
+    limiter_wav(argv[2], argc >= 4 ? atof(argv[3]) : 1.0);
+    return s_failures ? 1 : 0;
+  }
+#endif
+#ifdef INCLUDE_HOWL_DETECTOR
+  if (argc >= 2 && strcmp(argv[1], "howl_bench") == 0) {
+    howl_bench(argc - 2, argv + 2);
+    return s_failures ? 1 : 0;
+  }
+#endif
+#ifdef INCLUDE_LOUDNESS_TRIM
+  if (argc >= 3 && strcmp(argv[1], "loudness_wav") == 0) {
+    loudness_wav(argc - 2, argv + 2);
+    return s_failures ? 1 : 0;
+  }
+#endif
+  if (argc == 2 && strcmp(argv[1], "pref_bench") == 0) {
+    pref_bench();
+    return 0;
+  }
+  if (argc == 2 && strcmp(argv[1], "energy") == 0) {
+#ifdef INCLUDE_POWER_DOWN
+    printf("INCLUDE_POWER_DOWN build, %.3f MHz:\n", SIM_SYSCLOCK_HZ / 1e6);
+#elif defined(INCLUDE_LIMITER)
+    printf("INCLUDE_LIMITER build, %.3f MHz:\n", SIM_SYSCLOCK_HZ / 1e6);
+#elif defined(INCLUDE_HOWL_DETECTOR)
+    printf("INCLUDE_HOWL_DETECTOR build, %.3f MHz:\n", SIM_SYSCLOCK_HZ / 1e6);
+#elif defined(INCLUDE_LOUDNESS_TRIM)
+    printf("INCLUDE_LOUDNESS_TRIM build, %.3f MHz:\n", SIM_SYSCLOCK_HZ / 1e6);
+#else
+    printf("default build, %.3f MHz:\n", SIM_SYSCLOCK_HZ / 1e6);
+#endif
+    steady_energy(3600);
+    return 0;
+  }
+
+  for (size_t i = 0; i < NUM_SCENARIOS; i++) {
+    if (argc == 2 && strcmp(argv[1], s_scenarios[i].name) != 0) {
+      continue;
+    }
+    failed += run_isolated(&s_scenarios[i]);
+  }
+
+  printf("%d scenario(s) failed\n", failed);
+  return failed ? 1 : 0;
+}
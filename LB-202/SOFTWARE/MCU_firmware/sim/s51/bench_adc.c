@@ -0,0 +1,10 @@
+// +-----------------------------------------------+
+// | S51 BENCH SHIM: ADC conversion counter        |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+
+#include "fw_hal.h"
+
+volatile uint8_t bench_adc_conversions = 0; // wraps; the harness uses deltas
@@ -0,0 +1,281 @@
+#!/usr/bin/env python3
+"""
+Flash and RAM footprint of the LB-202 firmware, per function, module and
+feature flag.
+
+Every configuration in MATRIX (globals.h as shipped, then one feature flag
+turned on or off, by editing a copy of globals.h the way a developer would) is
+compiled and linked with SDCC exactly as platformio.ini does (isr_bench.py's
+build(), without its ucsim ADC shim).  From the SDCC output:
+
+  - code bytes per function: in each module listing (.lst), a function runs
+    from its label to the next function, or to the end of the module's CSEG
+  - bytes per module and area (CSEG, CONST, DSEG, OSEG, ISEG, BSEG in bits,
+    XSEG, ...), from the area headers of the .rel files
+  - flash and XRAM used, and internal RAM left for the stack, from the .mem
+  - the ISR path: code bytes of every function an ISR can reach, from the
+    call graph of sim/isr_calls.py (with the SDCC arithmetic helpers it
+    models, but not their code, which is in the library)
+  - for the shipped configuration, that every MEMVAR global is where
+    include/mem_classes.h planned it (.map), and that the stack has
+    gen_mem_classes.STACK_MIN bytes
+
+The report goes to build/s51/footprint.json.  The run fails (exit 1) if a
+configuration breaks a budget below, or, when --baseline is given, if its
+flash or ISR path grew by more than --tolerance or the baseline has no entry
+for it (make footprint-baseline writes one).
+
+Status: scaffolding.  This has not been run against real SDCC output yet, so
+the .lst/.rel/.mem/.map parsers are untested, and there is no committed
+s51/footprint_baseline.json: no flash, IRAM or per-flag figures exist for
+this tree.  The only measured flash figure is the generated tables' 1280
+bytes (rvc_atten_table 512, led_gamma_table 512, vu_color_table 256), which
+tools/gen_vu_colors.py checks against a quarter of the 8KB.  Without a
+baseline the run says so and gates only on the budgets below; the first run
+on a machine with SDCC should check the parsed figures against the .mem by
+hand, then write the baseline (make footprint-baseline) and commit it.
+
+Requires sdcc and sdar on PATH, or set SDCC_BIN.
+
+Usage:
+    sim/s51/footprint.py [--json out.json] [--baseline sim/s51/footprint_baseline.json]
+                         [--tolerance 0.02] [--write-baseline sim/s51/footprint_baseline.json]
+"""
+
+import argparse
+import glob
+import json
+import os
+import re
+import sys
+import tempfile
+
+import isr_bench
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FW_DIR = isr_bench.FW_DIR
+BUILD_DIR = isr_bench.BUILD_DIR
+sys.path.insert(0, os.path.join(HERE, ".."))
+sys.path.insert(0, os.path.join(FW_DIR, "tools"))
+import gen_mem_classes  # noqa: E402
+import isr_calls  # noqa: E402
+
+CLKDIV = 0x04  # platformio.ini
+
+# name -> globals.h flags turned ON (True) or OFF (False), on top of shipped
+MATRIX = [
+    ("shipped", {}),
+    ("+DEBUG", {"DEBUG": True}),
+    ("-INCLUDE_PREFERENCES", {"INCLUDE_PREFERENCES": False}),
+    ("+INCLUDE_DISPLAY", {"INCLUDE_DISPLAY": True, "I2C_PORT": True}),
+    ("+INCLUDE_TEST_POINT", {"INCLUDE_TEST_POINT": True}),
+    ("+INCLUDE_POWER_DOWN", {"INCLUDE_POWER_DOWN": True}),
+    ("+INCLUDE_SCHED_STATS", {"INCLUDE_SCHED_STATS": True}),
+    ("+INCLUDE_LIMITER", {"INCLUDE_LIMITER": True}),
+    ("+INCLUDE_HOWL_DETECTOR", {"INCLUDE_HOWL_DETECTOR": True}),
+    ("+INCLUDE_LOUDNESS_TRIM", {"INCLUDE_LOUDNESS_TRIM": True}),
+]
+
+# STC8G1K08: 8KB flash (the 4KB EEPROM is separate), 256 bytes internal RAM
+# and 1KB XRAM
+FLASH_BUDGET = 8192
+ISR_PATH_BUDGET = 4096  # code the ISRs can reach
+IRAM_FREE_MIN = 16      # internal RAM left for the stack
+XRAM_BUDGET = 1024
+
+CODE_AREAS = ["CSEG", "CONST", "HOME", "GSINIT", "GSFINAL", "XINIT"]
+RAM_AREAS = ["DSEG", "OSEG", "ISEG", "BSEG", "XSEG", "XISEG", "PSEG"]
+
+
+# +---------------------------------------------------------------+
+# | BUILD                                                         |
+# +---------------------------------------------------------------+
+def edit_globals(flags, out):
+    """A copy of include/globals.h in out/, with flags (un)commented."""
+    with open(os.path.join(FW_DIR, "include", "globals.h")) as f:
+        text = f.read()
+    for name, on in flags.items():
+        pattern = r"^(?://\s*)?#define %s\b(.*)$" % name
+        if not re.search(pattern, text, re.MULTILINE):
+            raise SystemExit("footprint: no #define %s in globals.h" % name)
+        text = re.sub(pattern, lambda m: ("" if on else "// ") + "#define " + name + m.group(1),
+                      text, flags=re.MULTILINE)
+    os.makedirs(out, exist_ok=True)
+    with open(os.path.join(out, "globals.h"), "w") as f:
+        f.write(text)
+    return out
+
+
+def isr_path(include_dir):
+    """Functions any ISR can reach, for the globals.h in include_dir."""
+    with tempfile.TemporaryDirectory() as out:
+        calls = isr_calls.compile_graph(["-iquote", include_dir], out)
+    isrs = isr_calls.source_functions(r"^INTERRUPT(?:_USING)?\((\w+),") & set(calls)
+    return isr_calls.reachable(calls, isrs)
+
+
+# +---------------------------------------------------------------+
+# | SDCC OUTPUT                                                   |
+# +---------------------------------------------------------------+
+def read_rel_areas(rel_path):
+    """area -> bytes (BSEG: bits) of one module, from its .rel."""
+    areas = {}
+    with open(rel_path) as f:
+        for line in f:
+            m = re.match(r"^A (\w+) size ([0-9A-Fa-f]+) ", line)
+            if m and int(m.group(2), 16):
+                areas[m.group(1)] = areas.get(m.group(1), 0) + int(m.group(2), 16)
+    return areas
+
+
+def read_lst_functions(lst_path, cseg_size):
+    """function -> code bytes of one module, from its .lst."""
+    starts, area, pending = [], None, None
+    with open(lst_path) as f:
+        for line in f:
+            m = re.search(r"\.area\s+(\w+)", line)
+            if m:
+                area = m.group(1)
+                continue
+            m = re.search(r";\s+function\s+(\w+)\s*$", line)
+            if m:
+                pending = m.group(1)
+                continue
+            m = re.match(r"^\s*([0-9A-Fa-f]{4,8})\s.*\s_(\w+):", line)
+            if m and pending == m.group(2) and area == "CSEG":
+                starts.append((int(m.group(1), 16), pending))
+                pending = None
+    starts.sort()
+    ends = [a for a, _ in starts[1:]] + [cseg_size]
+    return {name: end - start for (start, name), end in zip(starts, ends)}
+
+
+def read_mem_other(mem_path):
+    """{"flash": used, "xram": used}, from the "Other memory" table of a .mem."""
+    used = {}
+    with open(mem_path) as f:
+        for line in f:
+            m = re.match(r"^\s*(ROM/EPROM/FLASH|EXTERNAL RAM)\s+\S+\s+\S+\s+(\d+)\s+\d+", line)
+            if m:
+                used["flash" if m.group(1).startswith("ROM") else "xram"] = int(m.group(2))
+    return used
+
+
+def measure(name, flags):
+    out_name = "footprint_" + re.sub(r"\W+", "_", name).strip("_").lower()
+    include_dir = edit_globals(flags, os.path.join(BUILD_DIR, out_name, "include"))
+    out, _ = isr_bench.build(CLKDIV, shim=False, include_dir=include_dir, name=out_name)
+
+    modules, functions = {}, {}
+    for rel in sorted(glob.glob(os.path.join(out, "*.rel"))):
+        module = os.path.basename(rel)[:-4]
+        areas = read_rel_areas(rel)
+        if not areas:
+            continue
+        modules[module] = areas
+        lst = rel[:-4] + ".lst"
+        if os.path.exists(lst) and not module.startswith("lib_"):
+            functions.update(read_lst_functions(lst, areas.get("CSEG", 0)))
+
+    mem = gen_mem_classes.read_mem(os.path.join(out, "lb202.mem"))
+    used = read_mem_other(os.path.join(out, "lb202.mem"))
+    in_isr = isr_path(include_dir)
+    where = gen_mem_classes.read_map(os.path.join(out, "lb202.map"))
+    return {
+        "mem_classes": {name: where[name] for name in gen_mem_classes.read_plan() if name in where},
+        "config": name,
+        "flags": flags,
+        "flash": used.get("flash", 0),
+        "xram": used.get("xram", 0),
+        "iram_free": mem["stack"],
+        "isr_path": sum(size for fn, size in functions.items() if fn in in_isr),
+        "modules": modules,
+        "functions": functions,
+    }
+
+
+# +---------------------------------------------------------------+
+# | REPORT                                                        |
+# +---------------------------------------------------------------+
+def budget_failures(r):
+    failures = []
+    if r["config"] == "shipped":
+        plan = gen_mem_classes.read_plan()
+        moved = sorted(n for n, cls in r["mem_classes"].items() if cls != plan[n])
+        if moved:
+            failures.append("not where mem_classes.h puts them: " + ", ".join(moved))
+        if r["iram_free"] is not None and r["iram_free"] < gen_mem_classes.STACK_MIN:
+            failures.append("stack %d < STACK_MIN %d" % (r["iram_free"], gen_mem_classes.STACK_MIN))
+    if r["flash"] > FLASH_BUDGET:
+        failures.append("flash %d > %d" % (r["flash"], FLASH_BUDGET))
+    if r["isr_path"] > ISR_PATH_BUDGET:
+        failures.append("ISR path %d > %d" % (r["isr_path"], ISR_PATH_BUDGET))
+    if r["iram_free"] is not None and r["iram_free"] < IRAM_FREE_MIN:
+        failures.append("free IRAM %d < %d" % (r["iram_free"], IRAM_FREE_MIN))
+    if r["xram"] > XRAM_BUDGET:
+        failures.append("XRAM %d > %d" % (r["xram"], XRAM_BUDGET))
+    return failures
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--json", default=os.path.join(BUILD_DIR, "footprint.json"))
+    ap.add_argument("--baseline", help="fail if flash or the ISR path grew vs. this report")
+    ap.add_argument("--tolerance", type=float, default=0.02)
+    ap.add_argument("--write-baseline", help="also write the report here")
+    ap.add_argument("--top", type=int, default=15, help="largest functions to list (default 15)")
+    args = ap.parse_args()
+
+    results = [measure(name, flags) for name, flags in MATRIX]
+    shipped = results[0]
+
+    print("%-27s %6s %7s %8s %9s %5s" % ("config", "flash", "(+/-)", "ISR path", "IRAM free", "XRAM"))
+    failed = False
+    for r in results:
+        failures = budget_failures(r)
+        failed |= bool(failures)
+        print("%-27s %6d %+7d %8d %9s %5d%s" %
+              (r["config"], r["flash"], r["flash"] - shipped["flash"], r["isr_path"],
+               r["iram_free"], r["xram"], "  OVER BUDGET: " + ", ".join(failures) if failures else ""))
+
+    print()
+    print("%-8s %s" % ("module", "  ".join("%6s" % a for a in CODE_AREAS + RAM_AREAS)))
+    for module, areas in sorted(shipped["modules"].items()):
+        print("%-8s %s" % (module[:8], "  ".join("%6d" % areas.get(a, 0) for a in CODE_AREAS + RAM_AREAS)))
+
+    print()
+    print("largest functions (shipped):")
+    for fn, size in sorted(shipped["functions"].items(), key=lambda kv: -kv[1])[:args.top]:
+        print("  %-30s %5d" % (fn, size))
+
+    if args.baseline and not os.path.exists(args.baseline):
+        print("NOTE: no baseline at %s: growth is not checked (scaffolding until "
+              "make footprint-baseline is run with SDCC and committed)" % args.baseline)
+    elif args.baseline:
+        with open(args.baseline) as f:
+            base = {b["config"]: b for b in json.load(f)}
+        for r in results:
+            b = base.get(r["config"])
+            if not b:
+                print("FAIL: %s is not in the baseline (make footprint-baseline)" % r["config"])
+                failed = True
+                continue
+            for key in ("flash", "isr_path"):
+                if r[key] > b[key] * (1 + args.tolerance):
+                    print("REGRESSION: %s %s %d > baseline %d" % (r["config"], key, r[key], b[key]))
+                    failed = True
+            grew = [(fn, size - b["functions"].get(fn, 0)) for fn, size in r["functions"].items()
+                    if size > b["functions"].get(fn, 0)]
+            for fn, delta in sorted(grew, key=lambda kv: -kv[1])[:5]:
+                print("  %s: %s +%d bytes" % (r["config"], fn, delta))
+
+    for path in filter(None, [args.json, args.write_baseline]):
+        os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+        with open(path, "w") as f:
+            json.dump(results, f, indent=2)
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,36 @@
+// +-----------------------------------------------+
+// | S51 BENCH SHIM: FwLib_STC8 fw_hal.h for ucsim |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// Used only by sim/s51/isr_bench.py.  ucsim's s51 does not model the STC8G
+// ADC, so a conversion would never complete.  This shim pulls in the real
+// FwLib_STC8 header and then:
+//   - starts a "conversion" by raising the 8052 Timer2 flag (TF2).  Timer2
+//     shares vector 5 and enable bit IE.5 with the STC8G ADC, so s51 runs
+//     ADC_Routine() as soon as the current ISR returns (or from IDLE).
+//   - makes polled conversions complete instantly, counting them in
+//     bench_adc_conversions so the harness can add the real conversion time
+//     back analytically.
+
+#include_next "fw_hal.h"
+
+#ifndef __S51_BENCH_FW_HAL_H__
+#define __S51_BENCH_FW_HAL_H__
+
+extern volatile uint8_t bench_adc_conversions;
+
+__sbit __at(0xCF) BENCH_TF2; // T2CON.7 on the 8052 that s51 simulates
+
+#undef ADC_Start
+#define ADC_Start() (BENCH_TF2 = 1)
+
+#undef ADC_ClearInterrupt
+#define ADC_ClearInterrupt() (BENCH_TF2 = 0)
+
+#undef ADC_SamplingFinished
+#define ADC_SamplingFinished() (bench_adc_conversions++, 1)
+
+#endif // __S51_BENCH_FW_HAL_H__
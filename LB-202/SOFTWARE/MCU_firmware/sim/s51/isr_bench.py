@@ -0,0 +1,430 @@
+#!/usr/bin/env python3
+"""
+Cycle budget benchmark for the LB-202 Timer0 ISR, run under SDCC's ucsim (s51).
+
+For each CLKDIV (0x00, 0x02, 0x04) the firmware is compiled with SDCC exactly
+as platformio.ini does (plus the ADC shim in sim/s51/fw_hal.h), then run in
+s51 with breakpoints on the entry and RETI of every ISR.  Each Timer0 ISR is
+classified by the value of timer_ticks on entry, following sched_tasks[] in
+main.c (every tick also runs the switch debounce and attenuation slew):
+
+    rvc      timer_ticks % 5 == 0      handle_RVC
+    vu       timer_ticks % 5 == 1      VU meter (led_mode == VU_METER_MODE)
+    leds     timer_ticks % 5 == 2      LED update
+    battmon  timer_ticks == 3          battery monitor (+ ADC power on)
+    switch   everything else           ADC power on / sequence start
+
+and ADC_Routine (one per background conversion) is reported as phase "adc",
+or "zc" for an OUTMON sample while attenuation steps wait for a zero crossing
+(the RVC jumps below make the firmware slew, and the steady ADC_RES makes
+every step time out: the most zero-crossing samples there can be).
+Min / mean / max cycles are reported for every led_mode, followed by the
+entry/exit overhead of every ISR: the PUSHes before its first real
+instruction and the POPs before its RETI, from the linked listing.
+
+The ISRs share register bank ISR_BANK (1) so that the ones that only call
+ISR_USING helpers save no R0-R7.  -D ISR_BANK=0 builds them the old way, for
+a before/after comparison of both tables.
+
+Cycle model:
+  - s51 counts classic 12T clocks; we divide by 12 to get machine cycles,
+    which is a (slightly pessimistic) proxy for STC8G 1T clocks.
+  - ucsim does not model the STC8G ADC.  s51/fw_hal.h raises the 8052 Timer2
+    flag instead, which shares vector 5 and IE.5 with the STC8G ADC, so
+    ADC_Routine runs right after the ISR that started the conversion.  Code
+    that still polls for a conversion pays the real conversion time
+    (ADC_CONV_CLOCKS ADC clocks at SYSCLK/2/(prescaler+1)), added back here.
+  - The budget is one Timer0 period: SYSCLK / 100 cycles
+    (43750 cycles at CLKDIV=0x04, 4.375 MHz).
+
+The zero-crossing samples are paced one per ATTEN_ZC_SAMPLE_CLOCKS SYSCLKs
+(src/main.c), so their worst case over that is the ISR load of a slew; it
+must stay within the sim's ATTEN_ZC_LOAD_MAX, and their mean within the
+SIM_RUN_CLOCKS_PER_IRQ that the sim charges for every ADC interrupt.
+
+The run fails (exit 1) if any ISR's worst case exceeds the budget, if the
+zero-crossing samples break either of those, or, when --baseline is given, if
+any worst case grew by more than --tolerance against it.
+
+Status: scaffolding.  This has not been run against real SDCC and ucsim
+output yet (the symbol, listing and breakpoint parsing included), and there is
+no committed s51/isr_baseline.json, so no cycle figures exist for this tree.
+Without a baseline the run says so and gates only on the budgets above; the
+first run on a machine with SDCC should check the parsing by hand, then write
+the baseline (make bench-s51-baseline) and commit it.
+
+Requires sdcc, sdar and s51 (ucsim) on PATH, or set SDCC_BIN.
+
+Usage:
+    sim/s51/isr_bench.py [--ticks N] [--json out.json]
+                         [--baseline sim/s51/isr_baseline.json] [--tolerance 0.05]
+                         [--write-baseline sim/s51/isr_baseline.json]
+"""
+
+import argparse
+import glob
+import json
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FW_DIR = os.path.abspath(os.path.join(HERE, "..", ".."))
+LIB_DIR = os.path.join(FW_DIR, "lib", "FwLib_STC8")
+BUILD_DIR = os.path.join(HERE, "..", "build", "s51")
+
+SDCC_BIN = os.environ.get("SDCC_BIN", "")
+
+FOSC = 17500000
+CLKDIVS = [0x00, 0x02, 0x04]
+TIMER_HZ = 100
+LED_MODES = {
+    0: "BATTERY_MONITOR",
+    1: "VU_METER",
+    2: "SOLID_RED",
+    3: "SOLID_GREEN",
+    4: "SOLID_BLUE",
+    5: "SOLID_WHITE",
+}
+VU_METER_MODE = 1
+PHASES = ["rvc", "vu", "leds", "battmon", "switch", "adc", "zc"]
+ISRS = ["_Timer0_Routine", "_ADC_Routine"]
+OVERHEAD_ISRS = ["_Timer0_Routine", "_ADC_Routine", "_VU_Routine"]
+
+S51_CLOCKS_PER_CYCLE = 12
+ADC_CONV_CLOCKS = 24  # (switch+1)+(hold+1)+(sample+1)+10 at reset ADCTIM
+ADC_PRESCALER = 0x01  # init_battmon(): ADC_SetClockPrescaler(0x01)
+
+# RVC input pattern, one value per ISR (ADC_RES is shared by all channels).
+# Mostly steady, with regular full-range jumps so the 1dB ramp in
+# handle_RVC is exercised in both directions.
+RVC_STEADY = 0x20
+RVC_MUTE = 0xD0
+GOOD_BATTERY = 138
+ADCCHANNEL_OUTMON = 4
+
+CC_FLAGS = [
+    "-mmcs51",
+    "--std-sdcc11",
+    "--opt-code-size",
+    "-D__SDCC__",
+    "-D__CONF_MCU_MODEL=MCU_MODEL_STC8G1K08",
+    "-D__CONF_FOSC=%dUL" % FOSC,
+    "-DSTC8G1K08A",
+]
+LD_FLAGS = ["--iram-size", "256", "--xram-size", "1024", "--code-size", "8192"]
+
+
+def tool(name):
+    path = os.path.join(SDCC_BIN, name) if SDCC_BIN else name
+    if not shutil.which(path):
+        raise SystemExit("%s not found: install SDCC (with ucsim) or set SDCC_BIN" % path)
+    return path
+
+
+def run(cmd, **kwargs):
+    return subprocess.run(cmd, check=True, **kwargs)
+
+
+# +---------------------------------------------------------------+
+# | BUILD                                                         |
+# +---------------------------------------------------------------+
+def build(clkdiv, defines=(), shim=True, include_dir=None, name=None):
+    """Compile and link the firmware with SDCC into BUILD_DIR/name.  shim adds
+    the ucsim ADC stand-in (fw_hal.h and bench_adc.c here); include_dir, if
+    given, is searched before include/ (e.g. for an edited globals.h)."""
+    out = os.path.join(BUILD_DIR, name or "clkdiv%02x" % clkdiv + "".join("_" + d.lower() for d in defines))
+    os.makedirs(out, exist_ok=True)
+    flags = CC_FLAGS + ["-D__CONF_CLKDIV=0x%02X" % clkdiv] + ["-D" + d for d in defines]
+
+    lib_rels = []
+    for src in sorted(glob.glob(os.path.join(LIB_DIR, "src", "*.c"))):
+        rel = os.path.join(out, "lib_" + os.path.basename(src)[:-2] + ".rel")
+        run([tool("sdcc"), "-c"] + flags + ["-I" + os.path.join(LIB_DIR, "include"), src, "-o", rel])
+        lib_rels.append(rel)
+    lib = os.path.join(out, "fw_stc8.lib")
+    if os.path.exists(lib):
+        os.remove(lib)
+    run([tool("sdar"), "-rcs", lib] + lib_rels)
+
+    incs = (["-I" + HERE] if shim else []) + (["-I" + include_dir] if include_dir else [])
+    incs += ["-I" + os.path.join(FW_DIR, "include"), "-I" + os.path.join(LIB_DIR, "include")]
+    srcs = sorted(glob.glob(os.path.join(FW_DIR, "src", "*.c")))  # as platformio does
+    if shim:
+        srcs.append(os.path.join(HERE, "bench_adc.c"))
+    rels = []
+    for src in srcs:
+        rel = os.path.join(out, os.path.basename(src)[:-2] + ".rel")
+        run([tool("sdcc"), "-c"] + flags + incs + [src, "-o", rel])
+        rels.append(rel)
+
+    ihx = os.path.join(out, "lb202.ihx")
+    run([tool("sdcc")] + flags + LD_FLAGS + rels + [lib, "-o", ihx])
+    return out, ihx
+
+
+def read_symbols(map_path):
+    """Global symbol -> address, from the sdld .map file."""
+    syms = {}
+    with open(map_path) as f:
+        for line in f:
+            m = re.search(r"\b([0-9A-Fa-f]{4,8})\s+(_\w+)\b", line)
+            if m:
+                syms.setdefault(m.group(2), int(m.group(1), 16))
+    return syms
+
+
+def find_isr_reti(rst_path, isr):
+    """Address of the RETI that ends an ISR, from the linked .rst listing."""
+    in_isr = False
+    with open(rst_path) as f:
+        for line in f:
+            if re.search(r"^\s*[0-9A-Fa-f]*\s*.*\b%s:" % isr, line):
+                in_isr = True
+            elif in_isr:
+                m = re.match(r"^\s*([0-9A-Fa-f]{4,8})\s+32\b.*\breti\b", line)
+                if m:
+                    return int(m.group(1), 16)
+    raise RuntimeError("RETI of %s not found in %s" % (isr, rst_path))
+
+
+def isr_overhead(rst_path, isr):
+    """(PUSHes on entry, POPs before RETI) of an ISR, from the .rst listing,
+    or None if the ISR is not in this build."""
+    ops, in_isr = [], False
+    with open(rst_path) as f:
+        for line in f:
+            if re.search(r"^\s*[0-9A-Fa-f]*\s*.*\b%s:" % isr, line):
+                in_isr = True
+            elif in_isr:
+                m = re.match(r"^\s*[0-9A-Fa-f]{4,8}\s+(?:[0-9A-Fa-f]{2}\s+)+(?:\[\s*\d+\]\s+)?\d+\s+(\w+)", line)
+                if m:
+                    ops.append(m.group(1).lower())
+                    if ops[-1] == "reti":
+                        break
+    if not ops:
+        return None
+    pushes = next((i for i, op in enumerate(ops) if op != "push"), len(ops))
+    pops = next((i for i, op in enumerate(reversed(ops[:-1])) if op != "pop"), len(ops) - 1)
+    return pushes, pops
+
+
+def c_define(path, name):
+    """Numeric value of a simple #define in a firmware or sim source."""
+    with open(path) as f:
+        m = re.search(r"^#define %s\s+([0-9.xXA-Fa-f]+)" % name, f.read(), re.MULTILINE)
+    if not m:
+        raise RuntimeError("%s not found in %s" % (name, path))
+    return float(m.group(1)) if "." in m.group(1) else int(m.group(1), 0)
+
+
+MAIN_C = os.path.join(FW_DIR, "src", "main.c")
+SIM_DIR = os.path.join(HERE, "..")
+ZC_SAMPLE_CLOCKS = ADC_CONV_CLOCKS * 2 * (c_define(MAIN_C, "ATTEN_ZC_ADC_PRESCALER") + 1)
+ZC_TIMEOUT_US = c_define(MAIN_C, "ATTEN_ZC_TIMEOUT_US")
+ZC_LOAD_MAX = c_define(os.path.join(SIM_DIR, "ladybug_sim.c"), "ATTEN_ZC_LOAD_MAX")
+SIM_CLOCKS_PER_IRQ = c_define(os.path.join(SIM_DIR, "hal", "sim_hal.h"), "SIM_RUN_CLOCKS_PER_IRQ")
+
+
+def mem_space(name):
+    """ucsim memory holding a firmware global, per include/mem_classes.h."""
+    with open(os.path.join(FW_DIR, "include", "mem_classes.h")) as f:
+        return "xram" if re.search(r"MEM_%s\(type\) __XDATA" % name, f.read()) else "iram"
+
+
+# +---------------------------------------------------------------+
+# | SIMULATE                                                      |
+# +---------------------------------------------------------------+
+def rvc_value(n):
+    # 4s period at 100Hz: jump to MUTE for 0.5s, then back
+    return RVC_MUTE if (n % 400) in range(200, 250) else RVC_STEADY
+
+
+def simulate(ihx, syms, retis, led_mode, ticks, sysclk):
+    entries = {syms[isr]: isr for isr in ISRS}
+    exits = {retis[isr]: isr for isr in ISRS}
+    a_ticks = syms["_timer_ticks"]
+    a_mode = syms["_led_mode"]
+    a_batt = syms["_battmon_res"]
+    a_conv = syms["_bench_adc_conversions"]
+    a_zc, a_chan = syms["_atten_zc_steps"], syms["_adc_seq_channel"]
+    m_ticks, m_mode, m_batt = mem_space("timer_ticks"), mem_space("led_mode"), mem_space("battmon_res")
+    m_zc, m_chan = mem_space("atten_zc_steps"), mem_space("adc_seq_channel")
+
+    # The whole session is scripted up front, with the same commands at every
+    # breakpoint: set the RVC input, pin the battery at "good" (so the low
+    # battery override never hides the led_mode under test) and record
+    # (timer_ticks, conversions, zero-crossing state, clocks).  ADC_Routine
+    # runs up to 22 times per RVC tick, so allow for that many stops, plus an
+    # entry and a RETI for each timed-out zero-crossing sample of up to 64
+    # steps per slew (two slews per rvc_value() period).
+    zc_timeout = sysclk // ZC_SAMPLE_CLOCKS * ZC_TIMEOUT_US // 1000000
+    stops = ticks * 12 + 2 * (ticks // 400 + 1) * 64 * zc_timeout * 2
+    cmds = ["break 0x%04x" % a for a in list(entries) + list(exits)]
+    for n in range(stops):
+        cmds.append("run")
+        if n == 0:
+            cmds.append("set memory %s 0x%02x 0x%02x" % (m_mode, a_mode, led_mode))
+        cmds.append("set memory sfr 0xbd 0x%02x" % rvc_value(n // 12))
+        cmds.append("set memory %s 0x%02x 0x%02x" % (m_batt, a_batt, GOOD_BATTERY))
+        cmds.append("dump %s 0x%02x 0x%02x" % (m_ticks, a_ticks, a_ticks))
+        cmds.append("dump iram 0x%02x 0x%02x" % (a_conv, a_conv))
+        cmds.append("dump %s 0x%02x 0x%02x" % (m_zc, a_zc, a_zc))
+        cmds.append("dump %s 0x%02x 0x%02x" % (m_chan, a_chan, a_chan))
+        cmds.append("state")
+    cmds.append("quit")
+
+    proc = subprocess.run(
+        [tool("s51"), "-t", "8052", "-X", str(sysclk), ihx],
+        input="\n".join(cmds) + "\n",
+        capture_output=True,
+        text=True,
+        check=True,
+    )
+
+    # One chunk of output per stop: where it stopped, then the four dumps and
+    # the clock count, in command order
+    adc_cycles = ADC_CONV_CLOCKS * 2 * (ADC_PRESCALER + 1)
+    samples = {p: [] for p in PHASES}
+    open_isr = None
+    seen_timer0 = 0
+    for chunk in re.split(r"(?=Stop at 0x)", proc.stdout)[1:]:
+        pc = int(re.match(r"Stop at 0x([0-9a-fA-F]+)", chunk).group(1), 16)
+        dumps = re.findall(r"^0x[0-9a-fA-F]+\s+([0-9a-fA-F]{2})\b", chunk, re.MULTILINE)
+        clks = re.search(r"Total time since last reset=\s*\S+\s+sec\s+\((\d+)\s+clks\)", chunk)
+        if len(dumps) < 4 or not clks:
+            break
+        t, conv, clk = int(dumps[0], 16), int(dumps[1], 16), int(clks.group(1))
+        zc = int(dumps[2], 16) != 0 and int(dumps[3], 16) == ADCCHANNEL_OUTMON
+
+        if pc in entries:
+            open_isr = (entries[pc], t, conv, clk, zc)
+            continue
+        if pc not in exits or open_isr is None or open_isr[0] != exits[pc]:
+            open_isr = None
+            continue
+        isr, t_in, conv_in, clk_in, zc_in = open_isr
+        open_isr = None
+        cycles = (clk - clk_in) // S51_CLOCKS_PER_CYCLE + ((conv - conv_in) & 0xFF) * adc_cycles
+
+        if isr == "_ADC_Routine":
+            phase = "zc" if zc_in else "adc"
+        elif t_in == 3:
+            phase = "battmon"
+        elif t_in % 5 == 0:
+            phase = "rvc"
+        elif t_in % 5 == 1 and led_mode == VU_METER_MODE:
+            phase = "vu"
+        elif t_in % 5 == 2:
+            phase = "leds"
+        else:
+            phase = "switch"
+        if isr == "_Timer0_Routine":
+            seen_timer0 += 1
+            if seen_timer0 == 1:
+                continue  # the first ISR still sees boot-time state
+        samples[phase].append(cycles)
+    return samples
+
+
+# +---------------------------------------------------------------+
+# | REPORT                                                        |
+# +---------------------------------------------------------------+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--ticks", type=int, default=800, help="ISRs to run per led_mode (default 800 = 8s)")
+    ap.add_argument("--json", default=os.path.join(BUILD_DIR, "isr_bench.json"))
+    ap.add_argument("--baseline", help="fail if any worst case grew vs. this report")
+    ap.add_argument("--tolerance", type=float, default=0.05)
+    ap.add_argument("--write-baseline", help="also write the report here")
+    ap.add_argument("-D", dest="defines", action="append", default=[],
+                    help="extra firmware define, e.g. -D INCLUDE_HOWL_DETECTOR")
+    args = ap.parse_args()
+
+    results, overhead = [], {}
+    for clkdiv in CLKDIVS:
+        sysclk = FOSC // (clkdiv if clkdiv else 1)
+        budget = sysclk // TIMER_HZ
+        out, ihx = build(clkdiv, args.defines)
+        syms = read_symbols(os.path.join(out, "lb202.map"))
+        retis = {isr: find_isr_reti(os.path.join(out, "main.rst"), isr) for isr in ISRS}
+        for isr in OVERHEAD_ISRS:
+            overhead.setdefault(isr, isr_overhead(os.path.join(out, "main.rst"), isr))
+
+        for mode, mode_name in LED_MODES.items():
+            samples = simulate(ihx, syms, retis, mode, args.ticks, sysclk)
+            for phase in PHASES:
+                s = samples[phase]
+                if not s:
+                    continue
+                results.append({
+                    "clkdiv": clkdiv,
+                    "led_mode": mode_name,
+                    "phase": phase,
+                    "count": len(s),
+                    "min": min(s),
+                    "mean": round(sum(s) / len(s), 1),
+                    "max": max(s),
+                    "budget": budget,
+                })
+
+    print("%-7s %-16s %-8s %6s %8s %10s %8s %8s %6s" %
+          ("CLKDIV", "led_mode", "phase", "n", "min", "mean", "max", "budget", "max%"))
+    failed = False
+    for r in results:
+        pct = 100.0 * r["max"] / r["budget"]
+        flag = "" if r["max"] <= r["budget"] else "  OVERRUN"
+        failed |= bool(flag)
+        print("0x%02X    %-16s %-8s %6d %8d %10.1f %8d %8d %5.1f%%%s" %
+              (r["clkdiv"], r["led_mode"], r["phase"], r["count"], r["min"], r["mean"],
+               r["max"], r["budget"], pct, flag))
+
+    # zero-crossing samples: one per ZC_SAMPLE_CLOCKS for as long as a slew
+    # waits, so their cost over that is the ISR load while slewing
+    print()
+    print("%-7s %-16s %10s %8s %8s %6s" %
+          ("CLKDIV", "led_mode", "zc mean", "zc max", "period", "load"))
+    for r in results:
+        if r["phase"] != "zc":
+            continue
+        load = float(r["max"]) / ZC_SAMPLE_CLOCKS
+        flag = ""
+        if load > ZC_LOAD_MAX:
+            flag += "  OVER ATTEN_ZC_LOAD_MAX %.0f%%" % (100 * ZC_LOAD_MAX)
+        if r["mean"] > SIM_CLOCKS_PER_IRQ:
+            flag += "  OVER SIM_RUN_CLOCKS_PER_IRQ %d" % SIM_CLOCKS_PER_IRQ
+        failed |= bool(flag)
+        print("0x%02X    %-16s %10.1f %8d %8d %5.1f%%%s" %
+              (r["clkdiv"], r["led_mode"], r["mean"], r["max"], ZC_SAMPLE_CLOCKS, 100 * load, flag))
+
+    print()
+    print("%-16s %6s %6s" % ("ISR", "push", "pop"))
+    for isr, n in overhead.items():
+        if n:
+            print("%-16s %6d %6d" % (isr[1:], n[0], n[1]))
+
+    if args.baseline and not os.path.exists(args.baseline):
+        print("NOTE: no baseline at %s: regressions are not checked (scaffolding until "
+              "make bench-s51-baseline is run with SDCC and committed)" % args.baseline)
+    elif args.baseline:
+        with open(args.baseline) as f:
+            base = {(b["clkdiv"], b["led_mode"], b["phase"]): b for b in json.load(f)}
+        for r in results:
+            b = base.get((r["clkdiv"], r["led_mode"], r["phase"]))
+            if b and r["max"] > b["max"] * (1 + args.tolerance):
+                print("REGRESSION: CLKDIV 0x%02X %s %s worst case %d > baseline %d" %
+                      (r["clkdiv"], r["led_mode"], r["phase"], r["max"], b["max"]))
+                failed = True
+
+    for path in filter(None, [args.json, args.write_baseline]):
+        os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+        with open(path, "w") as f:
+            json.dump(results, f, indent=2)
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
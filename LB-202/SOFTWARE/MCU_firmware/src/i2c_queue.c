@@ -0,0 +1,258 @@
+// +-----------------------------------------------+
+// | I2C MASTER TRANSFER QUEUE                     |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// See include/i2c_queue.h.  Replaces FwLib_STC8's I2C_Write()/I2C_Read(),
+// which wait for every START, byte and ACK with the CPU spinning on MSIF.
+
+#include "globals.h"
+
+#include "fw_hal.h"
+#include "i2c_queue.h"
+#include "mem_classes.h"
+
+#ifdef INCLUDE_I2C_QUEUE
+
+// I2C master registers (extended SFRs: SFRX_ON() first)
+#define I2CCFG_ENI2C 0x80   // I2C enabled
+#define I2CCFG_MSSL 0x40    // master mode
+#define I2CMSCR_EMSI 0x80   // master interrupt enabled
+#define I2CMSST_MSIF 0x40   // the last command is done
+#define I2CMSST_MSACKI 0x02 // the ACK bit received: 1 = NACK
+
+#define I2C_COMMAND(__CMD__) (I2CMSCR = I2CMSCR_EMSI | (__CMD__))
+
+#define I2C_FLAG_READ 0x01
+
+typedef struct {
+  uint8_t dev;    // 8-bit address, R/W bit 0
+  uint8_t reg;    // register or control byte
+  uint8_t flags;  // I2C_FLAG_*
+  uint8_t status; // I2C_PENDING until the transfer has ended
+  uint8_t byte;   // i2c_write_byte()'s data
+  __XDATA uint8_t *buf;
+  uint16_t len;
+  i2c_done_fn done;
+} i2c_xfer_t;
+
+// A ring of I2C_QUEUE_LEN slots: main() fills the one at i2c_head, the ISR
+// works on the one at i2c_tail, and i2c_poll() reports and frees the one at
+// i2c_reap.  Each index is written by one side only.
+#define I2C_NEXT(__I__) (((__I__) + 1) & (I2C_QUEUE_LEN - 1))
+#if (I2C_QUEUE_LEN & (I2C_QUEUE_LEN - 1)) != 0
+#error "I2C_QUEUE_LEN must be a power of 2"
+#endif
+
+__XDATA i2c_xfer_t i2c_queue[I2C_QUEUE_LEN];
+
+volatile MEMVAR(uint8_t, i2c_head) = 0;
+volatile MEMVAR(uint8_t, i2c_tail) = 0;
+volatile MEMVAR(uint8_t, i2c_reap) = 0;
+volatile MEMVAR(bool, i2c_busy) = false;      // the transfer at i2c_tail is on the bus
+volatile MEMVAR(bool, i2c_ended) = false;     // a transfer ended since the last i2c_poll()
+volatile MEMVAR(uint8_t, i2c_state) = 0;      // I2C_STATE_*: its last command
+volatile MEMVAR(uint16_t, i2c_pos) = 0;       // its data bytes sent or received
+volatile MEMVAR(uint8_t, i2c_idle_ticks) = 0; // Timer0 ticks since its last interrupt
+volatile MEMVAR(uint8_t, i2c_errors) = 0;     // NACKs and timeouts (saturates)
+
+#define I2C_STATE_ADDR 0  // START + dev
+#define I2C_STATE_REG 1   // reg
+#define I2C_STATE_WRITE 2 // a data byte
+#define I2C_STATE_RADDR 3 // repeated START + dev + 1
+#define I2C_STATE_READ 4  // a data byte received
+#define I2C_STATE_STOP 5  // STOP
+
+// Put the transfer at i2c_tail (if any) on the bus.  Expanded in place by the
+// ISR, the Timer0 task and i2c_submit(), so that the ISR calls nothing.
+#define I2C_START_NEXT()                                                       \
+  do {                                                                         \
+    i2c_busy = (i2c_tail != i2c_head);                                         \
+    if (i2c_busy) {                                                            \
+      i2c_state = I2C_STATE_ADDR;                                              \
+      i2c_pos = 0;                                                             \
+      i2c_idle_ticks = 0;                                                      \
+      SFRX_ON();                                                               \
+      I2CTXD = i2c_queue[i2c_tail].dev;                                        \
+      I2C_COMMAND(I2C_MasterCmd_StartSendRxAck);                               \
+      SFRX_OFF();                                                              \
+    }                                                                          \
+  } while (0)
+
+// =============================================================
+// I2C master interrupt: the last command is done, issue the next one
+INTERRUPT_USING(I2C_Routine, EXTI_VectI2C, ISR_BANK) {
+  __XDATA i2c_xfer_t *x = &i2c_queue[i2c_tail];
+  uint8_t cmd = I2C_MasterCmd_Stop;
+
+  SFRX_ON();
+  I2CMSST &= ~I2CMSST_MSIF;
+  if (!i2c_busy) {
+    // Nothing on the bus (i2c_init()'s Wait, or a reset transfer's last
+    // command): i2c_state and i2c_tail belong to no transfer
+    SFRX_OFF();
+    return;
+  }
+  i2c_idle_ticks = 0;
+
+  if (i2c_state == I2C_STATE_STOP) {
+    SFRX_OFF();
+    if (x->status == I2C_PENDING) {
+      x->status = I2C_OK;
+    }
+    i2c_ended = true;
+    i2c_tail = I2C_NEXT(i2c_tail);
+    I2C_START_NEXT();
+    return;
+  }
+
+  if (i2c_state != I2C_STATE_READ && (I2CMSST & I2CMSST_MSACKI)) {
+    x->status = I2C_NACK;
+    if (i2c_errors != 0xFF) {
+      i2c_errors++;
+    }
+  } else if (i2c_state == I2C_STATE_ADDR) {
+    I2CTXD = x->reg;
+    cmd = I2C_MasterCmd_SendRxAck;
+    i2c_state = I2C_STATE_REG;
+  } else if (i2c_state == I2C_STATE_REG && (x->flags & I2C_FLAG_READ)) {
+    I2CTXD = x->dev | 0x01;
+    cmd = I2C_MasterCmd_StartSendRxAck;
+    i2c_state = I2C_STATE_RADDR;
+  } else if (i2c_state == I2C_STATE_REG || i2c_state == I2C_STATE_WRITE) {
+    if (i2c_pos < x->len) {
+      I2CTXD = x->buf[i2c_pos++];
+      cmd = I2C_MasterCmd_SendRxAck;
+      i2c_state = I2C_STATE_WRITE;
+    }
+  } else { // I2C_STATE_RADDR or I2C_STATE_READ
+    if (i2c_state == I2C_STATE_READ) {
+      x->buf[i2c_pos++] = I2CRXD;
+    }
+    if (i2c_pos < x->len) {
+      // ACK every byte but the last
+      cmd = (i2c_pos + 1 == x->len) ? I2C_MasterCmd_RecvNAck
+                                     : I2C_MasterCmd_RecvTxAck0;
+      i2c_state = I2C_STATE_READ;
+    }
+  }
+
+  if (cmd == I2C_MasterCmd_Stop) {
+    i2c_state = I2C_STATE_STOP;
+  }
+  I2C_COMMAND(cmd);
+  SFRX_OFF();
+}
+
+// Timer0 task: a transfer with no interrupt for I2C_TIMEOUT_TICKS is
+// abandoned.  Turning the I2C peripheral off and on drops its command and
+// lets go of the bus.
+void handle_i2c_timeout(void) {
+  if (!i2c_busy || ++i2c_idle_ticks < I2C_TIMEOUT_TICKS) {
+    return;
+  }
+  SFRX_ON();
+  I2CCFG &= ~I2CCFG_ENI2C;
+  I2CMSST = 0x00;
+  I2CCFG |= I2CCFG_ENI2C;
+  SFRX_OFF();
+
+  i2c_queue[i2c_tail].status = I2C_TIMEOUT;
+  if (i2c_errors != 0xFF) {
+    i2c_errors++;
+  }
+  i2c_ended = true;
+  i2c_tail = I2C_NEXT(i2c_tail);
+  I2C_START_NEXT();
+}
+
+// =============================================================
+// | MAIN LOOP SIDE                                            |
+// =============================================================
+
+void i2c_init(void) {
+  // SCL and SDA open drain: the bus has its own pull-ups
+  if (I2C_PORT == I2C_AlterPort_P15_P14) {
+    GPIO_P1_SetMode(GPIO_Pin_5 | GPIO_Pin_4, GPIO_Mode_InOut_OD);
+  } else if (I2C_PORT == I2C_AlterPort_P25_P24) {
+    GPIO_P2_SetMode(GPIO_Pin_5 | GPIO_Pin_4, GPIO_Mode_InOut_OD);
+  } else {
+    GPIO_P3_SetMode(GPIO_Pin_2 | GPIO_Pin_3, GPIO_Mode_InOut_OD);
+  }
+  I2C_SetPort(I2C_PORT);
+
+  SFRX_ON();
+  I2CCFG = I2CCFG_ENI2C | I2CCFG_MSSL | I2C_PRESCALER_COMPUTE(I2C_BUS_HZ);
+  I2CMSST = 0x00;
+  I2C_COMMAND(I2C_MasterCmd_Wait);
+  SFRX_OFF();
+}
+
+static bool i2c_submit(uint8_t dev, uint8_t reg, uint8_t flags,
+                       __XDATA uint8_t *buf, uint16_t len, i2c_done_fn done) {
+  __XDATA i2c_xfer_t *x = &i2c_queue[i2c_head];
+
+  if (I2C_NEXT(i2c_head) == i2c_reap) {
+    return false;
+  }
+  x->dev = dev & 0xFE;
+  x->reg = reg;
+  x->flags = flags;
+  x->status = I2C_PENDING;
+  x->buf = buf;
+  x->len = len;
+  x->done = done;
+
+  // Interrupts off while starting the bus: the ISRs turn SFRX off on return
+  EXTI_Global_SetIntState(HAL_State_OFF);
+  i2c_head = I2C_NEXT(i2c_head);
+  if (!i2c_busy) {
+    I2C_START_NEXT();
+  }
+  EXTI_Global_SetIntState(HAL_State_ON);
+  return true;
+}
+
+bool i2c_write(uint8_t dev, uint8_t reg, __XDATA uint8_t *buf, uint16_t len,
+               i2c_done_fn done) {
+  return i2c_submit(dev, reg, 0, buf, len, done);
+}
+
+bool i2c_write_byte(uint8_t dev, uint8_t reg, uint8_t value, i2c_done_fn done) {
+  if (I2C_NEXT(i2c_head) == i2c_reap) {
+    return false;
+  }
+  i2c_queue[i2c_head].byte = value; // the ISR only looks at slots up to i2c_head
+  return i2c_submit(dev, reg, 0, &i2c_queue[i2c_head].byte, 1, done);
+}
+
+bool i2c_read(uint8_t dev, uint8_t reg, __XDATA uint8_t *buf, uint16_t len,
+              i2c_done_fn done) {
+  return i2c_submit(dev, reg, I2C_FLAG_READ, buf, len, done);
+}
+
+void i2c_poll(void) {
+  if (!i2c_ended) {
+    return;
+  }
+  i2c_ended = false; // (before looking at i2c_tail)
+  while (i2c_reap != i2c_tail) {
+    __XDATA i2c_xfer_t *x = &i2c_queue[i2c_reap];
+    i2c_done_fn done = x->done;
+    uint8_t status = x->status;
+
+    i2c_reap = I2C_NEXT(i2c_reap); // done() may queue into this slot
+    if (done) {
+      done(status);
+    }
+  }
+}
+
+void i2c_wait(void) {
+  PCON |= 0x01; // IDLE: woken by the I2C (or any other) interrupt
+  i2c_poll();
+}
+
+#endif // INCLUDE_I2C_QUEUE
@@ -7,12 +7,24 @@
 
 #include "fw_hal.h"
 #include "globals.h"
+#include "led_gamma.h"
+#include "mem_classes.h"
+#include "rvc_tables.h"
+#include "vu_colors.h"
 #include <stdint.h>
 
 #ifdef INCLUDE_PREFERENCES
 #include "preferences.h"
 #endif
 
+#ifdef INCLUDE_I2C_QUEUE
+#include "i2c_queue.h"
+#endif
+
+#ifdef INCLUDE_DISPLAY
+#include "ssd1306.h"
+#endif
+
 /*
  * ============================================================================
  * HARDWARE PINOUT - STC8G1K08-QFN20 Custom Audio Mixer Board
@@ -26,8 +38,8 @@
  *
  * PIN ASSIGNMENTS:
  * ----------------
- * P1.1 (Pin 20) - I2C SCL (SSD1306 OLED Display) - Output Push-Pull
- * P1.2 (Pin 19) - I2C SDA (SSD1306 OLED Display) - Quasi-Bidirectional
+ * P1.1 (Pin 20) - Display header SCL (unused: not an I2C peripheral pin)
+ * P1.2 (Pin 19) - Display header SDA (unused: not an I2C peripheral pin)
  *
  * P1.5 (Pin  1) - Switch 1 Input (Active Low, Internal Pullup) - Input HIP
  * P1.6 (Pin  2) - Switch 2 Input (Active Low, Internal Pullup) - Input HIP
@@ -49,18 +61,27 @@
  * P3.1 (Pin 9)  - UART1 TX (115200 baud)
  * P1.3 (Pin 18) - TEST OUTPUT (Toggled in main loop)
  *
- * DISPLAY (when INCLUDE_DISPLAY is defined):
+ * DISPLAY (when INCLUDE_DISPLAY is defined -- other hardware, not LB-202):
  * - SSD1306 OLED: 128x32 pixels, I2C address 0x78
  * - I2C Clock: ~265 KHz (safe for SSD1306)
+ * - P1.1/P1.2 are not an I2C peripheral pin pair, and the pairs the part
+ *   has are in use, so it cannot run on this board: see I2C_PORT in
+ *   include/i2c_queue.h
  *
  * EEPROM (when INCLUDE_PREFERENCES is defined):
- * - Last 512-byte sector (0x0E00-0x0FFF) reserved for preferences
- * - Log-structured storage with wear leveling
+ * - All 8 512-byte sectors (0x0000-0x0FFF) reserved for preferences
+ * - Log-structured storage, rotating through the sectors for wear leveling
  *
  * POWER MANAGEMENT:
  * - IDLE mode enabled in main loop (CPU stops, peripherals continue)
+ * - Once nothing changes for 3s (when INCLUDE_POWER_DOWN is defined): with
+ *   the LED OFF, power-down + wake-up timer at 20 Hz; with a static color,
+ *   IDLE on a slowed Timer0, two wakes per 20 Hz RVC frame instead of five
  * - Clock divider = 4 in non-DEBUG builds (quarter speed for power saving)
  * - Timer0 interrupt wakes CPU at 100 Hz
+ * - Timer2 samples OUTMON at 4 kHz, in VU meter mode only (ADC stays ON),
+ *   or all the time when INCLUDE_LIMITER or INCLUDE_HOWL_DETECTOR is defined
+ *   (or the loudness trim is on, with INCLUDE_LOUDNESS_TRIM)
  *
  * ============================================================================
  */
@@ -93,10 +114,11 @@
 #define SWITCH_2_PIN GPIO_Pin_6
 
 // LED calibration factors (relative to blue = 1.0)
-#define LED_RED_CALIBRATION 0x49   // Red:   73/255 = 0.286
-#define LED_GREEN_CALIBRATION 0x30 // Green: 48/255 = 0.188
+// These are perceptual levels (see set_rgb()); the duty is led_gamma_table[].
+#define LED_RED_CALIBRATION 0x90   // Red:   291/1023 = 0.284
+#define LED_GREEN_CALIBRATION 0x77 // Green: 191/1023 = 0.187
 #define LED_BLUE_CALIBRATION                                                   \
-  0xFF // Blue: 255/255 = 1.0 (reference is the dimmest LED visually)
+  0xFF // Blue: 1023/1023 = 1.0 (reference is the dimmest LED visually)
 
 // LED override flash color for RVC mode indication
 #define LED_OVERRIDE_FLASH_RED 0
@@ -108,32 +130,210 @@
 // +---------------------------------------------------------------+
 
 // NOTE: BE CAREFUL WITH GLOBAL RAM USAGE!  DIRECT PAGE RAM IS ONLY 256 BYTES,
-//  AND MOST OF THAT RAM IS ALREADY SPOKEN FOR.  If you get a linker error,
-//  consider moving globals to XDATA, where there is 1K of (slower) RAM available,
-//  or change globals to bitfields where possible.
+//  AND MOST OF THAT RAM IS ALREADY SPOKEN FOR.  Declare scalar globals with
+//  MEMVAR(type, name): tools/gen_mem_classes.py profiles the sim and puts each
+//  in __BIT, __DATA or (1K of slower) __XDATA, in include/mem_classes.h.
+//  Re-run it after adding one, or when a linker error says RAM is full.
 
 // Remote Volume Control variables -------------------
-uint8_t res = 0;         // attenuation result
-uint8_t previousRes = 0; // previous attenuation result
-
+MEMVAR(uint8_t, res) = 0;         // attenuation result (slew target)
+MEMVAR(uint8_t, previousRes) = 0; // attenuation currently latched in the LM1971
+
+// Attenuator slew rate.  handle_atten_slew() allows at most
+// ATTEN_SLEW_STEPS_PER_TICK 1dB steps towards res per Timer0 tick, and
+// ADC_Routine() makes each one at the next OUTMON zero crossing.
+// 0.4 dB/ms = 4 steps per 10ms tick => 0dB to MUTE in 160ms
+#define ATTEN_SLEW_DB_PER_MS 0.4
+#define ATTEN_SLEW_STEPS_PER_TICK                                              \
+  ((uint8_t)((ATTEN_SLEW_DB_PER_MS * (1000 / TIMER_FREQUENCY_HZ)) < 1          \
+                 ? 1                                                           \
+                 : (ATTEN_SLEW_DB_PER_MS * (1000 / TIMER_FREQUENCY_HZ))))
+
+// Zero-crossing attenuation steps.  While steps are waiting, OUTMON is
+// sampled with the ADC clock slowed to ATTEN_ZC_ADC_PRESCALER: one ADC
+// interrupt per ATTEN_ZC_SAMPLE_CLOCKS SYSCLKs, not one every 96 back to back.
+// A step lands one conversion after its sample, so a sample heading for 0x80
+// that reaches it within 3/2 samples (on the line through the previous one)
+// is a zero crossing: the step lands about half a sample from it.  So is a
+// sample within ATTEN_ZC_WINDOW of 0x80, or past it (a late catch).  With no
+// crossing for ATTEN_ZC_TIMEOUT_US (bass below ~250Hz, DC) the step is made
+// anyway, so 4 steps always fit in one tick.
+#define ATTEN_ZC_WINDOW 2         // +/- ADC counts around 0x80
+#define ATTEN_ZC_TIMEOUT_US 2000  // longest wait for a crossing, per step
+#define ADC_CONV_CLOCKS 24        // ADC clocks per conversion (reset ADCTIM)
+#define ADC_PRESCALER 0x01        // ADC clock SYSCLK/2/(1+1): 96 SYSCLKs
+#define ATTEN_ZC_ADC_PRESCALER 0x07 // ADC clock SYSCLK/2/(7+1): 384 SYSCLKs
+#define ATTEN_ZC_SAMPLE_CLOCKS                                                 \
+  (2UL * (ATTEN_ZC_ADC_PRESCALER + 1) * ADC_CONV_CLOCKS)
+#define ATTEN_ZC_TIMEOUT_SAMPLES                                               \
+  ((uint16_t)(__SYSCLOCK / ATTEN_ZC_SAMPLE_CLOCKS * ATTEN_ZC_TIMEOUT_US /      \
+              1000000UL))
+
+volatile MEMVAR(uint8_t, atten_zc_steps) = 0; // steps still allowed this tick
+volatile MEMVAR(uint16_t, atten_zc_wait) = 0; // OUTMON samples since the last step
+volatile MEMVAR(int8_t, atten_zc_prev) = 0;   // previous OUTMON sample - 0x80
+volatile MEMVAR(bool, atten_zc_primed) = false; // atten_zc_prev is valid
+volatile MEMVAR(bool, atten_zc_ahead) = false;  // stepped for a crossing not yet seen
+
+// NOTE: one rvc_atten_table[] per mode, in this order (tools/gen_rvc_tables.py)
 typedef enum {
   RVC_DEFAULT_MODE_WITH_MUTE = 0,     // default curve (with MUTE)
   RVC_TRADITIONAL_MA220_MODE = 1      // traditional MA-220 curve (no MUTE)
 } rvc_mode_t;
 
-rvc_mode_t rvc_mode = RVC_DEFAULT_MODE_WITH_MUTE;
+MEMVAR(rvc_mode_t, rvc_mode) = RVC_DEFAULT_MODE_WITH_MUTE;
 
 // Output monitor variables ---------------------------
 // uint8_t OUTMONres = 0; // latest result of output audio monitor sampling
 
+// ADC sequencer variables ----------------------------
+// Filled in the background by ADC_Routine(); control code only reads the
+// latest results, so no one spins on ADC_SamplingFinished().
+volatile MEMVAR(uint8_t, adc_rvc_res) = 0xFF;    // latest ADC7 (RVC) result
+volatile MEMVAR(uint8_t, adc_battmon_res) = 255; // latest ADC0 (BATTMON) result (255 = NOT SET YET)
+
+volatile MEMVAR(uint8_t, adc_seq_channel) = 0;     // channel being converted
+volatile MEMVAR(bool, adc_seq_vu) = false;         // VU sample requested by Timer2
+volatile MEMVAR(bool, adc_seq_rvc) = false;        // RVC still to sample
+volatile MEMVAR(bool, adc_seq_battmon) = false;    // BATTMON still to sample
+volatile MEMVAR(bool, adc_seq_busy) = false;       // sequence in progress
+
+// VU sampling variables ------------------------------
+// In VU meter mode Timer2 requests an OUTMON sample at VU_SAMPLE_HZ, and
+// ADC_Routine() folds it into these; handle_VU_meter() reads and clears them
+// at 20Hz (200 samples).
+#define VU_SAMPLE_HZ 4000
+
+volatile MEMVAR(bool, vu_sampling) = false;    // Timer2 running, ADC kept ON
+volatile MEMVAR(uint8_t, vu_acc_peak) = 0;     // peak |ADC4 - 0x80|
+volatile MEMVAR(uint32_t, vu_acc_sq) = 0;      // sum of (ADC4 - 0x80)^2
+volatile MEMVAR(uint16_t, vu_acc_samples) = 0; // samples in vu_acc_sq
+
+#ifdef INCLUDE_AUTO_ATTEN
+// Automatic attenuation variables --------------------
+// The loudness trim, limiter and howl detector watch every Timer2 OUTMON
+// sample, in every LED mode, and adjust the RVC's attenuation:
+// res = rvc_res + loudness_trim_db + limiter_db + howl_db, so the usual
+// zero-crossing slew applies.
+#if defined(INCLUDE_POWER_DOWN)
+#error "INCLUDE_LIMITER/INCLUDE_HOWL_DETECTOR/INCLUDE_LOUDNESS_TRIM sample OUTMON all the time, they cannot power down"
+#endif
+#define AUTO_ATTEN_MAX 63 // deepest setting short of MUTE
+
+MEMVAR(uint8_t, rvc_res) = 0; // attenuation from the RVC alone
+#endif
+
+#ifdef INCLUDE_LOUDNESS_TRIM
+#ifndef INCLUDE_PREFERENCES
+#error "INCLUDE_LOUDNESS_TRIM is turned on by a preference bit, it needs INCLUDE_PREFERENCES"
+#endif
+// Loudness trim variables ----------------------------
+// Every 50ms frame of OUTMON samples gives a mean square; in dB, plus the
+// LM1971 attenuation it went through, that is the program's level before
+// the attenuator, so neither the RVC nor the trim itself moves it.  Frames
+// below LOUDNESS_GATE_DBFS on OUTMON (too quiet to measure) or more than
+// LOUDNESS_REL_GATE_DB below the average (pauses between songs, fade-outs)
+// are skipped; the rest are averaged over about 2^LOUDNESS_AVG_SHIFT frames
+// (3.2s).  The trim follows (average - target), rounded to 1dB, within
+// +/-LOUDNESS_TRIM_MAX_DB, one 1dB step every LOUDNESS_STEP_FRAMES at most.
+// Levels are dB x 16 (Q4): 10*log10(mean square), see loudness_db_q4().
+#define LOUDNESS_GATE_DBFS 48       // RMS 0.5 counts on OUTMON
+#define LOUDNESS_REL_GATE_DB 20
+#define LOUDNESS_AVG_SHIFT 6        // 64 frames = 3.2s
+#define LOUDNESS_FULL_SCALE_Q4 670  // loudness_db_q4(127 * 127)
+#define LOUDNESS_TARGET_DBFS 18     // program RMS that needs no trim
+#define LOUDNESS_TRIM_MAX_DB 6
+#define LOUDNESS_HYSTERESIS_Q4 16   // 1dB: no hunting around the target
+#define LOUDNESS_STEP_FRAMES 10     // 500ms per 1dB step
+#define LOUDNESS_TARGET_Q4                                                     \
+  (LOUDNESS_FULL_SCALE_Q4 - LOUDNESS_TARGET_DBFS * 16)
+#define LOUDNESS_GATE_Q4 (LOUDNESS_FULL_SCALE_Q4 - LOUDNESS_GATE_DBFS * 16)
+
+volatile MEMVAR(bool, loudness_on) = false; // loudness_trim_pref
+MEMVAR(int8_t, loudness_trim_db) = 0;       // added to the RVC's attenuation
+MEMVAR(bool, loudness_valid) = false;       // loudness_acc holds an average
+MEMVAR(int32_t, loudness_acc) = 0;          // average level (Q4) << LOUDNESS_AVG_SHIFT
+MEMVAR(uint8_t, loudness_step_frames) = 0;  // frames since the last 1dB trim step
+#endif
+
+#ifdef INCLUDE_LIMITER
+// Limiter variables ----------------------------------
+// Each OUTMON sample at or above LIMITER_THRESHOLD is a near-clip hit.  A
+// tick with LIMITER_ATTACK_HITS or more (1ms worth, so a lone spike does not
+// count) adds LIMITER_ATTACK_DB to limiter_db, up to LIMITER_MAX_DB.
+// LIMITER_HOLD_MS after the last such tick it is released, 1dB every
+// LIMITER_RELEASE_MS_PER_DB.
+#define LIMITER_THRESHOLD 115  // |ADC4 - 0x80|, about -0.9dB of full scale
+#define LIMITER_ATTACK_HITS 4  // near-clip samples per tick (of 40)
+#define LIMITER_ATTACK_DB ATTEN_SLEW_STEPS_PER_TICK // as fast as the slew
+#define LIMITER_MAX_DB 12
+#define LIMITER_HOLD_MS 200
+#define LIMITER_RELEASE_MS_PER_DB 50 // 12dB back in 600ms
+
+#define LIMITER_HOLD_TICKS (LIMITER_HOLD_MS / (1000 / TIMER_FREQUENCY_HZ))
+#define LIMITER_RELEASE_TICKS_PER_DB                                           \
+  (LIMITER_RELEASE_MS_PER_DB / (1000 / TIMER_FREQUENCY_HZ))
+#if LIMITER_HOLD_TICKS > 255 || LIMITER_RELEASE_TICKS_PER_DB < 1 ||           \
+    LIMITER_RELEASE_TICKS_PER_DB > 255
+#error "LIMITER_HOLD_MS / LIMITER_RELEASE_MS_PER_DB out of range"
+#endif
+
+volatile MEMVAR(uint8_t, limiter_hits) = 0; // near-clip samples this tick
+MEMVAR(uint8_t, limiter_db) = 0;            // attenuation on top of the RVC's
+MEMVAR(uint8_t, limiter_hold_ticks) = 0;    // ticks left before the release starts
+MEMVAR(uint8_t, limiter_release_ticks) = 0; // ticks since the last 1dB release step
+#endif
+
+#ifdef INCLUDE_HOWL_DETECTOR
+// Howl detector variables ----------------------------
+// Feedback howl is one tone, at any frequency, that keeps building up.  A
+// bank of Goertzel bins wide enough to find it would cost one multiply per
+// bin per sample, so instead ONE resonator is fitted to the signal every
+// tick: for a pure tone d[n-2] + d[n] = 2cos(w) * d[n-1] exactly, so with
+//   A = sum (d[n] + d[n-2])^2,  B = sum d[n-1] * (d[n] + d[n-2]),
+//   C = sum d[n-1]^2
+// the best 2cos(w) is B/C, and what it cannot predict is A/C - (B/C)^2
+// (0 for a tone, about 2 for noise, and well above 0 for chords, drums and
+// voices).  d[] is OUTMON with a first difference, so bass does not swamp it.
+// A tick is tonal if that residual is below 1/2^HOWL_TONAL_SHIFT, the tone is
+// above HOWL_MIN_HZ and C is above the noise floor.  HOWL_DETECT_TICKS tonal
+// ticks in a row are a howl: add HOWL_ATTEN_DB, and again every
+// HOWL_REPEAT_TICKS while it is tonal and not dying away, up to HOWL_MAX_DB.
+// Held for HOWL_HOLD_MS, then released 1dB every HOWL_RELEASE_MS_PER_DB.
+#define HOWL_TONAL_SHIFT 2    // residual < 1/4
+#define HOWL_MIN_C 1600       // ~ -20dBFS tone at 1kHz (40 samples)
+#define HOWL_MIN_HZ 200       // bass notes are not howls
+#define HOWL_2COS_MIN_Q7 243  // 2cos(2pi * HOWL_MIN_HZ / VU_SAMPLE_HZ) * 128
+#define HOWL_DETECT_TICKS 3   // 30ms of one steady tone
+#define HOWL_REPEAT_TICKS 2   // still building up: another step after 20ms
+#define HOWL_ATTEN_DB 3
+#define HOWL_MAX_DB 15
+#define HOWL_HOLD_MS 2000
+#define HOWL_RELEASE_MS_PER_DB 500 // 15dB back in 7.5s
+#if VU_SAMPLE_HZ != 4000 || HOWL_MIN_HZ != 200
+#error "recompute HOWL_2COS_MIN_Q7"
+#endif
+
+#define HOWL_HOLD_TICKS (HOWL_HOLD_MS / (1000 / TIMER_FREQUENCY_HZ))
+#define HOWL_RELEASE_TICKS_PER_DB                                              \
+  (HOWL_RELEASE_MS_PER_DB / (1000 / TIMER_FREQUENCY_HZ))
+
+volatile MEMVAR(int8_t, howl_x) = 0;        // previous OUTMON sample - 0x80
+volatile MEMVAR(int8_t, howl_d1) = 0;       // d[n-1]
+volatile MEMVAR(int8_t, howl_d2) = 0;       // d[n-2]
+volatile MEMVAR(uint32_t, howl_acc_a) = 0;  // sums this tick (see above)
+volatile MEMVAR(int32_t, howl_acc_b) = 0;
+volatile MEMVAR(uint32_t, howl_acc_c) = 0;
+MEMVAR(uint32_t, howl_prev_c) = 0;          // C of the previous tick
+MEMVAR(uint8_t, howl_tonal_ticks) = 0;      // tonal ticks in a row
+MEMVAR(uint8_t, howl_db) = 0;               // attenuation on top of the RVC's
+MEMVAR(uint16_t, howl_hold_ticks) = 0;      // ticks left before the release starts
+MEMVAR(uint8_t, howl_release_ticks) = 0;    // ticks since the last 1dB release step
+#endif
+
 // TIMER VARIABLES
-volatile uint8_t timer_ticks = 0; // cycles from 0 - TIMER_FREQUENCY_HZ
+volatile MEMVAR(uint8_t, timer_ticks) = 0; // cycles from 0 - (TIMER_FREQUENCY_HZ - 1)
 
-// RGB LED color cycling variables
-volatile bool pulseDirectionUP = true;
-volatile uint8_t red = 0;
-// volatile uint8_t green = 0;            // NOT USED
-// volatile uint8_t blue = 0;             // NOT USED
 
 typedef enum {
   // IMPLEMENTED NOW:
@@ -150,99 +350,289 @@ typedef enum {
   EDIT_SW2_MODE = 7
 } led_mode_t;
 
-volatile led_mode_t led_mode = BATTERY_MONITOR_MODE; // current LED mode
+volatile MEMVAR(led_mode_t, led_mode) = BATTERY_MONITOR_MODE; // current LED mode
 #define LAST_LED_MODE SOLID_WHITE_MODE
 
-// LED override mechanism for temporary patterns (e.g., RVC mode change indicator)
-volatile uint8_t led_override_active = 0;      // 0 = normal operation, 1 = override active
-volatile uint8_t led_override_state = 0;       // Current state in override pattern
-volatile uint8_t led_override_tick_counter = 0; // Tick counter for timing within states
-volatile uint8_t led_override_flash_count = 0; // Number of flashes to display (1 or 2)
-volatile uint8_t led_override_flash_current = 0; // Current flash number (0-indexed)
-
-// VU METER COLOR CALCULATION
-// Smooth color transitions based on brightness value b (0-255)
-// Green zone (b=0-191): Pure green, increasing brightness
-// Yellow zone (b=192-223): Transition from green to yellow
-// Red zone (b=224-255): Red only, increasing brightness
-void calculate_vu_color(uint8_t b, uint8_t *r, uint8_t *g, uint8_t *blue) {
-  if (b < 192) {
-    // Green zone: b = 0-191
-    // Linear interpolation from (0,0,0) to (0,33,0)
-    *r = 0;
-    *g = ((uint16_t)b * 33) / 191;
-    *blue = 0;
-  } else if (b < 224) {
-    // Yellow zone: b = 192-223
-    // Linear interpolation from (0,33,0) to (50,40,0)
-    uint16_t t = b - 192;  // 0 to 31
-    *r = ((uint16_t)t * 50) / 31;
-    *g = 33 + ((uint16_t)t * 7) / 31;
-    *blue = 0;
-  } else {
-    // Red zone: b = 224-255
-    // Linear interpolation from (100,0,0) to (255,0,0)
-    uint16_t t = b - 224;  // 0 to 31
-    *r = 100 + ((uint16_t)t * 155) / 31;
-    *g = 0;
-    *blue = 0;
-  }
-}
+// LED sequence player ---------------------------
+// LED patterns (version flashes, RVC mode flashes, pulsing RED) are tables of
+// steps in code space, played one frame per handle_leds() call (20Hz = 50ms),
+// so nothing ever blocks in SYS_Delay().
+//
+// A step shows (r, g, b) for `frames` frames, unless `frames` is an opcode:
+//   LED_SEQ_END     sequence done, back to the normal led_mode
+//   LED_SEQ_LOOP    start over at step 0 (until something else is played)
+//   LED_SEQ_REPEAT  play the next g steps r times (r = 0 skips them; no nesting)
+typedef struct {
+  uint8_t frames;
+  uint8_t r, g, b;
+} led_seq_step_t;
+
+#define LED_SEQ_END 0x00
+#define LED_SEQ_REPEAT 0xFE
+#define LED_SEQ_LOOP 0xFF
+
+#define LED_SEQ_FRAME_MS 50 // handle_leds() runs every RVC_UPDATE_FREQUENCY_TICKS
+#define LED_SEQ_MS(ms) ((uint8_t)((ms) / LED_SEQ_FRAME_MS))
+#define LED_SEQ_VERSION_MS(ms) LED_SEQ_MS((ms) * VERSION_DISPLAY_TIMING_SCALE)
+
+__CODE const led_seq_step_t *led_seq = 0; // sequence being played (0 = none)
+MEMVAR(uint8_t, led_seq_pc) = 0;           // next step to fetch
+MEMVAR(uint8_t, led_seq_frames) = 0;       // frames left in the current step
+MEMVAR(uint8_t, led_seq_repeat_left) = 0;  // passes left of the LED_SEQ_REPEAT block
+MEMVAR(uint8_t, led_seq_repeat_start) = 0; // first step of the block
+MEMVAR(uint8_t, led_seq_repeat_end) = 0;   // step after the block
+
+// LED override for temporary patterns (e.g., RVC mode change indicator)
+volatile MEMVAR(bool, led_override_active) = false; // led_seq overrides led_mode
 
 // BATTERY MONITOR VARIABLES
-uint8_t battmon_res = 255; // latest result of battery monitor sampling (255 = NOT SET YET)
+MEMVAR(uint8_t, battmon_res) = 255; // latest result of battery monitor sampling (255 = NOT SET YET)
 
 #define GREEN_WATERMARK 99  // above this value, solid green
 #define YELLOW_WATERMARK 92 // above this value, solid yellow
 #define RED_WATERMARK 84 // above this value, solid red; below this, pulsing red
 
 // VU METER VARIABLES
-uint8_t abs_out_res =
+MEMVAR(uint8_t, abs_out_res) =
     0; // absolute value of output monitor result centered around 0x80
-
-uint8_t window[4] = {0, 0, 0, 0}; // window for peak detection
-uint8_t window_index = 0; // index for peak detection window
+MEMVAR(uint8_t, vu_rms) = 0; // RMS of the output monitor, same scale as abs_out_res
 
 // VU Meter configuration
-// 1.0 second decay from full scale (at 20Hz)
-#define VU_METER_DECAY_SAMPLES 20
 #define VU_METER_FULL_SCALE 127 // Maximum possible value for abs_out_res
+#if VU_COLOR_ENTRIES != VU_METER_FULL_SCALE + 1
+#error "vu_color_table does not match VU_METER_FULL_SCALE (re-run tools/gen_vu_colors.py)"
+#endif
 // Fixed point math: keep 8 bits of fractional precision for smooth decay
-static uint16_t vu_display_val_fixed = 0;
-
-// Logarithmic Volume Table (0-127 input -> 0-255 brightness/loudness)
-// Maps linear signal amplitude to perceived loudness (approx 40dB range)
-// Method: dB = 20 * log10(x/127). Map -40dB..0dB to 0..255.
-const uint8_t volume_log_table[128] = {
-    0,   16,   25,  48,  64,  76,  86,  95,  102, 108, 114, 120, 124, 129, 133,
-    137, 140, 144, 147, 150, 153, 155, 158, 160, 163, 165, 167, 169, 171, 173,
-    175, 177, 179, 180, 182, 184, 185, 187, 188, 190, 191, 192, 194, 195, 196,
-    198, 199, 200, 201, 202, 203, 204, 206, 207, 208, 209, 210, 211, 212, 213,
-    213, 214, 215, 216, 217, 218, 219, 220, 220, 221, 222, 223, 224, 224, 225,
-    226, 227, 227, 228, 229, 229, 230, 231, 231, 232, 233, 233, 234, 235, 235,
-    236, 237, 237, 238, 238, 239, 240, 240, 241, 241, 242, 242, 243, 243, 244,
-    244, 245, 246, 246, 247, 247, 248, 248, 249, 249, 250, 250, 250, 251, 251,
-    252, 252, 253, 253, 254, 254, 255, 255};
-// END: Log Curve
+MEMVAR(uint16_t, vu_display_val_fixed) = 0;
+
 
 // PREFERENCES VARIABLES
 #ifdef INCLUDE_PREFERENCES
 Preferences_t prefs; // preferences that were persisted in EEPROM
+
+// Write-behind: switch handlers (in the Timer0 ISR) only change prefs and mark
+// them dirty; the main loop commits them once, after a quiet period, so IAP
+// writes and sector erases never stall the ISR, and cycling through the LED
+// modes costs one EEPROM write instead of one per press.
+#define PREFS_COMMIT_QUIET_TICKS (3 * TIMER_FREQUENCY_HZ) // 3s after the last change
+volatile MEMVAR(bool, prefs_dirty) = false;      // prefs changed since the last commit
+volatile MEMVAR(bool, prefs_commit_due) = false; // ...and nothing changed for a while
+volatile MEMVAR(uint16_t, prefs_quiet_ticks) = 0; // ISR only
 #endif
 
 // RVC VARIABLES
 // bool right_handed_volume_control = true; // default to right-handed
 
 // Switches debouncing state (SW1, SW2)
-volatile uint8_t switch1_debounce_counter = 0;
-volatile uint8_t switch2_debounce_counter = 0;
-volatile uint8_t switch1_state =
+volatile MEMVAR(uint8_t, switch1_debounce_counter) = 0;
+volatile MEMVAR(uint8_t, switch2_debounce_counter) = 0;
+volatile MEMVAR(uint8_t, switch1_state) =
     1; // 1 = not pressed (pulled high), 0 = pressed
-volatile uint8_t switch2_state =
+volatile MEMVAR(uint8_t, switch2_state) =
     1; // 1 = not pressed (pulled high), 0 = pressed
+volatile MEMVAR(uint8_t, switch_held_at_boot) =
+    0; // bit 0 = SW1, bit 1 = SW2: its first release is not a switch press
+// SW1/SW2 are polled on every Timer0 tick: the STC8G1K08 has no I/O port
+// interrupts, and P1.5/P1.6 are not INTx pins (those carry VOL_*, LEDs, RXD).
+
+#ifdef INCLUDE_POWER_DOWN
+// Power-down configuration
+#define POWER_DOWN_QUIET_TICKS (3 * TIMER_FREQUENCY_HZ) // 3s with nothing changing
+#define POWER_DOWN_WAKE_MS 50 // wake-up timer period = RVC update period
+#define POWER_DOWN_ADC_SETTLE_MS 10 // ADC power-on to first conversion: one
+                                    // tick, as in the 100Hz loop
+#define POWER_DOWN_BATTMON_WAKES                                               \
+  (1000 / POWER_DOWN_WAKE_MS) // battery monitor once per second
+
+volatile MEMVAR(uint16_t, power_down_quiet_ticks) = 0; // ticks with nothing changing
+MEMVAR(uint8_t, power_down_res) = 0;                   // res at the previous tick
+MEMVAR(uint8_t, power_down_battmon_wakes) = 0;
+MEMVAR(bool, led_dark) = true; // set_rgb()'s last color was all OFF
+volatile MEMVAR(bool, slow_tick) = false;       // power_down() in IDLE, LED lit
+volatile MEMVAR(bool, slow_tick_fired) = false; // ... and Timer0 has fired
+#endif
+
+#ifdef INCLUDE_DISPLAY
+// The SSD1306 is started from the main loop once it has had 100ms to power
+// up, counted from the first Timer0 tick (timer_ticks starts at
+// SCHED_PHASE_LEDS)
+#define DISPLAY_START_TICK (SCHED_PHASE_LEDS + TIMER_FREQUENCY_HZ / 10)
+MEMVAR(bool, display_started) = false;
+#endif
 
 // UTILS ================================
-#define nop() __asm__(" nop");
+#define nop() NOP()
+
+// +---------------------------------------------------------------+
+// | ADC SEQUENCER FUNCTIONS                                       |
+// +---------------------------------------------------------------+
+// Conversions are requested by setting a flag; the sequencer takes them one
+// at a time in this order: a VU sample (Timer2, so its timing is regular),
+// RVC, BATTMON, then OUTMON for as long as attenuation steps are waiting for
+// a zero crossing (at the slower ATTEN_ZC_ADC_PRESCALER clock, which paces
+// them).  Each conversion is started from the ADC interrupt of the previous
+// one; the CPU sits in IDLE in between.  The ADC is powered off when nothing
+// is left to do, unless VU sampling keeps it ON.  It is left at the
+// ADC_PRESCALER clock when idle, for VU_Routine().
+// ADC_Routine() expands it in place, so it calls nothing in bank 0.
+#define ADC_SEQ_NEXT()                                                         \
+  do {                                                                         \
+    ADC_SetClockPrescaler(ADC_PRESCALER);                                      \
+    if (adc_seq_vu) {                                                          \
+      adc_seq_channel = ADCCHANNEL_OUTMON;                                     \
+    } else if (adc_seq_rvc) {                                                  \
+      adc_seq_channel = ADCCHANNEL_RVC;                                        \
+    } else if (adc_seq_battmon) {                                              \
+      adc_seq_channel = ADCCHANNEL_BATTMON;                                    \
+    } else if (atten_zc_steps != 0) {                                          \
+      adc_seq_channel = ADCCHANNEL_OUTMON; /* watch for a zero crossing */     \
+      ADC_SetClockPrescaler(ATTEN_ZC_ADC_PRESCALER);                           \
+    } else {                                                                   \
+      adc_seq_busy = false;                                                    \
+      if (!vu_sampling) {                                                      \
+        ADC_SetPowerState(HAL_State_OFF); /* sequence done, save power */      \
+      }                                                                        \
+      break;                                                                   \
+    }                                                                          \
+    adc_seq_busy = true;                                                       \
+    ADC_SetChannel(adc_seq_channel);                                           \
+    ADC_Start();                                                               \
+  } while (0)
+
+void adc_seq_next(void) { ADC_SEQ_NEXT(); }
+
+// RVC, then (optionally) BATTMON
+void adc_seq_start(bool battmon) {
+  adc_seq_battmon = battmon;
+  adc_seq_rvc = true;
+  if (!adc_seq_busy) {
+    // normally still ON from the tick before, unless a zero-crossing watch
+    // has just ended and turned it OFF
+    ADC_SetPowerState(HAL_State_ON);
+    adc_seq_next();
+  }
+}
+
+void setAttenuation(uint8_t attenInDB); // forward declarations
+void atten_write_isr(uint8_t attenInDB) ISR_USING;
+
+// =============================================================
+// Called from ADC_Routine() with each OUTMON sample while attenuation steps
+// are waiting -- make one 1dB step at a zero crossing (or on timeout)
+void atten_zc_sample(uint8_t val) ISR_USING {
+  int8_t x = val - 0x80;
+  uint8_t abs_x = (x < 0) ? -x : x;
+  uint8_t abs_prev = (atten_zc_prev < 0) ? -atten_zc_prev : atten_zc_prev;
+  bool crossing = false;
+
+  if (!atten_zc_primed) {
+    atten_zc_ahead = false; // first sample after a gap
+  } else if (atten_zc_ahead) {
+    // already stepped for this crossing: wait until it has gone by
+    atten_zc_ahead = ((x < 0) == (atten_zc_prev < 0));
+  } else if (abs_x <= ATTEN_ZC_WINDOW) {
+    crossing = true; // (nearly) silent: any time is a zero crossing
+  } else if ((x < 0) != (atten_zc_prev < 0)) {
+    crossing = true; // crossed since the previous sample
+  } else if ((uint16_t)abs_x * 4 + abs_x <= (uint16_t)abs_prev * 2 + abs_prev) {
+    crossing = true; // 5|x| <= 3|prev|: due within 3/2 samples at this slope
+    atten_zc_ahead = true;
+  }
+  atten_zc_prev = x;
+  atten_zc_primed = true;
+
+  if (!crossing && ++atten_zc_wait < ATTEN_ZC_TIMEOUT_SAMPLES) {
+    return;
+  }
+  atten_zc_wait = 0;
+
+  if (previousRes < res) {
+    previousRes++; // step UP to get to correct level of attenuation
+  } else if (res < previousRes) {
+    previousRes--; // step DOWN to get to correct level of attenuation
+  } else {
+    atten_zc_steps = 0; // res moved back while we waited
+    return;
+  }
+  atten_write_isr(previousRes);
+
+  atten_zc_steps = (previousRes == res) ? 0 : atten_zc_steps - 1;
+}
+
+#ifdef INCLUDE_HOWL_DETECTOR
+// =============================================================
+// Called from ADC_Routine() with each Timer2 OUTMON sample -- accumulate the
+// howl detector's A, B and C (four 8x8 multiplies: MUL AB in line, where an
+// 8x16 one would call SDCC's bank 0 _mulint from this bank ISR_BANK helper)
+void howl_sample(int8_t x) ISR_USING {
+  int8_t d = (x >> 1) - (howl_x >> 1); // first difference, fits int8
+  int16_t outer = (int16_t)d + howl_d2; // d[n] + d[n-2]
+  uint8_t abs_outer = (outer < 0) ? -outer : outer; // <= 254
+  uint8_t abs_d1 = (howl_d1 < 0) ? -howl_d1 : howl_d1;
+  howl_x = x;
+
+  howl_acc_a += (uint16_t)abs_outer * abs_outer; // squares: 8x8 MUL AB
+  howl_acc_b += (int16_t)howl_d1 * d + (int16_t)howl_d1 * howl_d2; // d1 * outer
+  howl_acc_c += (uint16_t)abs_d1 * abs_d1;
+  howl_d2 = howl_d1;
+  howl_d1 = d;
+}
+#endif
+
+// =============================================================
+// ADC interrupt handler -- store the result, start the next conversion
+INTERRUPT_USING(ADC_Routine, EXTI_VectADC, ISR_BANK) {
+  ADC_ClearInterrupt();
+  uint8_t val = ADC_RES;
+
+  if (adc_seq_channel == ADCCHANNEL_RVC) {
+    adc_rvc_res = val;
+    adc_seq_rvc = false;
+    atten_zc_primed = false; // a crossing during this gap would be late
+  } else if (adc_seq_channel == ADCCHANNEL_OUTMON) {
+    if (adc_seq_vu) {
+      adc_seq_vu = false;
+      int8_t out_res = val - 0x80; // audio is centered around 0x80
+      uint8_t abs_val = (out_res < 0) ? -out_res : out_res;
+      if (abs_val > vu_acc_peak) {
+        vu_acc_peak = abs_val; // keep track of peak
+      }
+      vu_acc_sq += (uint16_t)abs_val * abs_val; // 8x8 MUL AB
+      vu_acc_samples++;
+#ifdef INCLUDE_LIMITER
+      if (abs_val >= LIMITER_THRESHOLD && limiter_hits != 0xFF) {
+        limiter_hits++;
+      }
+#endif
+#ifdef INCLUDE_HOWL_DETECTOR
+      howl_sample(out_res);
+#endif
+    }
+    if (atten_zc_steps != 0) {
+      atten_zc_sample(val); // mid-slew, a VU sample is a paced one too
+    }
+  } else {
+    adc_battmon_res = val;
+    adc_seq_battmon = false;
+    atten_zc_primed = false;
+  }
+
+  ADC_SEQ_NEXT();
+}
+
+// =============================================================
+// Timer2 interrupt handler (VU_SAMPLE_HZ, VU meter mode or INCLUDE_AUTO_ATTEN) -- request one
+// OUTMON sample.  If a conversion is running, it comes right after that one.
+// Nothing else is waiting (not busy), so this is ADC_SEQ_NEXT()'s first case.
+INTERRUPT_USING(VU_Routine, EXTI_VectTimer2, ISR_BANK) {
+  adc_seq_vu = true;
+  if (!adc_seq_busy) {
+    adc_seq_busy = true;
+    adc_seq_channel = ADCCHANNEL_OUTMON;
+    ADC_SetChannel(ADCCHANNEL_OUTMON);
+    ADC_Start();
+  }
+}
 
 #ifdef INCLUDE_TEST_POINT
 // TEST POINT ===========================
@@ -263,40 +653,109 @@ void init_VU_meter() {
   // ADC_SetClockPrescaler(0x01);    // ADC Clock = SYSCLK / 2 / (1+1) = SYSCLK
   // / 4 ADC_SetResultAlignmentLeft();   // Left alignment, high 8-bit in
   // ADC_RES ADC_SetPowerState(HAL_State_ON); // Turn on ADC power
+
+  // Timer2 = VU sample clock, started by vu_sampling_set()
+  TIM_Timer2_Config(HAL_State_ON, 0, VU_SAMPLE_HZ); // 1T, no prescaler
+  EXTI_Timer2_SetIntState(HAL_State_ON);
 }
 
 // =============================================================
-void set_rgb(uint8_t r, uint8_t g, uint8_t b); // forward declaration
-
-void handle_VU_meter(void) {
-  // READ ADC4 value with peak detection --------
-  // Sample multiple times to catch peaks in audio waveform
-  // For 1kHz audio (1ms period), taking 20 samples ensures we catch the peak
-
-  uint8_t peak_value = 0;
-  ADC_SetChannel(ADCCHANNEL_OUTMON); // Channel: ADC4 (P1.4 - RVC)
-
-  // Take 20 samples and keep the maximum
-  for (uint8_t i = 0; i < 20; i++) {
-    ADC_Start();
-    nop();
-    nop();
-
-    while (!ADC_SamplingFinished())
-      ; // WAIT...
+// 100Hz interrupt handler -- run the VU sample clock only in VU meter mode
+// (or always, for the limiter / howl detector, or while the loudness trim is on)
+void vu_sampling_set(bool on) {
+  if (on == vu_sampling) {
+    return;
+  }
+  vu_sampling = on;
+  if (on) {
+    ADC_SetPowerState(HAL_State_ON); // stays ON between samples
+    vu_acc_peak = 0;
+    vu_acc_sq = 0;
+    vu_acc_samples = 0;
+  } else if (!adc_seq_busy) {
+    ADC_SetPowerState(HAL_State_OFF);
+  }
+  TIM_Timer2_SetRunState(on);
+}
 
-    ADC_ClearInterrupt();
-    uint8_t OUTMONres = ADC_RES;
-    int8_t out_res = OUTMONres - 0x80; // audio is centered around 0x80
-    uint8_t abs_val = (out_res < 0) ? -out_res : out_res;
+// =============================================================
+// 20Hz (from handle_leds) -- move vu_display_val_fixed (8.8) towards the
+// latest frame with the VU_METER_BALLISTICS of globals.h.  One-pole IIR
+// filters whose coefficients are sums of powers of two, so it is all 16-bit
+// shifts and adds (no multiply, no 32-bit math):
+//   PPM: rise at once to the frame's true peak; fall by 1/16 + 1/128 per
+//        frame (DIN: 20dB in 1.58s) or 1/32 + 1/64 (BBC: 24dB in 2.88s)
+//   VU:  RMS x 1.41 (a sine reads its peak, like the PPMs), 1/2 + 1/16 of
+//        the way per frame both ways (99% in 300ms, without the needle's
+//        1% overshoot)
+void vu_meter_ballistics(void) {
+  uint16_t x = vu_display_val_fixed;
+#if VU_METER_BALLISTICS == VU_BALLISTICS_VU
+  uint16_t in = ((uint16_t)vu_rms << 8) + ((uint16_t)vu_rms << 6) +
+                ((uint16_t)vu_rms << 5) + ((uint16_t)vu_rms << 3);
+  if (in > ((uint16_t)VU_METER_FULL_SCALE << 8)) {
+    in = (uint16_t)VU_METER_FULL_SCALE << 8;
+  }
+  if (in >= x) {
+    uint16_t d = in - x;
+    x += (d >> 1) + (d >> 4);
+  } else {
+    uint16_t d = x - in;
+    x -= (d >> 1) + (d >> 4);
+  }
+#else
+  uint16_t in = (uint16_t)abs_out_res << 8;
+  if (in >= x) {
+    x = in; // instant rise (a 50ms frame's true peak)
+  } else {
+#if VU_METER_BALLISTICS == VU_BALLISTICS_PPM_BBC
+    x -= (x >> 5) + (x >> 6);
+#else
+    x -= (x >> 4) + (x >> 7);
+#endif
+    if (x < in) {
+      x = in;
+    }
+  }
+#endif
+  // Snap to zero if below threshold (1.0 in 8.8 fixed point)
+  vu_display_val_fixed = (x < 256) ? 0 : x;
+}
 
-    // Keep track of peak
-    if (abs_val > peak_value) {
-      peak_value = abs_val;
+// =============================================================
+// integer square root, for RMS (x <= 16384)
+uint8_t isqrt16(uint16_t x) {
+  uint8_t root = 0;
+  for (uint8_t bit = 0x80; bit != 0; bit >>= 1) {
+    uint8_t trial = root | bit;
+    if ((uint16_t)trial * trial <= x) {
+      root = trial;
     }
   }
+  return root;
+}
 
-  abs_out_res = peak_value;
+// =============================================================
+void set_rgb(uint8_t r, uint8_t g, uint8_t b); // forward declaration
+#ifdef INCLUDE_LOUDNESS_TRIM
+void handle_loudness(uint32_t sum_sq, uint16_t samples); // forward declaration
+#endif
+
+void handle_VU_meter(void) {
+  // True peak and RMS of every OUTMON sample since the last call (Timer2 at
+  // VU_SAMPLE_HZ, so 200 samples at 20Hz).  Same priority as ADC_Routine(),
+  // so the accumulators cannot change under us.
+  uint16_t mean_sq = (vu_acc_samples != 0) ? vu_acc_sq / vu_acc_samples : 0;
+  abs_out_res = vu_acc_peak;
+  vu_rms = isqrt16(mean_sq);
+#ifdef INCLUDE_LOUDNESS_TRIM
+  if (loudness_on && vu_acc_samples != 0) {
+    handle_loudness(vu_acc_sq, vu_acc_samples); // sum: quiet frames, too
+  }
+#endif
+  vu_acc_peak = 0;
+  vu_acc_sq = 0;
+  vu_acc_samples = 0;
 
 #ifdef DEBUG
   // PRINT ADC for VU METER -----
@@ -310,8 +769,6 @@ void handle_VU_meter(void) {
 // | REMOTE VOLUME CONTROL FUNCTIONS                               |
 // +---------------------------------------------------------------+
 // Configure ADC7 (P1.7 - RVC) for battery voltage monitoring
-void setAttenuation(uint8_t attenInDB); // forward declaration
-
 void init_RVC() {
   GPIO_P1_SetMode(GPIO_Pin_7, GPIO_Mode_Input_HIP); // Set ADC7(GPIO P1.7) HIP
 
@@ -328,70 +785,183 @@ void init_RVC() {
   PIN_ATTEN_CLK = 1;  // CLK
   PIN_ATTEN_DATA = 1; // DATA
 
-  setAttenuation(15); // low output until AFTER the firmware version flashes,
+  setAttenuation(15); // low output until the first RVC reading,
                       // then RVC-specified output
 }
 
-// ============================================================
-// Fast lookup table method to convert RVC (0-133) to Attenuation (0 to 63)
-//
-// This curve is based on following measurements of the traditional MA-200 attenuation 
-//    vs remote volume control position.  It does not have a MUTE feature,
-//    like our default attenuation curve.
-//
-// RVC,attenuation_dB
-// 1,0
-// 0.875,-1.5010471526555516
-// 0.75,-4.4084218269296525
-// 0.625,-6.363435814235585
-// 0.5,-8.636989461747557
-// 0.375,-10.011288052965444
-// 0.25,-10.936623787957386
-// 0.125,-11.527373590991886
-// 0,-11.840504365156153
-
-// Lookup table generated from CSV data with minimized quantization error
-static const int8_t atten_lookup[134] = {
-    -12, -12, -12, -12, -12, -12, -12, -12, -12, -12,  // RVC 0-9
-    -12, -12, -12, -12, -12, -12, -12, -12, -11, -11,  // RVC 10-19
-    -11, -11, -11, -11, -11, -11, -11, -11, -11, -11,  // RVC 20-29
-    -11, -11, -11, -11, -11, -11, -11, -11, -11, -11,  // RVC 30-39
-    -11, -11, -10, -10, -10, -10, -10, -10, -10, -10,  // RVC 40-49
-    -10, -10, -10, -10, -10, -10, -10,  -9,  -9,  -9,  // RVC 50-59
-     -9,  -9,  -9,  -9,  -9,  -9,  -9,  -9,  -8,  -8,  // RVC 60-69
-     -8,  -8,  -8,  -8,  -8,  -8,  -7,  -7,  -7,  -7,  // RVC 70-79
-     -7,  -7,  -7,  -6,  -6,  -6,  -6,  -6,  -6,  -6,  // RVC 80-89
-     -6,  -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,  // RVC 90-99
-     -4,  -4,  -4,  -4,  -4,  -3,  -3,  -3,  -3,  -3,  // RVC 100-109
-     -3,  -2,  -2,  -2,  -2,  -2,  -2,  -1,  -1,  -1,  // RVC 110-119
-     -1,  -1,  -1,  -1,  -1,  -1,  -1,  -1,   0,   0,  // RVC 120-129
-      0,   0,   0,   0                                 // RVC 130-133
-};
+#ifdef INCLUDE_AUTO_ATTEN
+// +---------------------------------------------------------------+
+// | AUTOMATIC ATTENUATION FUNCTIONS                               |
+// +---------------------------------------------------------------+
+// RVC attenuation, trimmed for loudness, plus the limiter's and howl
+// detector's (MUTE stays MUTE)
+uint8_t auto_atten_res(uint8_t atten) {
+  if (atten >= 64) {
+    return atten;
+  }
+#ifdef INCLUDE_LOUDNESS_TRIM
+  if (loudness_trim_db >= 0) {
+    atten += loudness_trim_db;
+  } else {
+    atten = (atten > (uint8_t)-loudness_trim_db) ? atten + loudness_trim_db : 0;
+  }
+#endif
+#ifdef INCLUDE_LIMITER
+  atten += limiter_db;
+#endif
+#ifdef INCLUDE_HOWL_DETECTOR
+  atten += howl_db;
+#endif
+  return (atten > AUTO_ATTEN_MAX) ? AUTO_ATTEN_MAX : atten;
+}
+#endif
 
-uint8_t rvc_to_hilton_attenuation(uint8_t rvc)
-{
-    if (rvc > 133) {
-      rvc = 133;
-    }
-    // NOTE: if needed, we can provide more guard band at the top by adding an offset here
-    return (uint8_t)(-atten_lookup[rvc]);  // 134-byte lookup table (returns POSITIVE attenuation 0 - 63dB)
+#ifdef INCLUDE_LOUDNESS_TRIM
+// 10*log10(x) in dB x 16, x >= 1: 3dB (48) per octave, and a table for the
+// 4 bits after the leading one
+__CODE const uint8_t loudness_mantissa_q4[16] = {
+    0, 4, 8, 12, 16, 19, 22, 25, 28, 31, 34, 36, 39, 41, 44, 46};
+
+int16_t loudness_db_q4(uint32_t x) {
+  int8_t octave = 4; // x = m * 2^(octave - 4), m = 16..31
+  while (x >= 32) {
+    x >>= 1;
+    octave++;
+  }
+  while (x < 16) {
+    x <<= 1;
+    octave--;
+  }
+  return (int16_t)octave * 48 + loudness_mantissa_q4[(uint8_t)x - 16];
 }
 
 // =============================================================
-void handle_RVC(bool force) {
-#define ATTEN_STEP_DELAY_US 50
+// 20Hz (from handle_VU_meter) -- fold this frame's mean square into the
+// program level and move the trim towards it
+void handle_loudness(uint32_t sum_sq, uint16_t samples) {
+  if (sum_sq == 0 || previousRes >= 64) {
+    return; // silence, or MUTE: keep the estimate and the trim
+  }
+  int16_t level = loudness_db_q4(sum_sq) - loudness_db_q4(samples);
+  if (level < LOUDNESS_GATE_Q4) {
+    return; // too quiet to measure
+  }
+  // level before the LM1971: what it latched for this frame (1dB = 16)
+  level += (int16_t)previousRes * 16;
+  if (loudness_valid && level < (int16_t)(loudness_acc >> LOUDNESS_AVG_SHIFT) -
+                                    LOUDNESS_REL_GATE_DB * 16) {
+    return; // a pause, not the song getting quieter
+  }
+  if (!loudness_valid) {
+    loudness_acc = (int32_t)level << LOUDNESS_AVG_SHIFT; // first frame
+    loudness_valid = true;
+  } else {
+    loudness_acc += level - (int16_t)(loudness_acc >> LOUDNESS_AVG_SHIFT);
+  }
+
+  if (loudness_step_frames < LOUDNESS_STEP_FRAMES) {
+    loudness_step_frames++;
+    return;
+  }
+  // too loud: more attenuation; too quiet: less
+  int16_t error = (int16_t)(loudness_acc >> LOUDNESS_AVG_SHIFT) -
+                  LOUDNESS_TARGET_Q4 - (int16_t)loudness_trim_db * 16;
+  if (error > LOUDNESS_HYSTERESIS_Q4 &&
+      loudness_trim_db < LOUDNESS_TRIM_MAX_DB) {
+    loudness_trim_db++;
+    loudness_step_frames = 0;
+  } else if (error < -LOUDNESS_HYSTERESIS_Q4 &&
+             loudness_trim_db > -LOUDNESS_TRIM_MAX_DB) {
+    loudness_trim_db--;
+    loudness_step_frames = 0;
+  }
+}
+#endif
+
+#ifdef INCLUDE_LIMITER
+// =============================================================
+// 100Hz interrupt handler -- attack on a tick with near-clip peaks, hold,
+// then release slowly.  Same priority as ADC_Routine(), so limiter_hits
+// cannot change under us.
+void handle_limiter(void) {
+  uint8_t hits = limiter_hits;
+  limiter_hits = 0;
+
+  if (hits >= LIMITER_ATTACK_HITS) {
+    limiter_db = (limiter_db > LIMITER_MAX_DB - LIMITER_ATTACK_DB)
+                     ? LIMITER_MAX_DB
+                     : limiter_db + LIMITER_ATTACK_DB;
+    limiter_hold_ticks = LIMITER_HOLD_TICKS;
+    limiter_release_ticks = 0;
+  } else if (limiter_hold_ticks != 0) {
+    limiter_hold_ticks--;
+  } else if (limiter_db != 0 &&
+             ++limiter_release_ticks >= LIMITER_RELEASE_TICKS_PER_DB) {
+    limiter_release_ticks = 0;
+    limiter_db--;
+  }
+}
+#endif
 
-  // READ ADC7 value --------
-  ADC_SetChannel(ADCCHANNEL_RVC); // Channel: ADC7 (P1.0 - RVC)
-  ADC_Start();
-  nop();
-  nop();
+#ifdef INCLUDE_HOWL_DETECTOR
+// =============================================================
+// 100Hz interrupt handler -- is this tick one steady tone?  Same priority as
+// ADC_Routine(), so the sums cannot change under us.
+bool howl_tonal(void) {
+  uint32_t a = howl_acc_a;
+  int32_t b = howl_acc_b;
+  uint32_t c = howl_acc_c;
+  bool building = (c >= howl_prev_c);
+  howl_acc_a = 0;
+  howl_acc_b = 0;
+  howl_acc_c = 0;
+  howl_prev_c = c;
+
+  if (c < HOWL_MIN_C) {
+    return false; // too quiet to tell
+  }
+  // scale to 15 bits, so that the products fit 32 bits (|B| <= sqrt(A*C))
+  while ((a | c) >= 0x8000) {
+    a >>= 1;
+    b >>= 1;
+    c >>= 1;
+  }
+  if (b * 128 >= (int32_t)c * HOWL_2COS_MIN_Q7) {
+    return false; // below HOWL_MIN_HZ
+  }
+  // residual A/C - (B/C)^2 < 1/2^HOWL_TONAL_SHIFT, and not dying away
+  return ((int32_t)(a * c) - b * b < (int32_t)((c * c) >> HOWL_TONAL_SHIFT)) &&
+         (building || howl_tonal_ticks < HOWL_DETECT_TICKS);
+}
 
-  while (!ADC_SamplingFinished())
-    ; // WAIT...
+// =============================================================
+// 100Hz interrupt handler -- attenuate a howl, hold, then release slowly
+void handle_howl(void) {
+  if (!howl_tonal()) {
+    howl_tonal_ticks = 0;
+  } else if (++howl_tonal_ticks >= HOWL_DETECT_TICKS) {
+    howl_tonal_ticks = HOWL_DETECT_TICKS - HOWL_REPEAT_TICKS;
+    howl_db = (howl_db > HOWL_MAX_DB - HOWL_ATTEN_DB) ? HOWL_MAX_DB
+                                                     : howl_db + HOWL_ATTEN_DB;
+    howl_hold_ticks = HOWL_HOLD_TICKS;
+    howl_release_ticks = 0;
+    return;
+  }
 
-  ADC_ClearInterrupt();
-  uint8_t RVCval = ADC_RES;
+  if (howl_hold_ticks != 0) {
+    howl_hold_ticks--;
+  } else if (howl_db != 0 &&
+             ++howl_release_ticks >= HOWL_RELEASE_TICKS_PER_DB) {
+    howl_release_ticks = 0;
+    howl_db--;
+  }
+}
+#endif
+
+// =============================================================
+void handle_RVC(bool force) {
+  // latest ADC7 value (from the ADC sequencer) --------
+  uint8_t RVCval = adc_rvc_res;
 
 #ifdef DEBUG
   // // PRINT ADC for RVC -----
@@ -399,68 +969,19 @@ void handle_RVC(bool force) {
   // UART1_TxString(",");
 #endif
 
-  if (RVCval > 0xE0) {
-    // no Remote Volume Control at all, so result attenuation (res) is 0dB
-    res = 0;
-  } else if (rvc_mode == RVC_TRADITIONAL_MA220_MODE) {
-    // we have a Remote Volume Control plugged in, use traditional MA-220 curve
-    // Reverse RVCval so that 0 = loudest (0dB), matching the Default curve direction
-    uint8_t rvc_reversed = (RVCval >= 133) ? 0 : (133 - RVCval);
-    res = rvc_to_hilton_attenuation(rvc_reversed); // range(rvc_reversed)=0-133 -> range(res) = 0-12
-  } else if (rvc_mode == RVC_DEFAULT_MODE_WITH_MUTE) {
-    // we have a Remote Volume Control plugged in
-
-    // RVCval range = {0, 133 or so (depends on tolerance of pot)}
-    uint16_t top = (RVCval << 8) - RVCval; // (RVCval * 255)
-    uint16_t bot = (255 - RVCval);         // (255 - RVCval)
-    uint16_t linearPotVal =
-        top / bot; // range: {0, 256}
-                   // NOTE: this divide should be fast, because STC8G1K08A has
-                   // MCU16 HW divider REVISIT: STC8G1K08 does NOT have hardware
-                   // divider, so this is a software divide
-
-    if (linearPotVal > 255) {
-      linearPotVal = 255; // cap this, just in case
-    }
-
-    /* ******************** NEW ALGORITHM ******************** */
-    // ***** J1 IN = LEFT-HANDED or "REVERSED" VOL CTRL DIRECTION
-    uint8_t A = 3 * 64; // turn pot 3/4 of the way
-    uint8_t B = 14;     //  to attenuate by 12dB @ knee of the curve
-    uint8_t C = 48;     // then drop to mute
-    uint8_t D = 236;    //  at the end of the pot travel (guard band)
-    uint8_t E = 6;      //  at the beginning of the pot travel (guard band)
-
-    // FUTURE: deal with left-handed vs right-handed volume control
-    // if (!right_handed_volume_control) {
-    //   // ***** LEFT-HANDED or "REVERSED" VOL CTRL DIRECTION
-    //   // A = 3*64;  // these are the same for both cases, so commented them out
-    //   // B = 14;
-    //   // C = 48;
-    //   // D = 236;
-    //   E = 11;
-    //   linearPotVal = 255 - linearPotVal; // 255 - 0
-    // }
-
-    // the newest algorithm -----------------
-    if (linearPotVal < E) {
-      res = 0; // result = no attenuation
-    } else if (linearPotVal > D) {
-      res = 64; // attenuation = MAX
-    } else if (linearPotVal <= A) {
-      // intermediate result = uint16, attenuation is positive
-      res = ((linearPotVal - E) * B) / A;
-    } else { // x > A
-      // intermediate result = uint16, attenuation is positive
-      res = B + ((uint16_t)(linearPotVal - A) * (uint8_t)(C - B)) /
-                    (uint8_t)(D - A);
-    }
-    /* ******************** END NEW ALGORITHM ******************** */
-
+  // RVC curves are precomputed for every ADC value (src/rvc_tables.c,
+  // generated by tools/gen_rvc_tables.py), including the "no Remote Volume
+  // Control plugged in" (RVCval > 0xE0) => 0dB case
+  if (rvc_mode < RVC_TABLE_MODES) {
+    res = rvc_atten_table[rvc_mode][RVCval];
   } else {
     // unknown RVC mode, default to no attenuation
     res = 0; // this should never occur, but if it does, be safe
-  } // end else
+  }
+#ifdef INCLUDE_AUTO_ATTEN
+  rvc_res = res;
+  res = auto_atten_res(rvc_res);
+#endif
 
 #ifdef DEBUG
   // PRINT ATTENUATION for RVC (negative sign omitted) -----
@@ -470,181 +991,136 @@ void handle_RVC(bool force) {
 
   if (force) {
     setAttenuation(res); // one time force
-  } else {
-    // step it up or down in increments of 1 dB to avoid zipper effect
-    if (previousRes < res) {
-      // step UP to get to correct level of attenuation
-      for (uint8_t a = previousRes + 1; a < res; a++) {
-        setAttenuation(a);
-#if ATTEN_STEP_DELAY_US > 0
-        SYS_DelayUs(ATTEN_STEP_DELAY_US);
-#endif
-      }
-      setAttenuation(res);
-    } else if (res < previousRes) {
-      // step DOWN to get to correct level of attenuation
-      for (uint8_t a = previousRes - 1; a > res; a--) {
-        setAttenuation(a);
-#if ATTEN_STEP_DELAY_US > 0
-        SYS_DelayUs(ATTEN_STEP_DELAY_US);
-#endif
-      }
-      setAttenuation(res);
-    } else {
-      // else do nothing if old and new attenuation values are equal
-      // setAttenuation(res);  // DEBUG DEBUG DEBUG
-    }
+    previousRes = res;
   }
-  previousRes = res; // remember where we are now (regardless of force or not)
+  // otherwise handle_atten_slew() walks the LM1971 to the new res
 }
 
 // =============================================================
-// 0 = 0dB attenuation, >=63 = MUTE
-void setAttenuation(uint8_t attenInDB) {
-  // Expanding all loops so that the entire cycle takes the minimal time
-  //   to set the attenuation.  This completely eliminates popping!
-  // This also allows us to return from servicing ASAP, to reduce power
-  // consumption.
-  PIN_ATTEN_CLK = 0;
-  PIN_ATTEN_DATA = 0;
-  PIN_ATTEN_LOAD =
-      0; // SPEC: CLOCK must go down before LOAD goes down (2 cycles = 84ns)
-  nop();
-  nop();
-  nop();
-  nop();
-  nop();
-  nop();
-
-  // ADDRESS = 0x00 ----------------------
-  // SPEC: LOAD LOW to CLOCK HIGH >200ns ( 6 * 42 = 252ns)
-  // SPEC: DATA VALID to CLOCK HIGH > 100ns ( 7 * 42 = 294ns)
-  PIN_ATTEN_CLK = 1; // A7
-  nop(); // these might not be strictly necessary, but it makes them more
-         // visible on Saleae
-  PIN_ATTEN_CLK = 0;
-  nop();
-  PIN_ATTEN_CLK = 1; // A6
-  nop();
-  PIN_ATTEN_CLK = 0;
-  nop();
-  PIN_ATTEN_CLK = 1; // A5
-  nop();
-  PIN_ATTEN_CLK = 0;
-  nop();
-  PIN_ATTEN_CLK = 1; // A4
-  nop();
-  PIN_ATTEN_CLK = 0;
-  nop();
-  PIN_ATTEN_CLK = 1; // A3
-  nop();
-  PIN_ATTEN_CLK = 0;
-  nop();
-  PIN_ATTEN_CLK = 1; // A2
-  nop();
-  PIN_ATTEN_CLK = 0;
-  nop();
-  PIN_ATTEN_CLK = 1; // A1
-  nop();
-  PIN_ATTEN_CLK = 0;
-  nop();
-  PIN_ATTEN_CLK = 1; // A0
-  nop();             // SPEC: DATA HOLD TIME > 50ns (2 cycles = 84ns)
-
-  // DATA -----------------------------
-  PIN_ATTEN_CLK = 0; // CLK low
-  PIN_ATTEN_DATA = (attenInDB & 0x80) >> 7;
-  nop();
-  nop();
-  nop();             // SPEC: DATA SETUP TIME > 100ns ( 3 cycles = 120ns)
-  PIN_ATTEN_CLK = 1; // CLK high <-- data on positive edge
-  nop();             // SPEC: DATA HOLD TIME > 50ns (2 cycles = 84ns)
-
-  PIN_ATTEN_CLK = 0; // CLK low
-  PIN_ATTEN_DATA = (attenInDB & 0x40) >> 6;
-  nop();
-  nop();
-  nop();             // SPEC: DATA SETUP TIME > 100ns ( 3 cycles = 120ns)
-  PIN_ATTEN_CLK = 1; // CLK high <-- data on positive edge
-  nop();             // SPEC: DATA HOLD TIME > 50ns (2 cycles = 84ns)
-
-  PIN_ATTEN_CLK = 0; // CLK low
-  PIN_ATTEN_DATA = (attenInDB & 0x20) >> 5;
-  nop();
-  nop();
-  nop();             // SPEC: DATA SETUP TIME > 100ns ( 3 cycles = 120ns)
-  PIN_ATTEN_CLK = 1; // CLK high <-- data on positive edge
-  nop();             // SPEC: DATA HOLD TIME > 50ns (2 cycles = 84ns)
-
-  PIN_ATTEN_CLK = 0; // CLK low
-  PIN_ATTEN_DATA = (attenInDB & 0x10) >> 4;
-  nop();
-  nop();
-  nop();             // SPEC: DATA SETUP TIME > 100ns ( 3 cycles = 120ns)
-  PIN_ATTEN_CLK = 1; // CLK high <-- data on positive edge
-  nop();             // SPEC: DATA HOLD TIME > 50ns (2 cycles = 84ns)
-
-  PIN_ATTEN_CLK = 0; // CLK low
-  PIN_ATTEN_DATA = (attenInDB & 0x08) >> 3;
-  nop();
-  nop();
-  nop();             // SPEC: DATA SETUP TIME > 100ns ( 3 cycles = 120ns)
-  PIN_ATTEN_CLK = 1; // CLK high <-- data on positive edge
-  nop();             // SPEC: DATA HOLD TIME > 50ns (2 cycles = 84ns)
-
-  PIN_ATTEN_CLK = 0; // CLK low
-  PIN_ATTEN_DATA = (attenInDB & 0x04) >> 2;
-  nop();
-  nop();
-  nop();             // SPEC: DATA SETUP TIME > 100ns ( 3 cycles = 120ns)
-  PIN_ATTEN_CLK = 1; // CLK high <-- data on positive edge
-  nop();             // SPEC: DATA HOLD TIME > 50ns (2 cycles = 84ns)
-
-  PIN_ATTEN_CLK = 0; // CLK low
-  PIN_ATTEN_DATA = (attenInDB & 0x02) >> 1;
-  nop();
-  nop();
-  nop();             // SPEC: DATA SETUP TIME > 100ns ( 3 cycles = 120ns)
-  PIN_ATTEN_CLK = 1; // CLK high <-- data on positive edge
-  nop();             // SPEC: DATA HOLD TIME > 50ns (2 cycles = 84ns)
-
-  PIN_ATTEN_CLK = 0; // CLK low
-  PIN_ATTEN_DATA = (attenInDB & 0x01);
-  nop();
-  nop();
-  nop();             // SPEC: DATA SETUP TIME > 100ns ( 3 cycles = 120ns)
-  PIN_ATTEN_CLK = 1; // CLK high <-- data on positive edge
-  nop();             // SPEC: DATA HOLD TIME > 50ns (3 cycles = 120ns)
-  nop();
-
-  // finish up ------
-  PIN_ATTEN_LOAD = 1; // SPEC: CLOCK TO LOAD HIGH > 50ns (2 cycles = 84ns)
-  PIN_ATTEN_DATA = 1; // DATA high
+// 100Hz interrupt handler -- allow up to ATTEN_SLEW_STEPS_PER_TICK 1dB steps
+// towards res.  ADC_Routine() makes them at OUTMON zero crossings, so the
+// steps are click-free (no zipper effect) without waiting in this ISR.
+void handle_atten_slew(void) {
+  if (previousRes == res) {
+    atten_zc_steps = 0; // arrived (or nothing to do)
+    return;
+  }
+  atten_zc_steps = ATTEN_SLEW_STEPS_PER_TICK;
+  if (!adc_seq_busy) {
+    // start watching OUTMON; its first sample is only the previous one
+    atten_zc_primed = false;
+    atten_zc_wait = 0;
+    ADC_SetPowerState(HAL_State_ON);
+    adc_seq_next();
+  }
 }
 
+// =============================================================
+// LM1971 serial timing.  Each delay below is the smallest number of nop()s
+// that meets the spec at the configured SYSCLK (__CONF_FOSC / __CONF_CLKDIV),
+// counting the pin writes between the two edges (SETB/CLR = 1 clock on the
+// 1T core).  At CLKDIV=4 (229ns per clock) no nop()s are needed at all.
+#define LM1971_T_LOAD_CLK_NS 200  // LOAD LOW to CLOCK HIGH
+#define LM1971_T_DATA_SETUP_NS 100 // DATA VALID to CLOCK HIGH
+#define LM1971_T_DATA_HOLD_NS 50  // CLOCK HIGH to DATA change
+#define LM1971_T_CLK_LOAD_NS 50   // CLOCK HIGH to LOAD HIGH
+
+// clocks needed to cover __NS__ nanoseconds (rounded up)
+#define ATTEN_CLOCKS(__NS__)                                                   \
+  (((__NS__) * (__SYSCLOCK / 1000UL) + 999999UL) / 1000000UL)
+// nop()s still needed when __WRITES__ pin writes already separate the edges
+#define ATTEN_NOPS(__NS__, __WRITES__)                                         \
+  ((ATTEN_CLOCKS(__NS__) > (__WRITES__)) ? (ATTEN_CLOCKS(__NS__) - (__WRITES__)) \
+                                         : 0)
+
+#if ATTEN_NOPS(LM1971_T_LOAD_CLK_NS, 1) > 4
+#error "SYSCLK too fast for ATTEN_DELAY(), add more nop()s"
+#endif
+
+// __N__ is a compile-time constant, so SDCC keeps exactly __N__ nop()s
+#define ATTEN_DELAY(__N__)                                                     \
+  do {                                                                         \
+    if ((__N__) > 0)                                                           \
+      nop();                                                                   \
+    if ((__N__) > 1)                                                           \
+      nop();                                                                   \
+    if ((__N__) > 2)                                                           \
+      nop();                                                                   \
+    if ((__N__) > 3)                                                           \
+      nop();                                                                   \
+  } while (0)
+
+// one DATA bit, clocked in on the CLK rising edge.  The previous CLK rising
+// edge is held through CLK LOW + DATA (2 writes) before DATA changes.
+#define ATTEN_SEND_BIT(__BIT__)                                                \
+  ATTEN_DELAY(ATTEN_NOPS(LM1971_T_DATA_HOLD_NS, 2));                           \
+  PIN_ATTEN_CLK = 0;                                                           \
+  PIN_ATTEN_DATA = (attenInDB >> (__BIT__)) & 0x01;                            \
+  ATTEN_DELAY(ATTEN_NOPS(LM1971_T_DATA_SETUP_NS, 1));                          \
+  PIN_ATTEN_CLK = 1
+
+// The whole LM1971 write.  Expanding all loops makes the entire cycle take
+// the minimal time to set the attenuation: this completely eliminates
+// popping, and lets us return from servicing ASAP to save power.
+#define ATTEN_WRITE()                                                          \
+  do {                                                                         \
+    PIN_ATTEN_CLK = 0;                                                         \
+    PIN_ATTEN_DATA = 0;                                                        \
+    PIN_ATTEN_LOAD = 0; /* SPEC: CLOCK must go down before LOAD goes down */   \
+    ATTEN_DELAY(ATTEN_NOPS(LM1971_T_LOAD_CLK_NS, 1));                          \
+    /* ADDRESS = 0x00 ---------------------- */                                \
+    /* DATA has been LOW since LOAD went down: no setup/hold delays */         \
+    PIN_ATTEN_CLK = 1; /* A7 */                                                \
+    PIN_ATTEN_CLK = 0;                                                         \
+    PIN_ATTEN_CLK = 1; /* A6 */                                                \
+    PIN_ATTEN_CLK = 0;                                                         \
+    PIN_ATTEN_CLK = 1; /* A5 */                                                \
+    PIN_ATTEN_CLK = 0;                                                         \
+    PIN_ATTEN_CLK = 1; /* A4 */                                                \
+    PIN_ATTEN_CLK = 0;                                                         \
+    PIN_ATTEN_CLK = 1; /* A3 */                                                \
+    PIN_ATTEN_CLK = 0;                                                         \
+    PIN_ATTEN_CLK = 1; /* A2 */                                                \
+    PIN_ATTEN_CLK = 0;                                                         \
+    PIN_ATTEN_CLK = 1; /* A1 */                                                \
+    PIN_ATTEN_CLK = 0;                                                         \
+    PIN_ATTEN_CLK = 1; /* A0 */                                                \
+    /* DATA (MSB first) ----------------- */                                   \
+    ATTEN_SEND_BIT(7);                                                         \
+    ATTEN_SEND_BIT(6);                                                         \
+    ATTEN_SEND_BIT(5);                                                         \
+    ATTEN_SEND_BIT(4);                                                         \
+    ATTEN_SEND_BIT(3);                                                         \
+    ATTEN_SEND_BIT(2);                                                         \
+    ATTEN_SEND_BIT(1);                                                         \
+    ATTEN_SEND_BIT(0);                                                         \
+    /* finish up ------ */                                                     \
+    ATTEN_DELAY(ATTEN_NOPS(LM1971_T_CLK_LOAD_NS, 1));                          \
+    PIN_ATTEN_LOAD = 1; /* SPEC: CLOCK TO LOAD HIGH */                         \
+    PIN_ATTEN_DATA = 1; /* DATA high */                                        \
+  } while (0)
+
+// 0 = 0dB attenuation, >=63 = MUTE
+void setAttenuation(uint8_t attenInDB) { ATTEN_WRITE(); }
+
+// the same, for atten_zc_sample() in ADC_Routine()'s register bank
+void atten_write_isr(uint8_t attenInDB) ISR_USING { ATTEN_WRITE(); }
+
 // +---------------------------------------------------------------+
 // | BATTERY MONITOR FUNCTIONS                                     |
 // +---------------------------------------------------------------+
 // Configure ADC0 (P1.0 - BATTMON) for battery voltage monitoring
 void init_battmon() {
   GPIO_P1_SetMode(GPIO_Pin_0, GPIO_Mode_Input_HIP); // Set ADC0(GPIO P1.0) HIP
-  ADC_SetClockPrescaler(0x01);  // ADC Clock = SYSCLK / 2 / (1+1) = SYSCLK / 4
+  ADC_SetClockPrescaler(ADC_PRESCALER); // ADC Clock = SYSCLK / 2 / (1+1) = SYSCLK / 4
   ADC_SetResultAlignmentLeft(); // Left alignment, high 8-bit in ADC_RES
   ADC_SetPowerState(HAL_State_ON); // Turn on ADC power
+  EXTI_ADC_SetIntState(HAL_State_ON); // ADC sequencer runs from the ADC interrupt
 }
 
 void handle_battmon(void) {
-  // READ ADC0 value --------
-  ADC_SetChannel(ADCCHANNEL_BATTMON); // Channel: ADC0 (P1.0 - BATTMON)
-  ADC_Start();
-  nop();
-  nop();
-
-  while (!ADC_SamplingFinished())
-    ; // WAIT...
-
-  ADC_ClearInterrupt();
-  battmon_res = ADC_RES; // latest battery monitor result
+  // latest ADC0 value (from the ADC sequencer) --------
+  battmon_res = adc_battmon_res; // latest battery monitor result
 
   // battery voltage = 0 - 12vdc, divider = 20Kohm/67Kohm = 0.3
   //   so, battery voltage 12v maps to (12 * 0.3)/5 * 255 => 184
@@ -704,15 +1180,15 @@ void init_leds(void) {
   // Set PCA2 (CCP2/P3.7) to PWM mode
   PCA_PCA2_SetWorkMode(PCA_WorkMode_PWM_NonInterrupt);
 
-  // Set to 8-bit PWM
-  PCA_PWM0_SetBitWidth(PCA_PWM_BitWidth_8);
-  PCA_PWM1_SetBitWidth(PCA_PWM_BitWidth_8);
-  PCA_PWM2_SetBitWidth(PCA_PWM_BitWidth_8);
+  // Set to 10-bit PWM (4x the steps of 8-bit at the dim end, see set_rgb())
+  PCA_PWM0_SetBitWidth(PCA_PWM_BitWidth_10);
+  PCA_PWM1_SetBitWidth(PCA_PWM_BitWidth_10);
+  PCA_PWM2_SetBitWidth(PCA_PWM_BitWidth_10);
 
   // Set initial duty cycle
-  PCA_PCA0_SetCompareValue(0);
-  PCA_PCA1_SetCompareValue(0);
-  PCA_PCA2_SetCompareValue(0); // Start off (active low)
+  PCA_PCA0_SetCompareValue10bit(0);
+  PCA_PCA1_SetCompareValue10bit(0);
+  PCA_PCA2_SetCompareValue10bit(0); // Start off (active low)
 
   // Route PCA outputs to P3.4/P3.5/P3.6/P3.7
   PCA_SetPort(PCA_AlterPort_P34_P35_P36_P37);
@@ -722,78 +1198,153 @@ void init_leds(void) {
 }
 
 // Set RGB LED colors
-// r, g, b: 0-255 (0 = off, 255 = full brightness for active-low LEDs)
+// r, g, b: perceptual levels 0-255 (0 = off, 255 = full brightness for
+// active-low LEDs), mapped through led_gamma_table[] to a 10-bit duty, so
+// equal steps in level look like equal steps in brightness.
 void set_rgb(uint8_t r, uint8_t g, uint8_t b) {
-  // LEDs are Active Low (0 = On, 255 = Off)
+  // LEDs are Active Low (0 = On, 1023 = Off)
   // PCA Logic: Output Low when Counter < Compare.
   // Active Low LED: Low = ON.
   // So Higher Compare Value = Longer Low Time = Brighter.
+  uint16_t duty;
 
   // BLUE LED on P3.5 (CCP0)
-  PCA_PCA0_ChangeCompareValue(b);
+  duty = led_gamma_table[b];
+  PCA_PCA0_ChangeCompareValue10bit(duty);
 
   // GREEN LED on P3.6 (CCP1)
-  PCA_PCA1_ChangeCompareValue(g);
+  duty = led_gamma_table[g];
+  PCA_PCA1_ChangeCompareValue10bit(duty);
 
   // RED LED on P3.7 (CCP2)
-  PCA_PCA2_ChangeCompareValue(r);
+  duty = led_gamma_table[r];
+  PCA_PCA2_ChangeCompareValue10bit(duty);
+
+#ifdef INCLUDE_POWER_DOWN
+  led_dark = ((r | g | b) == 0);
+#endif
 }
 
 // =============================================================
-// Display firmware version on RGB LEDs at power-up
+// LED SEQUENCES
+
+// Firmware version at power-up
 // RED flashes = major version
 // GREEN flashes = minor version
 // BLUE flashes = patch version
-void display_version_on_leds(void) {
-  uint8_t i;
-  uint16_t flash_on_time = (uint16_t)(400 * VERSION_DISPLAY_TIMING_SCALE);
-  uint16_t flash_off_time = (uint16_t)(400 * VERSION_DISPLAY_TIMING_SCALE);
-  uint16_t between_colors_time = (uint16_t)(200 * VERSION_DISPLAY_TIMING_SCALE);
-  uint16_t pause_time = (uint16_t)(1600 * VERSION_DISPLAY_TIMING_SCALE);
+__CODE const led_seq_step_t led_seq_version[] = {
+    {LED_SEQ_REPEAT, FW_MAJOR, 2, 0},
+    {LED_SEQ_VERSION_MS(400), LED_RED_CALIBRATION, 0, 0}, // RED (dimmed because green LED is very efficient)
+    {LED_SEQ_VERSION_MS(400), 0, 0, 0},
+    {LED_SEQ_VERSION_MS(200), 0, 0, 0}, // Short pause between colors
+    {LED_SEQ_REPEAT, FW_MINOR, 2, 0},
+    {LED_SEQ_VERSION_MS(400), 0, LED_GREEN_CALIBRATION, 0}, // GREEN (dimmed because green LED is very efficient)
+    {LED_SEQ_VERSION_MS(400), 0, 0, 0},
+    {LED_SEQ_VERSION_MS(200), 0, 0, 0}, // Short pause between colors
+    {LED_SEQ_REPEAT, FW_PATCH, 2, 0},
+    {LED_SEQ_VERSION_MS(400), 0, 0, LED_BLUE_CALIBRATION}, // BLUE
+    {LED_SEQ_VERSION_MS(400), 0, 0, 0},
+    {LED_SEQ_VERSION_MS(1600), 0, 0, 0}, // Pause
+    {LED_SEQ_END, 0, 0, 0},
+};
 
-  // Flash RED for major version
-  for (i = 0; i < FW_MAJOR; i++) {
-    set_rgb(LED_RED_CALIBRATION, 0,
-            0); // RED on (dimmed because green LED is very efficient)
-    SYS_Delay(flash_on_time);
-    set_rgb(0, 0, 0); // Off
-    SYS_Delay(flash_off_time);
+// RVC mode change: 1 flash for mode 0 (Default), 2 flashes for mode 1 (Traditional)
+#define LED_SEQ_RVC_MODE(flashes)                                              \
+  {                                                                            \
+    {LED_SEQ_MS(500), 0, 0, 0}, /* Initial pause */                            \
+    {LED_SEQ_REPEAT, (flashes), 2, 0},                                         \
+    {LED_SEQ_MS(200), LED_OVERRIDE_FLASH_RED, LED_OVERRIDE_FLASH_GREEN,        \
+     LED_OVERRIDE_FLASH_BLUE},                                                 \
+    {LED_SEQ_MS(200), 0, 0, 0},                                                \
+    {LED_SEQ_MS(500), 0, 0, 0}, /* Final pause */                              \
+    {LED_SEQ_END, 0, 0, 0},                                                    \
   }
+__CODE const led_seq_step_t led_seq_rvc_default[] = LED_SEQ_RVC_MODE(1);
+__CODE const led_seq_step_t led_seq_rvc_ma220[] = LED_SEQ_RVC_MODE(2);
+#ifdef INCLUDE_LOUDNESS_TRIM
+// Loudness trim toggled (at power-up): 3 flashes = on, 1 flash = off
+__CODE const led_seq_step_t led_seq_loudness_on[] = LED_SEQ_RVC_MODE(3);
+#define led_seq_loudness_off led_seq_rvc_default
+#endif
+
+// Pulsing RED (low battery): up and down in (perceptual) steps of 12, one
+// step per frame, to the brightness of solid RED
+#define LED_SEQ_RED(r) {1, (r), 0, 0}
+__CODE const led_seq_step_t led_seq_pulsing_red[] = {
+    LED_SEQ_RED(12),  LED_SEQ_RED(24),  LED_SEQ_RED(36),  LED_SEQ_RED(48),
+    LED_SEQ_RED(60),  LED_SEQ_RED(72),  LED_SEQ_RED(84),  LED_SEQ_RED(96),
+    LED_SEQ_RED(108), LED_SEQ_RED(120), LED_SEQ_RED(132), {2, 144, 0, 0},
+    LED_SEQ_RED(132), LED_SEQ_RED(120), LED_SEQ_RED(108), LED_SEQ_RED(96),
+    LED_SEQ_RED(84),  LED_SEQ_RED(72),  LED_SEQ_RED(60),  LED_SEQ_RED(48),
+    LED_SEQ_RED(36),  LED_SEQ_RED(24),  LED_SEQ_RED(12),  {2, 0, 0, 0},
+    {LED_SEQ_LOOP, 0, 0, 0},
+};
+
+// =============================================================
+// Start playing an LED sequence from its first step
+void led_seq_start(__CODE const led_seq_step_t *seq) {
+  led_seq = seq;
+  led_seq_pc = 0;
+  led_seq_frames = 0;
+  led_seq_repeat_left = 0;
+}
 
-  SYS_Delay(between_colors_time); // Short pause between colors
+// Show one frame of the current LED sequence.
+// Returns false (and shows nothing) once the sequence has ended.
+bool led_seq_tick(void) {
+  while (led_seq_frames == 0) {
+    if (led_seq == 0) {
+      return false;
+    }
 
-  // Flash GREEN for minor version
-  for (i = 0; i < FW_MINOR; i++) {
-    set_rgb(0, LED_GREEN_CALIBRATION,
-            0); // GREEN on (dimmed because green LED is very efficient)
-    SYS_Delay(flash_on_time);
-    set_rgb(0, 0, 0); // Off
-    SYS_Delay(flash_off_time);
-  }
+    // end of a LED_SEQ_REPEAT block: go round again?
+    if ((led_seq_repeat_left != 0) && (led_seq_pc == led_seq_repeat_end)) {
+      if (--led_seq_repeat_left != 0) {
+        led_seq_pc = led_seq_repeat_start;
+      }
+    }
+
+    __CODE const led_seq_step_t *step = &led_seq[led_seq_pc++];
+    switch (step->frames) {
+    case LED_SEQ_END:
+      led_seq = 0;
+      return false;
 
-  SYS_Delay(between_colors_time); // Short pause between colors
+    case LED_SEQ_LOOP:
+      led_seq_pc = 0;
+      break;
+
+    case LED_SEQ_REPEAT:
+      if (step->r == 0) {
+        led_seq_pc += step->g; // zero passes: skip the block
+      } else {
+        led_seq_repeat_left = step->r;
+        led_seq_repeat_start = led_seq_pc;
+        led_seq_repeat_end = led_seq_pc + step->g;
+      }
+      break;
 
-  // Flash BLUE for minor version
-  for (i = 0; i < FW_PATCH; i++) {
-    set_rgb(0, 0,
-            LED_BLUE_CALIBRATION); // BLUE on
-    SYS_Delay(flash_on_time);
-    set_rgb(0, 0, 0); // Off
-    SYS_Delay(flash_off_time);
+    default:
+      led_seq_frames = step->frames;
+      set_rgb(step->r, step->g, step->b);
+      break;
+    }
   }
 
-  SYS_Delay(pause_time); // Pause = one flash time (on + off)
+  led_seq_frames--;
+  return true;
 }
 
-void show_rvc_mode_on_led(rvc_mode_t rvc_mode) {
-  // Set up LED override state machine for RVC mode indication
-  led_override_active = 1;
-  led_override_state = 0;  // Start with initial pause
-  led_override_tick_counter = 0;
+// Play a sequence instead of the normal led_mode until it ends
+void led_override_start(__CODE const led_seq_step_t *seq) {
+  led_seq_start(seq);
+  led_override_active = true;
+}
 
-  // Flash count: 1 flash for mode 0 (Default), 2 flashes for mode 1 (Traditional)
-  led_override_flash_count = (rvc_mode == RVC_DEFAULT_MODE_WITH_MUTE) ? 1 : 2;
-  led_override_flash_current = 0;
+void show_rvc_mode_on_led(rvc_mode_t rvc_mode) {
+  // flash count: 1 flash for mode 0 (Default), 2 flashes for mode 1 (Traditional)
+  led_override_start((rvc_mode == RVC_DEFAULT_MODE_WITH_MUTE) ? led_seq_rvc_default
+                                                              : led_seq_rvc_ma220);
 
   // Turn off LED immediately to start the initial pause
   set_rgb(0, 0, 0);
@@ -814,72 +1365,12 @@ void show_rvc_mode_on_led(rvc_mode_t rvc_mode) {
 #endif
 }
 
-void handle_led_override(void) {
-  led_override_tick_counter++;
-
-  switch (led_override_state) {
-    case 0:  // Initial pause (500ms = 10 ticks @ 20Hz)
-      set_rgb(0, 0, 0);  // LED off
-      if (led_override_tick_counter >= 10) {
-        led_override_state = 1;  // Move to flash-on state
-        led_override_tick_counter = 0;
-        led_override_flash_current = 0;
-      }
-      break;
-
-    case 1:  // Flash ON (200ms = 4 ticks @ 20Hz)
-      set_rgb(LED_OVERRIDE_FLASH_RED, LED_OVERRIDE_FLASH_GREEN, LED_OVERRIDE_FLASH_BLUE);  // Flash color
-      if (led_override_tick_counter >= 4) {
-        led_override_state = 2;  // Move to flash-off state
-        led_override_tick_counter = 0;
-      }
-      break;
-
-    case 2:  // Flash OFF (200ms = 4 ticks @ 20Hz)
-      set_rgb(0, 0, 0);  // LED off
-      if (led_override_tick_counter >= 4) {
-        led_override_flash_current++;
-        if (led_override_flash_current < led_override_flash_count) {
-          // More flashes needed, return to flash-on
-          led_override_state = 1;
-          led_override_tick_counter = 0;
-        } else {
-          // All flashes complete, move to final pause
-          led_override_state = 3;
-          led_override_tick_counter = 0;
-        }
-      }
-      break;
-
-    case 3:  // Final pause (500ms = 10 ticks @ 20Hz)
-      set_rgb(0, 0, 0);  // LED off
-      if (led_override_tick_counter >= 10) {
-        // Pattern complete, deactivate override
-        led_override_active = 0;
-        led_override_state = 0;
-        led_override_tick_counter = 0;
-        // LED will automatically resume normal led_mode on next handle_leds() call
-      }
-      break;
-  }
-}
-
 void pulsing_red(void) {
-  // Pulsing RED
-  if (pulseDirectionUP) {
-    if (red < LED_RED_CALIBRATION) {
-      red += 6;
-    } else {
-      pulseDirectionUP = false;
-    }
-  } else {
-    if (red > 0) {
-      red -= 6;
-    } else {
-      pulseDirectionUP = true;
-    }
+  // Pulsing RED, picking up where it left off unless something else was played
+  if (led_seq != led_seq_pulsing_red) {
+    led_seq_start(led_seq_pulsing_red);
   }
-  set_rgb(red, 0, 0); // Pulsing RED
+  led_seq_tick();
 }
 
 // 20Hz LED update handler - sets PWM target values for hardware PCA
@@ -888,8 +1379,10 @@ void pulsing_red(void) {
 void handle_leds(void) {
   // Check if LED override is active (for temporary patterns like RVC mode indication)
   if (led_override_active) {
-    handle_led_override();
-    return;  // Skip normal LED mode processing
+    if (led_seq_tick()) {
+      return;  // Skip normal LED mode processing
+    }
+    led_override_active = false; // pattern complete, resume normal led_mode below
   }
 
   // LOW BATTERY OVERRIDE:
@@ -942,59 +1435,19 @@ void handle_leds(void) {
   case SOLID_WHITE_MODE:
     // Solid WHITE mode
     // set_rgb(LED_RED_CALIBRATION, LED_GREEN_CALIBRATION, LED_BLUE_CALIBRATION); // TODO: reduce these to lower power?
-    set_rgb(50, 20, 30);  // Dimmed white to reduce power consumption
+    set_rgb(122, 80, 96);  // Dimmed white to reduce power consumption
     break;
 
   case VU_METER_MODE:
-    // VU meter mode
-    // Fast Attack: Jump immediately to new higher peaks
-    // Slow Decay: Exponential decay (multiply by 0.9 each tick)
+    // VU meter mode: PPM or VU ballistics (VU_METER_BALLISTICS)
 
     { // Scope for local variables
-
-      window[window_index] = abs_out_res; // Store current signal value
-      window_index = (window_index + 1) % 4; // Circular buffer for 4 samples
-
-      // calculate MAX of the last 4 samples
-      uint16_t max_of_last_4 = 0;
-      for (uint8_t i = 0; i < 4; i++) {
-        if (window[i] > max_of_last_4) {
-          max_of_last_4 = window[i];
-        }
-      }
-
-      // uint16_t current_signal_fixed = (uint16_t)abs_out_res << 8;
-      uint16_t current_signal_fixed = (uint16_t)max_of_last_4 << 8;
 #ifdef DEBUG
-      UART1_TxHex(current_signal_fixed >> 8);
-      UART1_TxHex(current_signal_fixed & 0xFF);
+      UART1_TxHex(abs_out_res);
+      UART1_TxHex(vu_rms);
       UART1_TxChar(',');
-      UART1_TxHex(vu_display_val_fixed >> 8);
-      UART1_TxHex(vu_display_val_fixed & 0xFF);
-      UART1_TxChar(',');
-#endif
-      if (current_signal_fixed >= vu_display_val_fixed) {
-        vu_display_val_fixed = current_signal_fixed; // Fast attack
-#ifdef DEBUG
-        UART1_TxChar('+');
-#endif        
-      } else {
-        // Exponential decay: multiply by 0.9375
-        // Use 32-bit math to avoid overflow: (value * 15) / 16
-        uint32_t temp = (uint32_t)vu_display_val_fixed * 15;
-        vu_display_val_fixed = (uint16_t)(temp / 16);
-#ifdef DEBUG
-        UART1_TxChar('-');
-#endif
-
-        // Snap to zero if below threshold (1.0 in 8.8 fixed point)
-        if (vu_display_val_fixed < 256 * 1) {
-#ifdef DEBUG
-        UART1_TxChar('X');
 #endif
-          vu_display_val_fixed = 0;
-        }
-      }
+      vu_meter_ballistics();
 #ifdef DEBUG
       UART1_TxHex(vu_display_val_fixed >> 8);
       UART1_TxHex(vu_display_val_fixed & 0xFF);
@@ -1003,27 +1456,22 @@ void handle_leds(void) {
       uint8_t display_val = (vu_display_val_fixed + 0x80) >> 8; // rounded, not truncated
 
       // Ensure display_val doesn't exceed 127
-      if (display_val > 127)
-        display_val = 127;
-
-      // Lookup logarithmic brightness/loudness
-      uint8_t b = volume_log_table[display_val];
+      if (display_val > VU_METER_FULL_SCALE)
+        display_val = VU_METER_FULL_SCALE;
 
-      // Calculate smooth RGB values
-      uint8_t r, g, blue;
-      calculate_vu_color(b, &r, &g, &blue);
+      // Logarithmic loudness and the green -> yellow -> red ramp, folded
+      // into one table (tools/gen_vu_colors.py): no multiplies or divides
+      __CODE const vu_color_t *color = &vu_color_table[display_val];
 
 #ifdef DEBUG
-      UART1_TxHex(b);
-      UART1_TxChar(',');
-      UART1_TxHex(r);
+      UART1_TxHex(color->r);
       UART1_TxChar(',');
-      UART1_TxHex(g);
+      UART1_TxHex(color->g);
       UART1_TxString("\r\n");
 #endif
 
       // Set LED with smooth color transitions
-      set_rgb(r, g, blue);
+      set_rgb(color->r, color->g, 0);
     }
     break;
 
@@ -1044,13 +1492,15 @@ void handle_leds(void) {
 
 // ----------------------------------------------------------------
 void welcome_to_ladybug(void) {
-  display_version_on_leds();
+  led_override_start(led_seq_version); // played by handle_leds() once Timer0 runs
 }
 
 // +---------------------------------------------------------------+
 // | SWITCH CONTROL FUNCTIONS                                      |
 // +---------------------------------------------------------------+
 
+void prefs_mark_dirty(void); // forward declaration
+
 // Configure switch pins with pullups
 void init_switches(void) {
   // Switch 1 on P1.5 and Switch 2 on P1.6
@@ -1063,6 +1513,23 @@ void init_switches(void) {
   GPIO_SetPullUp(GPIO_Port_1, SWITCH_2_PIN, HAL_State_ON);
 }
 
+#ifdef INCLUDE_LOUDNESS_TRIM
+// =============================================================
+// SW2 held down at power-up, then released: loudness trim on/off
+void loudness_toggle(void) {
+  loudness_on = !loudness_on;
+  loudness_trim_db = 0; // back to the RVC's attenuation...
+  loudness_valid = false; // ...until a new estimate says otherwise
+  loudness_step_frames = 0;
+
+  led_override_start(loudness_on ? led_seq_loudness_on : led_seq_loudness_off);
+  set_rgb(0, 0, 0); // start the initial pause
+
+  prefs.loudness_trim_pref = loudness_on;
+  prefs_mark_dirty(); // written to EEPROM later, from the main loop
+}
+#endif
+
 // =============================================================
 // Switch down event handler
 // Called from timer interrupt when a debounced switch press is detected
@@ -1106,9 +1573,12 @@ void on_switch_up(uint8_t switch_number) {
     }
 
     // the LED changes immediately in handle_leds(), so no need to special flash LEDs here
+    led_override_active = false; // not even behind the power-up version flashes
 
+#ifdef INCLUDE_PREFERENCES
     prefs.vu_meter_mode_pref = led_mode & 0x3; // 2-bit LED mode preference
-    Pref_Write(&prefs); // write updated LED preference to EEPROM
+    prefs_mark_dirty(); // written to EEPROM later, from the main loop
+#endif
     break;
   case 2:
     // SW2: toggle normal RVC curve vs traditional MA-200 curve
@@ -1116,8 +1586,10 @@ void on_switch_up(uint8_t switch_number) {
 
     show_rvc_mode_on_led(rvc_mode); // flash LED to indicate new RVC mode
 
+#ifdef INCLUDE_PREFERENCES
     prefs.rvc_curve_pref = rvc_mode & 0x1; // 1-bit RVC curve preference
-    Pref_Write(&prefs); // write updated LED preference to EEPROM
+    prefs_mark_dirty(); // written to EEPROM later, from the main loop
+#endif
     break;
   default:
     // Unknown switch number
@@ -1149,7 +1621,14 @@ void handle_switches(void) {
       }
       // Detect rising edge (button press): 0 -> 1
       if (old_state == 0 && switch1_state == 1) {
-        on_switch_up(1);
+        if (switch_held_at_boot & 0x01) {
+          switch_held_at_boot &= ~0x01; // released after power-up, not a press
+#ifdef INCLUDE_LOUDNESS_TRIM
+          loudness_toggle(); // (SW1 = user's SW2, see on_switch_up())
+#endif
+        } else {
+          on_switch_up(1);
+        }
       }
     }
   } else {
@@ -1173,7 +1652,11 @@ void handle_switches(void) {
       }
       // Detect rising edge (button press): 0 -> 1
       if (old_state == 0 && switch2_state == 1) {
-        on_switch_up(2);
+        if (switch_held_at_boot & 0x02) {
+          switch_held_at_boot &= ~0x02; // released after power-up, ignore
+        } else {
+          on_switch_up(2);
+        }
       }
     }
   } else {
@@ -1182,6 +1665,182 @@ void handle_switches(void) {
   }
 }
 
+#ifdef INCLUDE_PREFERENCES
+// +---------------------------------------------------------------+
+// | PREFERENCES FUNCTIONS                                         |
+// +---------------------------------------------------------------+
+// Called (from the Timer0 ISR) after changing prefs
+void prefs_mark_dirty(void) {
+  prefs_dirty = true;
+  prefs_commit_due = false;
+  prefs_quiet_ticks = 0; // restart the quiet period
+}
+
+// =============================================================
+// 100Hz interrupt handler -- is it time to commit the prefs?
+void handle_prefs_quiet(void) {
+  if (prefs_dirty && !prefs_commit_due) {
+    if (++prefs_quiet_ticks >= PREFS_COMMIT_QUIET_TICKS) {
+      prefs_commit_due = true;
+    }
+  }
+}
+
+// =============================================================
+// Main loop: write dirty prefs to EEPROM once they have been quiet for
+// PREFS_COMMIT_QUIET_TICKS, or right away if `now` (interrupts stay enabled,
+// except for the snapshot).  Runs after every interrupt wake-up, so the flags
+// are read first (single bits, atomic) and EA is only touched when one is set.
+void handle_prefs_commit(bool now) {
+  bool due;
+  Preferences_t snapshot;
+
+  if (!prefs_commit_due && !(now && prefs_dirty)) {
+    return; // nothing due: leave EA alone
+  }
+  EXTI_Global_SetIntState(HAL_State_OFF);
+  due = prefs_commit_due || (now && prefs_dirty);
+  if (due) {
+    prefs_commit_due = false;
+    prefs_dirty = false; // a change from here on marks them dirty again
+    snapshot = prefs;
+  }
+  EXTI_Global_SetIntState(HAL_State_ON);
+
+  if (due) {
+    Pref_Write(&snapshot);
+  }
+}
+#endif
+
+#ifdef INCLUDE_POWER_DOWN
+// +---------------------------------------------------------------+
+// | POWER MANAGEMENT FUNCTIONS                                    |
+// +---------------------------------------------------------------+
+// true if handle_leds() would keep the LED as it is on every call: OFF, or a
+// static color.  The PCA stops in power-down, so power_down() only really
+// powers down with the LED OFF (led_dark); for a static color it stays in
+// IDLE and slows Timer0 down instead.
+bool led_is_static(void) {
+  if (led_override_active) {
+    return false; // RVC mode flashes
+  }
+  if ((battmon_res != 255) && (battmon_res < RED_WATERMARK)) {
+    return false; // pulsing RED
+  }
+  return led_mode != VU_METER_MODE;
+}
+
+// =============================================================
+// 100Hz interrupt handler -- count how long nothing has changed
+void handle_power_down_quiet(void) {
+  if (led_is_static() && (res == previousRes) && (res == power_down_res) &&
+      (switch1_state == 1) && (switch2_state == 1) &&
+      (switch1_debounce_counter == 0) && (switch2_debounce_counter == 0)) {
+    if (power_down_quiet_ticks < POWER_DOWN_QUIET_TICKS) {
+      power_down_quiet_ticks++;
+    }
+  } else {
+    power_down_quiet_ticks = 0;
+  }
+  power_down_res = res;
+}
+
+// Restarts Timer0 at hz, a whole period from now
+void power_down_timer0(uint16_t hz) {
+  TIM_Timer0_SetRunState(HAL_State_OFF);
+  TIM_Timer0_Config(HAL_State_OFF, TIM_TimerMode_16BitAuto, hz);
+  TIM_Timer0_SetRunState(HAL_State_ON);
+}
+
+// Sleeps for ms: in power-down (the wake-up timer counts 0.5ms: 32KHz / 16),
+// or with slow_tick in IDLE until Timer0, set to ms, fires once.
+// Returns false if a switch press is waiting for handle_switches().
+bool power_down_sleep(uint8_t ms) {
+  if (slow_tick) {
+    power_down_timer0(1000 / ms);
+    slow_tick_fired = false;
+    while (!slow_tick_fired) {
+      PCON |= 0x01; // IDLE: the PCA keeps the LED lit
+    }
+  } else {
+    RCC_SetPowerDownWakeupTimerCountdown(ms * 2 - 1);
+    RCC_SetPowerDownMode(HAL_State_ON); // sleep until the wake-up timer fires
+    nop();
+    nop();
+  }
+
+  return (P15 != 0) && (P16 != 0);
+}
+
+// =============================================================
+// Called from the main loop once things have been quiet for
+// POWER_DOWN_QUIET_TICKS.  Sleeps in power-down (LED OFF) or in IDLE on a
+// slowed Timer0 (static color), waking every POWER_DOWN_WAKE_MS to sample RVC
+// (and once a second the battery), and returns to the normal 100Hz Timer0
+// loop as soon as anything changes.
+void power_down(void) {
+#ifdef INCLUDE_PREFERENCES
+  handle_prefs_commit(true); // do not sleep on uncommitted prefs
+#endif
+
+  // the wake-up timer, or with the LED lit a slow Timer0, takes over from
+  // the 100Hz tick
+  slow_tick = !led_dark; // Timer0_Routine() only sets slow_tick_fired now
+  if (!slow_tick) {
+    EXTI_Timer0_SetIntState(HAL_State_OFF);
+  }
+  while (adc_seq_busy) {
+    PCON |= 0x01; // let a running ADC sequence finish
+  }
+
+  // the PCA does not run in power-down (the LED is OFF)
+  if (!slow_tick) {
+    PCA_SetCounterState(HAL_State_OFF);
+    RCC_SetPowerDownWakeupTimerState(HAL_State_ON);
+  }
+
+  // A switch press ends the loop: handle_switches() debounces it at 100Hz
+  bool quiet = true;
+  while (quiet &&
+         power_down_sleep(POWER_DOWN_WAKE_MS - POWER_DOWN_ADC_SETTLE_MS)) {
+    bool battmon = (++power_down_battmon_wakes >= POWER_DOWN_BATTMON_WAKES);
+    if (battmon) {
+      power_down_battmon_wakes = 0;
+    }
+
+    // the ADC gets as long from power-on to its first conversion as in the
+    // 100Hz loop, asleep as well (powered, it draws its current meanwhile)
+    ADC_SetPowerState(HAL_State_ON);
+    if (!power_down_sleep(POWER_DOWN_ADC_SETTLE_MS)) {
+      break;
+    }
+    adc_seq_start(battmon);
+    while (adc_seq_busy) {
+      PCON |= 0x01; // IDLE until ADC_Routine() is done (it powers the ADC off)
+    }
+
+    handle_RVC(false); // new res, if the knob moved
+    if (battmon) {
+      handle_battmon();
+    }
+    quiet = (res == previousRes) && led_is_static();
+  }
+
+  if (slow_tick) {
+    slow_tick = false;
+    power_down_timer0(TIMER_FREQUENCY_HZ);
+  } else {
+    RCC_SetPowerDownWakeupTimerState(HAL_State_OFF);
+    PCA_SetCounterState(HAL_State_ON);
+    handle_leds(); // restore the LED color
+  }
+
+  power_down_quiet_ticks = 0;
+  EXTI_Timer0_SetIntState(HAL_State_ON);
+}
+#endif
+
 // +---------------------------------------------------------------+
 // | UART INITIALIZATION AND DEBUG FUNCTIONS                       |
 // +---------------------------------------------------------------+
@@ -1206,49 +1865,168 @@ void init_uart(void) {
 // +---------------------------------------------------------------+
 // | 100Hz TIMER CONTROL FUNCTIONS                                 |
 // +---------------------------------------------------------------+
-// Timer0 interrupt service routine - runs 100 times per second
-INTERRUPT(Timer0_Routine, EXTI_VectTimer0) {
+// Tasks that are more than a line or two, wrapped for sched_tasks[]
+void task_adc_power(void) {
+  // Turn ON ADC power 10ms before we need it (no delay needed)
+  ADC_SetPowerState(HAL_State_ON);
+}
 
-#ifdef INCLUDE_TEST_POINT 
-  // PIN_TP1 = (timer_ticks & 0x01); // TEST POINT toggles @ 100Hz
-  PIN_TP1 = 1; // TEST POINT to HIGH (start of ISR)
+void task_adc_start(void) {
+  // Sample in the background; ADC_Routine() turns the ADC OFF when done.
+  // The battery rides along once a second, for handle_battmon().
+  adc_seq_start(timer_ticks == TIMER_FREQUENCY_HZ - 1);
+}
+
+void task_rvc(void) {
+  handle_RVC(false); // Update RVC attenuation
+#if defined(INCLUDE_LIMITER) || defined(INCLUDE_HOWL_DETECTOR)
+  vu_sampling_set(true); // the limiter/howl detector watch OUTMON in every mode
+#elif defined(INCLUDE_LOUDNESS_TRIM)
+  vu_sampling_set(led_mode == VU_METER_MODE || loudness_on);
+#else
+  vu_sampling_set(led_mode == VU_METER_MODE); // Timer2 only when needed
 #endif
+}
 
-  handle_switches(); // Run at 100Hz for proper switch debouncing
+void task_vu_meter(void) {
+  if (vu_sampling) {
+    // In VU meter mode, update the VU meter display (and in any mode,
+    // start the next peak/RMS period)
+    handle_VU_meter();
+  }
+}
 
-  // Pre-enable ADC one tick before sampling (gives 10ms settling time)
-  // RVC/VU sampling happens every 5 ticks (0, 5, 10, 15...)
-  // Battery sampling happens at tick 100
-  if ((timer_ticks % RVC_UPDATE_FREQUENCY_TICKS == (RVC_UPDATE_FREQUENCY_TICKS - 1)) ||
-      (timer_ticks == TIMER_FREQUENCY_HZ - 1)) {
-    // Turn ON ADC power 10ms before we need it (no delay needed)
-    ADC_SetPowerState(HAL_State_ON);
+#ifdef INCLUDE_AUTO_ATTEN
+void task_auto_atten(void) {
+  res = auto_atten_res(rvc_res); // handle_atten_slew() takes it from here
+}
+#endif
+
+// Timer0 tasks: include/sched_tasks.h lists each with its period and phase.
+// Timer0_Routine() calls them directly (no function pointers, so SDCC sees
+// the whole call tree and a call through a pointer never makes the ISR save
+// every register bank); sched_tasks[] is the same list as data, for
+// sched_stats[] readers and the sim.  Nothing else reads it, so a target
+// build without INCLUDE_SCHED_STATS leaves it out of the code space.
+typedef struct {
+  void (*run)(void);
+  uint8_t period; // ticks
+  uint8_t phase;  // 0 .. period - 1
+} sched_task_t;
+
+#define SCHED_FRAME RVC_UPDATE_FREQUENCY_TICKS
+#define SCHED_PHASE_RVC 0
+#define SCHED_PHASE_VU 1
+#define SCHED_PHASE_LEDS 2
+#define SCHED_PHASE_ADC_POWER (SCHED_FRAME - 2)
+#define SCHED_PHASE_ADC_START (SCHED_FRAME - 1)
+#define SCHED_PHASE_BATTMON 3 // of TIMER_FREQUENCY_HZ: after tick 99's sample
+
+#define SCHED_TASK(fn, period, phase) SCHED_ID_##fn,
+enum {
+#include "sched_tasks.h"
+  SCHED_TASKS
+};
+#undef SCHED_TASK
+
+#if defined(INCLUDE_SCHED_STATS) || !(defined(SDCC) || defined(__SDCC))
+#define SCHED_TASK(fn, period, phase) {fn, period, phase},
+__CODE const sched_task_t sched_tasks[SCHED_TASKS] = {
+#include "sched_tasks.h"
+};
+#undef SCHED_TASK
+__CODE const uint8_t sched_task_count = SCHED_TASKS; // for sched_stats[] readers
+#endif
+
+#if (TIMER_FREQUENCY_HZ % SCHED_FRAME) != 0
+#error "RVC_UPDATE_FREQUENCY_TICKS must be a divisor of TIMER_FREQUENCY_HZ"
+#endif
+#if (SCHED_PHASE_BATTMON % SCHED_FRAME) != SCHED_PHASE_ADC_POWER
+#error "handle_battmon() should share its tick with task_adc_power() only"
+#endif
+
+#ifdef INCLUDE_SCHED_STATS
+// Per-task statistics, in Timer0 counts (Timer0 runs at SYSCLK / 12)
+#define SCHED_TICK_COUNTS ((uint16_t)(__SYSCLOCK / 12 / TIMER_FREQUENCY_HZ))
+
+typedef struct {
+  uint32_t runs;
+  uint32_t total_cost; // Timer0 counts, all runs
+  uint16_t max_cost;   // Timer0 counts, worst run
+  uint16_t overruns;   // runs during which the next tick came due
+} sched_stats_t;
+
+__XDATA sched_stats_t sched_stats[SCHED_TASKS];
+
+MEMVAR(bool, sched_late);       // the next tick was already due when the task started
+MEMVAR(uint16_t, sched_start);  // TH0:TL0 when the task started
+
+// TH0:TL0 while Timer0 runs (re-read if TL0 carried into TH0 in between)
+static uint16_t sched_timer0_count(void) ISR_USING {
+  uint8_t hi, lo;
+  do {
+    hi = TH0;
+    lo = TL0;
+  } while (hi != TH0);
+  return ((uint16_t)hi << 8) | lo;
+}
+
+void sched_measure_begin(void) ISR_USING {
+  sched_late = TF0;
+  sched_start = sched_timer0_count();
+}
+
+void sched_measure_end(__XDATA sched_stats_t *stats) ISR_USING {
+  uint16_t cost = sched_timer0_count() - sched_start;
+  if (!sched_late && TF0) {
+    cost += SCHED_TICK_COUNTS; // the count wrapped through the reload value
+    stats->overruns++;
   }
+  stats->runs++;
+  stats->total_cost += cost;
+  if (cost > stats->max_cost) {
+    stats->max_cost = cost;
+  }
+}
 
-  if (timer_ticks % RVC_UPDATE_FREQUENCY_TICKS == 0) {
-    // Run at 20Hz (every 5 ticks = 50ms)
-    handle_RVC(false);   // Update RVC attenuation
-    if (led_mode == VU_METER_MODE) {
-      // If in VU meter mode, update the VU meter display
-      handle_VU_meter(); // Sample ADC for VU METER (with fast attack, slow decay)
-    }
-    handle_leds();       // Update LED for all modes (in VU METER mode, matches VU update rate, saves 80% CPU cycles)
+#define SCHED_TASK(fn, period, phase)                                          \
+  if ((period) == 1 || timer_ticks % (period) == (phase)) {                    \
+    sched_measure_begin();                                                     \
+    fn();                                                                      \
+    sched_measure_end(&sched_stats[SCHED_ID_##fn]);                            \
+  }
+#else
+#define SCHED_TASK(fn, period, phase)                                          \
+  if ((period) == 1 || timer_ticks % (period) == (phase)) {                    \
+    fn();                                                                      \
   }
+#endif
 
-  if (timer_ticks++ >= TIMER_FREQUENCY_HZ) {
-    timer_ticks = 0;
-    handle_battmon(); // Run at 1Hz - battery monitor only once per second
+// Timer0 interrupt service routine - runs 100 times per second
+INTERRUPT_USING(Timer0_Routine, EXTI_VectTimer0, ISR_BANK) {
+#ifdef INCLUDE_POWER_DOWN
+  if (slow_tick) {
+    slow_tick_fired = true; // power_down() has the tasks for now
+    return;
   }
+#endif
 
-  // Turn OFF ADC power after sampling is complete
-  if ((timer_ticks % RVC_UPDATE_FREQUENCY_TICKS == 1) || (timer_ticks == 1)) {
-    ADC_SetPowerState(HAL_State_OFF);
+#ifdef INCLUDE_TEST_POINT 
+  // PIN_TP1 = (timer_ticks & 0x01); // TEST POINT toggles @ 100Hz
+  PIN_TP1 = 1; // TEST POINT to HIGH (start of ISR)
+#endif
+
+#include "sched_tasks.h"
+
+  if (++timer_ticks >= TIMER_FREQUENCY_HZ) {
+    timer_ticks = 0;
   }
 
 #ifdef INCLUDE_TEST_POINT  
   PIN_TP1 = 0; // TEST POINT to LOW (end of ISR)
 #endif
 }
+#undef SCHED_TASK
 
 // =============================================================
 // | MAIN                                                      |
@@ -1307,6 +2085,9 @@ void main(void) {
   Pref_Read(&prefs); // read preferences from EEPROM
   led_mode = prefs.vu_meter_mode_pref; // 2-bit LED mode preference
   rvc_mode = prefs.rvc_curve_pref;     // 1-bit RVC curve preference
+#ifdef INCLUDE_LOUDNESS_TRIM
+  loudness_on = prefs.loudness_trim_pref; // 1-bit loudness trim preference
+#endif
 
   // If power-on mode is VU_METER_MODE, start at max (red) and let it fade naturally
   if (led_mode == VU_METER_MODE) {
@@ -1332,24 +2113,36 @@ void main(void) {
   init_RVC();      // do RVC first
   init_VU_meter(); // then VU meter
   init_battmon();  // then battery monitor (turns on ADC)
+#ifdef INCLUDE_I2C_QUEUE
+  i2c_init(); // transfers start once interrupts are on
+#endif
 
-  // Display firmware version on LEDs at power-up (BEFORE Timer0 starts)
-  // but ONLY if one of the switches is held down at power-up
-  if ((P15 == 0) || (P16 == 0)) {
-    display_version_on_leds();
+  // A switch held down at power-up starts out debounced as DOWN, and its
+  // release is ignored, so it does not change a mode
+  if (P15 == 0) {
+    switch1_state = 0;
+    switch_held_at_boot |= 0x01;
+  }
+  if (P16 == 0) {
+    switch2_state = 0;
+    switch_held_at_boot |= 0x02;
+  }
 
-    // wait until both switches are released
-    while ((P15 == 0) || (P16 == 0)) {
-      SYS_Delay(10);
-    }
+  // first RVC reading, sleeping in IDLE until the ADC sequence is done
+  EXTI_Global_SetIntState(HAL_State_ON);
+  adc_seq_start(false);
+  while (adc_seq_busy) {
+    PCON |= 0x01; // woken by the ADC interrupt
   }
 
-  // after running at -15dB for a second, now go to RVC volume
+  // now go straight from -15dB to RVC volume
   handle_RVC(true); // service once to force init volume as per RVC
 
-  welcome_to_ladybug(); // run fancy LED startup sequence
+  welcome_to_ladybug(); // start fancy LED startup sequence (does not block)
 
-  // Configure Timer0 for 100Hz interrupt
+  // Configure Timer0 for 100Hz interrupt; the first tick shows the first
+  // frame of the startup sequence
+  timer_ticks = SCHED_PHASE_LEDS;
   TIM_Timer0_Config(HAL_State_OFF, TIM_TimerMode_16BitAuto, TIMER_FREQUENCY_HZ); // 100Hz
   EXTI_Timer0_SetIntState(HAL_State_ON);
   EXTI_Global_SetIntState(HAL_State_ON);
@@ -1360,5 +2153,28 @@ void main(void) {
     // CPU stops but peripherals (Timer0, PCA/PWM) continue running
     // Timer0 interrupt will wake the CPU
     PCON |= 0x01; // Set IDL bit to enter IDLE mode
+
+#ifdef INCLUDE_PREFERENCES
+    handle_prefs_commit(false); // EEPROM writes happen here, never in the ISR
+#endif
+
+#ifdef INCLUDE_I2C_QUEUE
+    i2c_poll(); // I2C completion callbacks run here, never in the ISR
+#endif
+
+#ifdef INCLUDE_DISPLAY
+    if (!display_started) {
+      if (timer_ticks >= DISPLAY_START_TICK) {
+        display_started = true;
+        SSD1306_Init(); // queued: the frame goes out from the I2C interrupt
+      }
+    }
+#endif
+
+#ifdef INCLUDE_POWER_DOWN
+    if (power_down_quiet_ticks >= POWER_DOWN_QUIET_TICKS) {
+      power_down(); // until the RVC, a switch or the LED mode needs us
+    }
+#endif
   } // while (1)
 }
@@ -2,12 +2,15 @@
 
 #include "preferences.h"
 #include "fw_hal.h"
+#include "mem_classes.h"
 
 #ifdef INCLUDE_PREFERENCES
 
 // State
-static uint16_t s_next_write_offset = 0;
-static bool s_initialized = false;
+static MEMVAR(uint8_t, s_active_sector) = 0;          // sector being appended to (0..PREF_NUM_SECTORS-1)
+static MEMVAR(uint8_t, s_active_header) = PREF_HEADER_FIRST; // its sequence header
+static MEMVAR(uint16_t, s_next_write_offset) = PREF_SECTOR_SLOTS; // slot for the next entry
+static MEMVAR(bool, s_initialized) = false;
 
 // =========================================================
 // Helper to read a byte
@@ -31,6 +34,103 @@ static uint8_t ReadByte(uint16_t addr) {
   return data;
 }
 
+// =========================================================
+// Helper to write (program) a byte
+static bool WriteByte(uint16_t addr, uint8_t value) {
+  bool result = true;
+
+  IAP_SetEnabled(HAL_State_ON);
+
+  IAP_WriteData(value);
+  IAP_CmdWrite(addr);
+  if (IAP_IsCmdFailed()) {
+#ifdef DEBUG
+    // UART1_TxString("WriteByte: IAP WriteData Failed\r\n");
+#endif    
+    IAP_ClearCmdFailFlag();
+    result = false;
+  }
+
+  IAP_SetEnabled(HAL_State_OFF);
+  return result;
+}
+
+// =========================================================
+// Helper to erase a 512-byte sector
+static bool EraseSector(uint16_t addr) {
+  bool result = true;
+
+  IAP_SetEnabled(HAL_State_ON);
+
+  IAP_CmdErase(addr);
+  if (IAP_IsCmdFailed()) {
+#ifdef DEBUG
+    // UART1_TxString("EraseSector: IAP Erase Failed\r\n");
+#endif
+    IAP_ClearCmdFailFlag();
+    result = false;
+  }
+
+  // Cycle IAP after erase
+  IAP_SetEnabled(HAL_State_OFF);
+  return result;
+}
+
+// =========================================================
+// Binary search a log of entries in slots [lo, hi) of the sector at `base`.
+// Entries are only ever appended, and a sector is only ever erased as a
+// whole, so the written slots (valid_marker == 0) are always a prefix of the
+// log, followed by erased 0xFF slots: log2(slots) + 1 reads instead of
+// scanning backwards one byte at a time.
+// Returns the slot after the latest entry (lo if there is none), and the
+// latest entry in *latest (left unchanged if there is none).
+static uint16_t FindLogEnd(uint16_t base, uint16_t lo, uint16_t hi,
+                           Preferences_t *latest) {
+  Preferences_t temp;
+
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) >> 1;
+    temp.value = ReadByte(base + mid);
+#ifdef DEBUG
+    // UART1_TxHex(mid >> 8);
+    // UART1_TxHex(mid & 0xFF);
+    // UART1_TxChar(':');
+    // UART1_TxHex(temp.value);
+    // UART1_TxString("\r\n");
+#endif
+    if (temp.valid_marker == 0) {
+      *latest = temp; // the last written slot is the last one probed here
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// =========================================================
+// Make `sector` the active one, holding just `value`.
+// The sector that was active is not touched, so if power fails part way,
+// Pref_Init() still finds it (and its latest entry) at the next power-up.
+static bool StartSector(uint8_t sector, uint8_t header, uint8_t value) {
+  uint16_t addr = PREF_SECTOR_ADDR(sector);
+
+  if (!EraseSector(addr)) {
+    return false;
+  }
+  if (!WriteByte(addr + 1, value)) {
+    return false;
+  }
+  if (!WriteByte(addr, header)) { // the header commits the sector
+    return false;
+  }
+
+  s_active_sector = sector;
+  s_active_header = header;
+  s_next_write_offset = 2;
+  return true;
+}
+
 // =========================================================
 void Pref_Dump() {
 #ifdef DEBUG
@@ -41,7 +141,7 @@ void Pref_Dump() {
 #define NUM_DUMP_ROWS 8  
   for (uint8_t i = 0; i < NUM_DUMP_ROWS; i++) {
     for (uint8_t j = 0; j < 16; j++) {
-      uint16_t addr = PREF_START_ADDR + (i << 4) + j;
+      uint16_t addr = PREF_SECTOR_ADDR(s_active_sector) + (i << 4) + j;
       if (j == 0) {
         UART1_TxHex(addr >> 8);
         UART1_TxHex(addr & 0xFF);
@@ -61,70 +161,58 @@ void Pref_Dump() {
 
 // =========================================================
 void Pref_Init() {
-  IAP_SetEnabled(HAL_State_ON);
+  uint8_t headers[PREF_NUM_SECTORS];
+  uint8_t i;
+  Preferences_t legacy;
 
-  // Write default value to first slot
-  IAP_WriteData(PREF_DEFAULT_VALUE); // must have bit 7 = 0 (indicates valid entry)
-  IAP_CmdWrite(PREF_START_ADDR);
+  for (i = 0; i < PREF_NUM_SECTORS; i++) {
+    headers[i] = ReadByte(PREF_SECTOR_ADDR(i));
+  }
 
-  if (IAP_IsCmdFailed()) {
-    IAP_ClearCmdFailFlag();
+  // The active sector is the one whose successor does not carry the next
+  // sequence number (it is older, erased, or a rotation that never completed)
+  for (i = 0; i < PREF_NUM_SECTORS; i++) {
+    uint8_t next = headers[(i + 1) % PREF_NUM_SECTORS];
+    if (PREF_IS_HEADER(headers[i]) &&
+        !(PREF_IS_HEADER(next) && (next == PREF_NEXT_HEADER(headers[i])))) {
+      Preferences_t latest;
+      s_active_sector = i;
+      s_active_header = headers[i];
+      s_next_write_offset = FindLogEnd(PREF_SECTOR_ADDR(i), 1, PREF_SECTOR_SLOTS, &latest);
+      s_initialized = true;
+      return;
+    }
+  }
+
+  // No sector has a header yet: carry over the legacy single-sector log
+  // (if any), and write it, or the default value, to sector 0
+  legacy.value = PREF_DEFAULT_VALUE; // must have bit 7 = 0 (indicates valid entry)
+  FindLogEnd(PREF_LEGACY_ADDR, 0, PREF_SECTOR_SIZE, &legacy);
+
+  if (!StartSector(0, PREF_HEADER_FIRST, legacy.value)) {
 #ifdef DEBUG
     // UART1_TxString("IAP Write Failed during Pref_Init\r\n");
 #endif  
+    s_next_write_offset = 2; // try the next write after slot 1 anyway
   }
-
-  s_next_write_offset = 1; // Next write goes to slot 1
   s_initialized = true; 
-  IAP_SetEnabled(HAL_State_OFF);
 }
 
 // =========================================================
 void Pref_Read(Preferences_t *prefs) {
-  uint16_t i;
-  Preferences_t temp;
+  Preferences_t latest;
 
-  IAP_SetEnabled(HAL_State_ON);
-
-  // Scan backwards to find the latest valid entry (valid_marker == 0)
-  // We start from the last byte of the sector
-  #ifdef DEBUG
-    // UART1_TxString("SCANNING FOR PREFS...\r\n");
-  #endif
-  for (i = PREF_SECTOR_SIZE; i > 0; i--) {
-    uint16_t addr = PREF_START_ADDR + (i - 1);
-    temp.value = ReadByte(addr);
-#ifdef DEBUG
-    // UART1_TxHex(addr >> 8);
-    // UART1_TxHex(addr & 0xFF);
-    // UART1_TxChar(':');
-    // UART1_TxHex(temp.value);
-    // UART1_TxString(" vm:");
-    // UART1_TxHex(temp.valid_marker);
-    // UART1_TxString("\r\n");
-#endif
-    // Check if valid_marker bit is 0 (valid entry)
-    if (temp.valid_marker == 0) {
-      s_next_write_offset = i; // Next write goes after this one
-      s_initialized = true;
-      IAP_SetEnabled(HAL_State_OFF);
-      *prefs = temp;
-#ifdef DEBUG
-      // UART1_TxString("returning...\r\n");
-#endif
-      return;
-    }
+  if (!s_initialized) {
+    Pref_Init(); // finds s_next_write_offset
   }
 
-  // No valid entry found, sector is empty or invalid
-#ifdef DEBUG
-  // UART1_TxString("sector empty/invalid...\r\n");
-#endif
-  s_next_write_offset = 0;
-  s_initialized = true;
-  IAP_SetEnabled(HAL_State_OFF);
+  // the latest entry is the one before the next write
+  latest.value = ReadByte(PREF_SECTOR_ADDR(s_active_sector) + s_next_write_offset - 1);
+  if (latest.valid_marker != 0) {
+    latest.value = PREF_DEFAULT_VALUE; // no valid entry (EEPROM failure)
+  }
 
-  prefs->value = PREF_DEFAULT_VALUE;
+  *prefs = latest;
 }
 
 // =========================================================
@@ -132,7 +220,6 @@ bool Pref_Write(const Preferences_t *prefs) {
   Preferences_t new_prefs;
   Preferences_t current_prefs;
   bool result;
-  Preferences_t temp_prefs;
 
   // Copy and ensure valid_marker is 0
   new_prefs = *prefs;
@@ -140,11 +227,9 @@ bool Pref_Write(const Preferences_t *prefs) {
 
   // Initialize if needed (to find s_next_write_offset)
   if (!s_initialized) {
-    Pref_Read(&temp_prefs);
+    Pref_Init();
   }
 
-  IAP_SetEnabled(HAL_State_ON);
-
 #ifdef DEBUG
   // UART1_TxString("Pref_Write: next_offset=");
   // UART1_TxHex(s_next_write_offset);
@@ -154,12 +239,7 @@ bool Pref_Write(const Preferences_t *prefs) {
 #endif  
 
   // Check current value to avoid unnecessary writes
-  if (s_next_write_offset > 0) {
-    current_prefs.value = ReadByte(PREF_START_ADDR + s_next_write_offset - 1);
-    current_prefs.valid_marker = 0;  // Ensure it's treated as valid
-  } else {
-    current_prefs.value = PREF_DEFAULT_VALUE;
-  }
+  Pref_Read(&current_prefs);
 
   if (current_prefs.value == new_prefs.value) {
 #ifdef DEBUG
@@ -170,54 +250,24 @@ bool Pref_Write(const Preferences_t *prefs) {
   }
 
   // Check if sector is full
-  if (s_next_write_offset >= PREF_SECTOR_SIZE) {
+  if (s_next_write_offset >= PREF_SECTOR_SLOTS) {
 #ifdef DEBUG
-    // UART1_TxString("Pref_Write: sector full, erasing...\r\n");
+    // UART1_TxString("Pref_Write: sector full, rotating...\r\n");
 #endif
-    // *** ADD THIS: Cycle IAP after erase ***
-    IAP_SetEnabled(HAL_State_OFF);
-    IAP_SetEnabled(HAL_State_ON);
-
-    IAP_CmdErase(PREF_START_ADDR);
-    if (IAP_IsCmdFailed()) {
-      #ifdef DEBUG
-        // UART1_TxString("Pref_Write: IAP Erase Failed\r\n");
-      #endif
-      IAP_ClearCmdFailFlag();
-      result = false;
-      goto cleanup;
-    }
-
-    // *** ADD THIS: Cycle IAP after erase ***
-    IAP_SetEnabled(HAL_State_OFF);
-    IAP_SetEnabled(HAL_State_ON);
-
-    s_next_write_offset = 0;
+    // The value goes to the next sector, which becomes active
+    result = StartSector((s_active_sector + 1) % PREF_NUM_SECTORS,
+                         PREF_NEXT_HEADER(s_active_header), new_prefs.value);
+    goto cleanup;
   }
 
-  // Re-enable IAP before write (ReadByte disabled it)
-  IAP_SetEnabled(HAL_State_OFF);
-  IAP_SetEnabled(HAL_State_ON);
-
   // Write new value
-  IAP_WriteData(new_prefs.value);
-  IAP_CmdWrite(PREF_START_ADDR + s_next_write_offset);
-
-  if (IAP_IsCmdFailed()) {
-#ifdef DEBUG
-    // UART1_TxString("Pref_Write: IAP WriteData Failed\r\n");
-#endif    
-    IAP_ClearCmdFailFlag();
-    result = false;
-    goto cleanup;
+  result = WriteByte(PREF_SECTOR_ADDR(s_active_sector) + s_next_write_offset,
+                     new_prefs.value);
+  if (result) {
+    s_next_write_offset++;
   }
 
-  s_next_write_offset++;
-  result = true;
-
 cleanup:
-  IAP_SetEnabled(HAL_State_OFF);
-
   Pref_Dump(); // debug dump
 
   return result;
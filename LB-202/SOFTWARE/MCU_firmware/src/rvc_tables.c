@@ -0,0 +1,51 @@
+// +-----------------------------------------------+
+// | RVC ATTENUATION TABLES                        |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// GENERATED by tools/gen_rvc_tables.py -- DO NOT EDIT.
+
+#include "rvc_tables.h"
+
+__CODE const uint8_t rvc_atten_table[RVC_TABLE_MODES][256] = {
+    // RVC_DEFAULT_MODE_WITH_MUTE
+    {
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // RVC 0x00-0x0F
+         0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2, // RVC 0x10-0x1F
+         2,  2,  2,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  3,  3, // RVC 0x20-0x2F
+         3,  3,  4,  4,  4,  4,  4,  4,  4,  4,  5,  5,  5,  5,  5,  5, // RVC 0x30-0x3F
+         5,  5,  6,  6,  6,  6,  6,  6,  6,  7,  7,  7,  7,  7,  7,  7, // RVC 0x40-0x4F
+         8,  8,  8,  8,  8,  8,  8,  9,  9,  9,  9,  9,  9, 10, 10, 10, // RVC 0x50-0x5F
+        10, 10, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 13, 13, 14, 17, // RVC 0x60-0x6F
+        19, 21, 24, 27, 29, 32, 34, 37, 40, 43, 45, 64, 64, 64, 64, 64, // RVC 0x70-0x7F
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, // RVC 0x80-0x8F
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, // RVC 0x90-0x9F
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, // RVC 0xA0-0xAF
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, // RVC 0xB0-0xBF
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, // RVC 0xC0-0xCF
+        64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, // RVC 0xD0-0xDF
+        64,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // RVC 0xE0-0xEF
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // RVC 0xF0-0xFF
+    },
+    // RVC_TRADITIONAL_MA220_MODE
+    {
+         0,  0,  0,  0,  0,  0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1, // RVC 0x00-0x0F
+         1,  2,  2,  2,  2,  2,  2,  3,  3,  3,  3,  3,  3,  4,  4,  4, // RVC 0x10-0x1F
+         4,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  6,  6,  6,  6,  6, // RVC 0x20-0x2F
+         6,  6,  6,  7,  7,  7,  7,  7,  7,  7,  8,  8,  8,  8,  8,  8, // RVC 0x30-0x3F
+         8,  8,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9,  9, 10, 10, 10, // RVC 0x40-0x4F
+        10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 11, 11, 11, 11, // RVC 0x50-0x5F
+        11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, // RVC 0x60-0x6F
+        11, 11, 11, 11, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // RVC 0x70-0x7F
+        12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // RVC 0x80-0x8F
+        12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // RVC 0x90-0x9F
+        12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // RVC 0xA0-0xAF
+        12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // RVC 0xB0-0xBF
+        12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // RVC 0xC0-0xCF
+        12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, // RVC 0xD0-0xDF
+        12,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // RVC 0xE0-0xEF
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, // RVC 0xF0-0xFF
+    },
+};
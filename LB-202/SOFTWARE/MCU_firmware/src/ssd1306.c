@@ -14,6 +14,7 @@
 
 #include "ssd1306.h"
 #include "globals.h"
+#include "i2c_queue.h"
 
 #ifdef INCLUDE_DISPLAY
 
@@ -29,121 +30,61 @@ typedef struct {
   uint16_t CurrentY;
   uint8_t Inverted;
   uint8_t Initialized;
+  uint8_t Busy;  /* a frame is queued or on the bus */
+  uint8_t Dirty; /* SSD1306_UpdateScreen() was called meanwhile */
 } SSD1306_t;
 
 /* Private variable */
 static SSD1306_t SSD1306;
 
+/* Init sequence, sent as one command stream (control byte 0x00) */
+static __XDATA uint8_t SSD1306_InitCommands[] = {
+    0xAE,       /* display off */
+    0x00,       /* lower start column address 0 (00h~0Fh) */
+    0x10,       /* upper start column address 0 (10h~1Fh) */
+    0x81, 0x7F, /* contrast 0x7F */
+    0xA4,       /* output follows RAM content (0xA5: ignores it) */
+    0xA6,       /* normal display (0xA7: inverse) */
+    0x20, 0x00, /* horizontal addressing mode: next page after the last column */
+    0xB0,       /* page start address (page addressing mode only) */
+    0x22, 0x00, 0x03, /* pages 0 to 3 (32 lines) */
+    0xC8,       /* COM output scan from COM[N-1] to COM0 (0xC0: COM0 first) */
+    0x40,       /* display RAM start line 0 */
+    0xA1,       /* column 127 is mapped to SEG0 (0xA0: column 0) */
+    0xA8, 0x1F, /* MUX ratio 32 */
+    0xD3, 0x00, /* no vertical display offset */
+    0xDA, 0x02, /* sequential COM pins, no left/right remap */
+    0xD5, 0xF0, /* display clock divide ratio / oscillator frequency */
+    0xD9, 0x22, /* pre-charge period */
+    0xDB, 0x10, /* VCOMH deselect level 0.77 * Vcc (RESET) */
+    0x8D, 0x14, /* charge pump on during display on (0x10: off) */
+    0xAF,       /* display on */
+};
+
+/* Column 0-127, pages 0-3: the whole buffer, in horizontal addressing mode */
+static __XDATA uint8_t SSD1306_Window[] = {
+    0x21, 0, SSD1306_WIDTH - 1,     /* column address */
+    0x22, 0, SSD1306_HEIGHT / 8 - 1 /* page address */
+};
+
 void SSD1306_WriteCommand(uint8_t command) {
-  I2C_Write(SSD1306_I2C_ADDR, 0x00, &command, 1);
+  while (!i2c_write_byte(SSD1306_I2C_ADDR, 0x00, command, NULL)) {
+    i2c_wait();
+  }
 }
 
 void SSD1306_WriteData(uint8_t dat) {
-  I2C_Write(SSD1306_I2C_ADDR, 0x40, &dat, 1);
+  while (!i2c_write_byte(SSD1306_I2C_ADDR, 0x40, dat, NULL)) {
+    i2c_wait();
+  }
 }
 
 void SSD1306_Init(void) {
-  SYS_Delay(100);
-
   /* Init LCD */
-  SSD1306_WriteCommand(0xAE); // display off
-  /**
-   * Set the lower start column address of pointer by command 00h~0Fh.
-   * Set the upper start column address of pointer by command 10h~1Fh.
-   */
-  SSD1306_WriteCommand(0x00); //---set low column address
-  SSD1306_WriteCommand(0x10); //---set high column address
-
-  /** set contrast control register, 2 bytes, 0x00 - 0xFF */
-  SSD1306_WriteCommand(0x81);
-  SSD1306_WriteCommand(0x7F);
-  /** 0xA4,Output follows RAM content
-   *  0xA5,Output ignores RAM content */
-  SSD1306_WriteCommand(0xA4);
-  /** 0xA6, Normal display (RESET)
-   *  0xA7, Inverse display */
-  SSD1306_WriteCommand(0xA6);
-  /* 0x20,Set Memory Addressing Mode, 2 bytes,
-   *   0x00,Horizontal Addressing Mode (slide horizontally and goto next page)
-   *   0x01,Vertical Addressing Mode (slide vertically and goto next column)
-   *   0x02,Page Addressing Mode (RESET) (slide horizontally and remain in the
-   * same page) 0x03,Invalid
-   */
-  SSD1306_WriteCommand(0x20);
-  SSD1306_WriteCommand(0x00);
-  /**
-   * Set the page start address of the target display location by command B0h to
-   * B7h For Page Addressing Mode only
-   */
-  SSD1306_WriteCommand(0xB0);
-  /**
-   * Set Page Address, 3 bytes
-   * For Horizontal and Vertical Addressing Mode only
-   */
-  SSD1306_WriteCommand(0x22);
-  SSD1306_WriteCommand(0x00); // From Page 0
-  SSD1306_WriteCommand(0x03); // To Page 3 (for 32 lines)
-
-  /**
-   * COM Output Scan Direction
-   * 0xC0: normal mode (RESET) Scan from COM0 to COM[N –1]
-   * 0xC8: remapped mode. Scan from COM[N-1] to COM0 */
-  SSD1306_WriteCommand(0xC8); // Set COM Output Scan Direction
-  /**
-   * Set display RAM display start line register from 0-63 */
-  SSD1306_WriteCommand(0x40);
-  /**
-   * Segment Re-map
-   * 0xA0: column address 0 is mapped to SEG0 (RESET),
-   * 0xA1: column address 127 is mapped to SEG0 */
-  SSD1306_WriteCommand(0xA1);
-  /**
-   * Set MUX ratio to N+1 MUX
-   * N=A[5:0]: from 16MUX to 64MUX, RESET=111111b (i.e. 63d, 64MUX)
-   * A[5:0] from 0 to 14 are invalid entry.*/
-  SSD1306_WriteCommand(0xA8);
-  SSD1306_WriteCommand(0x1F);
-  /**
-   * Set Display Offset, Set vertical shift by COM from 0d~63d
-   * The value is reset to 00h after RESET */
-  SSD1306_WriteCommand(0xD3);
-  SSD1306_WriteCommand(0x00); // offset in vertical
-  /**
-   * Set COM Pins Hardware Configuration
-   * A[4]=0b, Sequential COM pin configuration
-   * A[4]=1b(RESET), Alternative COM pin configuration
-   * A[5]=0b(RESET), Disable COM Left/Right remap
-   * A[5]=1b, Enable COM Left/Right remap */
-  SSD1306_WriteCommand(0xDA);
-  SSD1306_WriteCommand(0x02); // A[4]=0, A[5]=0 (Sequential, No Remap)
-  /**
-   * Set Display Divide Ratio/Oscillator Frequency
-   * */
-  SSD1306_WriteCommand(0xD5);
-  SSD1306_WriteCommand(0xF0); // divide ratio
-  /**
-   * Set Pre-charge Period */
-  SSD1306_WriteCommand(0xD9);
-  SSD1306_WriteCommand(0x22);
-  /**
-   * Set V COMH Deselect Level
-   * 0x00: 0.65 * Vcc
-   * 0x10: 0.77 * Vcc (RESET)
-   * 0x11: 0.83 * Vcc
-   * */
-  SSD1306_WriteCommand(0xDB);
-  SSD1306_WriteCommand(0x10);
-
-  /** charge pump setting
-   * 0x10: Disable charge pump(RESET)
-   * 0x14: Enable charge pump during display on
-   */
-  SSD1306_WriteCommand(0x8D);
-  SSD1306_WriteCommand(0x14);
-
-  /** 0xAE, Display OFF (sleep mode),
-   *  0xAF, Display ON in normal mode */
-  SSD1306_WriteCommand(0xAF);
+  while (!i2c_write(SSD1306_I2C_ADDR, 0x00, SSD1306_InitCommands,
+                    sizeof(SSD1306_InitCommands), NULL)) {
+    i2c_wait();
+  }
 
   /* Clear screen */
   SSD1306_Fill(SSD1306_COLOR_BLACK);
@@ -159,21 +100,30 @@ void SSD1306_Init(void) {
   SSD1306.Initialized = 1;
 }
 
-void SSD1306_UpdateScreen(void) {
-  uint16_t i;
-
-  // Reset Column Address
-  SSD1306_WriteCommand(0x21);
-  SSD1306_WriteCommand(0);
-  SSD1306_WriteCommand(127);
+/* Main loop (i2c_poll()): a frame has gone out, or failed */
+static void SSD1306_FrameDone(uint8_t status) {
+  UNUSED(status);
+  SSD1306.Busy = 0;
+  if (SSD1306.Dirty) {
+    SSD1306_UpdateScreen();
+  }
+}
 
-  // Reset Page Address
-  SSD1306_WriteCommand(0x22);
-  SSD1306_WriteCommand(0);
-  SSD1306_WriteCommand(3);
+void SSD1306_UpdateScreen(void) {
+  if (SSD1306.Busy) {
+    SSD1306.Dirty = 1; /* sent again once this frame is done */
+    return;
+  }
+  SSD1306.Dirty = 0;
+  SSD1306.Busy = 1;
 
-  for (i = 0; i < sizeof(SSD1306_Buffer_all); i += 32) {
-    I2C_Write(SSD1306_I2C_ADDR, 0x40, &SSD1306_Buffer_all[i], 32);
+  while (!i2c_write(SSD1306_I2C_ADDR, 0x00, SSD1306_Window,
+                    sizeof(SSD1306_Window), NULL)) {
+    i2c_wait();
+  }
+  while (!i2c_write(SSD1306_I2C_ADDR, 0x40, SSD1306_Buffer_all,
+                    sizeof(SSD1306_Buffer_all), SSD1306_FrameDone)) {
+    i2c_wait();
   }
 }
 
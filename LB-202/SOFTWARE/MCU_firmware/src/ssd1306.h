@@ -60,13 +60,17 @@ void SSD1306_WriteData(uint8_t dat);
 
 /**
  * Initializes SSD1306 LCD
+ * @note   Queues the init sequence and a blank frame on the I2C queue
+ * (i2c_queue.h), and returns.  Call it at least 100ms after power-up.
  */
 void SSD1306_Init(void);
 
 /**
  * @brief  Updates buffer from internal RAM to LCD
  * @note   This function must be called each time you do some changes to LCD, to
- * update buffer from RAM to LCD
+ * update buffer from RAM to LCD.  It queues the frame and returns; the frame
+ * goes out in the background from the I2C interrupt, and a call while one is
+ * still going out sends the buffer again once it is done.
  */
 void SSD1306_UpdateScreen(void);
 
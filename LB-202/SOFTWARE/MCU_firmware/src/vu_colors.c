@@ -0,0 +1,29 @@
+// +-----------------------------------------------+
+// | VU METER COLOR TABLE                          |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// GENERATED by tools/gen_vu_colors.py -- DO NOT EDIT.
+
+#include "vu_colors.h"
+
+__CODE const vu_color_t vu_color_table[VU_COLOR_ENTRIES] = {
+    {  0,   0}, {  0,   8}, {  0,  13}, {  0,  25}, {  0,  33}, {  0,  40}, {  0,  45}, {  0,  50}, // VU   0-  7
+    {  0,  53}, {  0,  57}, {  0,  60}, {  0,  63}, {  0,  65}, {  0,  68}, {  0,  70}, {  0,  72}, // VU   8- 15
+    {  0,  74}, {  0,  76}, {  0,  77}, {  0,  79}, {  0,  80}, {  0,  81}, {  0,  83}, {  0,  84}, // VU  16- 23
+    {  0,  86}, {  0,  87}, {  0,  88}, {  0,  89}, {  0,  90}, {  0,  91}, {  0,  92}, {  0,  93}, // VU  24- 31
+    {  0,  94}, {  0,  95}, {  0,  96}, {  0,  97}, {  0,  97}, {  0,  98}, {  0,  99}, {  0, 100}, // VU  32- 39
+    {  0, 101}, {  0, 101}, {  7, 101}, { 11, 101}, { 15, 102}, { 23, 102}, { 27, 103}, { 31, 103}, // VU  40- 47
+    { 35, 103}, { 39, 103}, { 43, 104}, { 47, 104}, { 55, 105}, { 59, 105}, { 62, 105}, { 66, 105}, // VU  48- 55
+    { 70, 106}, { 74, 106}, { 78, 106}, { 82, 107}, { 82, 107}, { 86, 107}, { 90, 107}, { 94, 107}, // VU  56- 63
+    { 98, 108}, {102, 108}, {106, 108}, {110, 109}, {110, 109}, {114, 109}, {118, 109}, {122, 110}, // VU  64- 71
+    {167,   0}, {167,   0}, {169,   0}, {172,   0}, {175,   0}, {175,   0}, {178,   0}, {181,   0}, // VU  72- 79
+    {181,   0}, {184,   0}, {186,   0}, {186,   0}, {189,   0}, {192,   0}, {192,   0}, {195,   0}, // VU  80- 87
+    {198,   0}, {198,   0}, {201,   0}, {203,   0}, {203,   0}, {206,   0}, {206,   0}, {209,   0}, // VU  88- 95
+    {212,   0}, {212,   0}, {215,   0}, {215,   0}, {218,   0}, {218,   0}, {220,   0}, {220,   0}, // VU  96-103
+    {223,   0}, {223,   0}, {226,   0}, {229,   0}, {229,   0}, {232,   0}, {232,   0}, {235,   0}, // VU 104-111
+    {235,   0}, {237,   0}, {237,   0}, {240,   0}, {240,   0}, {240,   0}, {243,   0}, {243,   0}, // VU 112-119
+    {246,   0}, {246,   0}, {249,   0}, {249,   0}, {252,   0}, {252,   0}, {255,   0}, {255,   0}, // VU 120-127
+};
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""
+Generate the RGB LED gamma table.
+
+Writes include/led_gamma.h and src/led_gamma.c: one 256-entry code-space
+table that maps a perceptual LED level (what set_rgb() takes, 0-255) to a
+10-bit PCA compare value, so equal steps in level look like equal steps in
+brightness and the dim end of a fade or of the VU green ramp gets 4x the
+resolution of the old 8-bit linear PWM.
+
+Change LED_GAMMA HERE, re-run this script, and commit the regenerated files:
+
+    python3 tools/gen_led_gamma.py
+
+The LED_*_CALIBRATION levels in src/main.c and the VU colors in
+tools/gen_vu_colors.py are perceptual levels too; after changing the curve,
+pick them again with --level (prints the level whose duty is closest to a
+given 10-bit duty).
+
+The sim (make -C sim check, scenario led_gamma) checks the generated table
+against an independent C copy of the same formula.
+"""
+
+import os
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FW_DIR = os.path.abspath(os.path.join(HERE, ".."))
+
+LED_GAMMA = 2.2
+DUTY_MAX = 1023  # PCA_PWM_BitWidth_10
+
+
+def duty(level):
+    """Perceptual level (0-255) -> 10-bit compare value.  Every level above 0
+    lights the LED, so a fade never stalls on a run of zeros."""
+    if level == 0:
+        return 0
+    return max(1, int(DUTY_MAX * (level / 255.0) ** LED_GAMMA + 0.5))
+
+
+def level(d):
+    """The level whose duty is closest to `d` (lowest level on a tie)."""
+    return min(range(256), key=lambda p: abs(duty(p) - d))
+
+
+BANNER = """\
+// +-----------------------------------------------+
+// | RGB LED GAMMA TABLE                           |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// GENERATED by tools/gen_led_gamma.py -- DO NOT EDIT.
+"""
+
+
+def emit_header():
+    return BANNER + """
+#ifndef __LED_GAMMA_H__
+#define __LED_GAMMA_H__
+
+#include "fw_hal.h"
+#include <stdint.h>
+
+#define LED_GAMMA_DUTY_MAX %d // PCA_PWM_BitWidth_10
+
+/**
+ * @brief Perceptual LED level (0-255) -> 10-bit PCA compare value,
+ *        gamma %.1f.  0 = off, every other level is at least 1.
+ */
+extern __CODE const uint16_t led_gamma_table[256];
+
+#endif // __LED_GAMMA_H__
+""" % (DUTY_MAX, LED_GAMMA)
+
+
+def emit_source():
+    values = [duty(p) for p in range(256)]
+    assert values[0] == 0 and values[255] == DUTY_MAX
+    assert all(a <= b for a, b in zip(values, values[1:]))
+
+    out = [BANNER, '\n#include "led_gamma.h"\n\n']
+    out.append("__CODE const uint16_t led_gamma_table[256] = {\n")
+    for row in range(0, 256, 16):
+        cells = ", ".join("%4d" % x for x in values[row:row + 16])
+        out.append("    %s, // level 0x%02X-0x%02X\n" % (cells, row, row + 15))
+    out.append("};\n")
+    return "".join(out)
+
+
+def write(path, text):
+    with open(path, "w") as f:
+        f.write(text)
+    print("wrote", os.path.relpath(path, FW_DIR))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) == 3 and sys.argv[1] == "--level":
+        p = level(int(sys.argv[2], 0))
+        print("level %d (0x%02X) -> duty %d" % (p, p, duty(p)))
+        sys.exit(0)
+    write(os.path.join(FW_DIR, "include", "led_gamma.h"), emit_header())
+    write(os.path.join(FW_DIR, "src", "led_gamma.c"), emit_source())
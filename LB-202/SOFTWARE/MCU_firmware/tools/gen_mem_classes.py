@@ -0,0 +1,352 @@
+#!/usr/bin/env python3
+"""
+Plan the memory class of every firmware global.
+
+Writes include/mem_classes.h: for each global declared with
+MEMVAR(type, name) in src/, whether it lives in __BIT, __DATA (direct RAM, one
+MOV) or __XDATA (MOVX through DPTR, 3-4 times the code and cycles).  The plan
+is made from how often each variable is touched on the host sim:
+
+  1. every PROFILE_VARIANTS build of the sim (make -C sim) is rebuilt with
+     gcov, and replays PROFILE_HOURS of gig behavior (ladybug_sim replay)
+  2. each executed line of the preprocessed source (so macros such as
+     ADC_SEQ_NEXT() count where they expand) adds its execution count to every
+     global it names, and accesses from an ISR's call tree
+     (sim/isr_calls.py) are counted separately
+  3. what an ISR touches more than ISR_HOT_PER_SECOND is planned first, in
+     any build; then the shipped build (SHIPPED_VARIANT, globals.h as is),
+     from its own accesses per second, so that no feature flag it does not
+     have can push one of its other variables out of __DATA; then the
+     variables that only a feature flag compiles in, each ranked by the
+     largest rate over the variants that have it, share what is left
+
+Then, in each of the three groups, in order of accesses per byte:
+  - a bool whose address is never taken goes to __BIT
+  - a variable touched less than COLD_PER_SECOND goes to __XDATA
+  - the rest go to __DATA until DATA_BUDGET bytes are used, then __XDATA
+
+This script refuses to write a plan that puts a variable an ISR touches more
+than ISR_HOT_PER_SECOND in __XDATA, or that does not fit BIT_BUDGET.  Change
+the budgets HERE, re-run, and commit the regenerated header:
+
+    python3 tools/gen_mem_classes.py
+
+With the SDCC linker output of a shipped build (sim/s51/footprint.py keeps
+it under sim/build/s51/footprint_shipped/) it also reports where each
+variable is now, and checks that the stack still has STACK_MIN bytes of
+internal RAM:
+
+    python3 tools/gen_mem_classes.py --map lb202.map --mem lb202.mem
+"""
+
+import argparse
+import bisect
+import gzip
+import json
+import os
+import re
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FW_DIR = os.path.abspath(os.path.join(HERE, ".."))
+SIM_DIR = os.path.join(FW_DIR, "sim")
+PROFILE_DIR = os.path.join("build", "profile")  # under sim/
+OUT_H = os.path.join(FW_DIR, "include", "mem_classes.h")
+
+sys.path.insert(0, SIM_DIR)
+import isr_calls  # noqa: E402
+
+SRCS = ["main.c", "preferences.c", "i2c_queue.c"]
+PROFILE_VARIANTS = ["default", "power_down", "limiter", "howl", "loudness", "display"]
+SHIPPED_VARIANT = "default"  # sim/Makefile: globals.h as is
+PROFILE_HOURS = 1  # 6 LED mode changes in the gig replay: every mode once
+
+# Direct RAM is 0x00-0x7F: register banks 0 and ISR_BANK (16 bytes: every
+# ISR runs in bank 1), the bit-addressable 0x20-0x2F, and 96 bytes that
+# __DATA shares with SDCC's overlaid locals and parameters.  The stack starts
+# above the last of those and grows up into 0x80-0xFF; an ISR adds 7 bytes
+# to it (return address, ACC, B, DPL, DPH, PSW) plus 2 per call, and none
+# nests (all run at the same priority), so STACK_MIN covers the deepest
+# main() call chain with one ISR on top.  The overlay size is only known from
+# an SDCC .mem file, which has not been produced for this tree yet: until
+# --mem has checked one, keep 48 of the 96 bytes for it.  The shipped build
+# needs about 34 bytes and the howl detector 15 more that its ISR touches at
+# 4kHz and up, so with every flag on the coldest shipped bytes go to __XDATA.
+DIRECT_FREE = 96      # direct RAM bytes left by the banks and the bit area
+DATA_BUDGET = 48      # bytes of MEMVAR globals in __DATA
+BIT_BUDGET = 64       # MEMVAR bools in __BIT (8 of the 16 bit-addressable bytes)
+STACK_MIN = 64        # bytes the .mem file must still report for the stack
+COLD_PER_SECOND = 1.0
+ISR_HOT_PER_SECOND = 1000.0  # the 4kHz VU/ADC sampling, not Timer0 (100Hz)
+
+TYPE_BYTES = {
+    "bool": 1, "uint8_t": 1, "int8_t": 1, "uint16_t": 2, "int16_t": 2,
+    "uint32_t": 4, "int32_t": 4,
+    "rvc_mode_t": 2, "led_mode_t": 2,  # SDCC enums are int
+}
+
+
+# +---------------------------------------------------------------+
+# | SOURCE                                                        |
+# +---------------------------------------------------------------+
+def memvars():
+    """name -> (type, bytes, address taken), for every MEMVAR() global."""
+    found = {}
+    for src in SRCS:
+        with open(os.path.join(FW_DIR, "src", src)) as f:
+            text = f.read()
+        for t, name in re.findall(r"^(?:static\s+)?(?:volatile\s+)?MEMVAR\((\w+),\s*(\w+)\)", text, re.MULTILINE):
+            if t not in TYPE_BYTES:
+                raise SystemExit("gen_mem_classes: size of %s (%s) unknown, add it to TYPE_BYTES" % (t, name))
+            found[name] = (t, TYPE_BYTES[t], address_taken(text, name))
+    return found
+
+
+def address_taken(text, name):
+    """Is &name used anywhere (unary &, not a bitwise or logical AND)?"""
+    for m in re.finditer(r"&\s*%s\b" % name, text):
+        before = text[:m.start()].rstrip()
+        if not before or not re.search(r"[\w)\]&]$", before):
+            return True
+    return False
+
+
+# +---------------------------------------------------------------+
+# | PROFILE                                                       |
+# +---------------------------------------------------------------+
+def preprocessed_lines(i_path, src):
+    """(file, line) -> (identifiers on it after macro expansion, line of src
+    it was expanded at).  A header's lines (sched_tasks.h) are at its
+    #include."""
+    lines, cur_file, cur_line, site = {}, None, 0, 0
+    with open(i_path) as f:
+        for text in f:
+            m = re.match(r'# (\d+) "([^"]+)"', text)
+            if m:
+                cur_line, cur_file = int(m.group(1)), os.path.basename(m.group(2))
+                continue
+            if cur_file == src:
+                site = cur_line
+            tokens, _ = lines.setdefault((cur_file, cur_line), ([], site))
+            tokens.extend(re.findall(r"\b[A-Za-z_]\w*\b", text))
+            cur_line += 1
+    return lines
+
+
+def gcov_lines(obj_dir, src):
+    """((file, line) -> count, [(first line, function)] of src), from gcov on
+    one object, including the lines of the headers it expands."""
+    out = subprocess.run(
+        ["gcov", "--json-format", "--stdout", "-o", obj_dir, os.path.join(FW_DIR, "src", src)],
+        cwd=obj_dir, check=True, capture_output=True).stdout
+    if out[:2] == b"\x1f\x8b":
+        out = gzip.decompress(out)
+    counts, starts = {}, []
+    for f in json.loads(out)["files"]:
+        name = os.path.basename(f["file"])
+        for ln in f["lines"]:
+            counts[(name, ln["line_number"])] = ln["count"]
+        if name == src:
+            starts = sorted((fn["start_line"], fn["name"]) for fn in f["functions"])
+    return counts, starts
+
+
+def profile_variant(variant, names):
+    """(name -> (accesses/s, accesses/s from an ISR's call tree), names the
+    variant compiles in), one variant."""
+    obj_dir = os.path.join(SIM_DIR, PROFILE_DIR, variant, "fw")
+    for gcda in [os.path.join(obj_dir, s[:-2] + ".gcda") for s in SRCS]:
+        if os.path.exists(gcda):
+            os.remove(gcda)
+    subprocess.run(["make", "-s", "-C", SIM_DIR, "BUILD_DIR=" + PROFILE_DIR,
+                    "EXTRA_CFLAGS=-O0 --coverage -save-temps=obj -fcallgraph-info -DMEM_CLASSES_UNPLANNED",
+                    os.path.join(PROFILE_DIR, variant, "ladybug_sim")], check=True)
+    subprocess.run([os.path.join(SIM_DIR, PROFILE_DIR, variant, "ladybug_sim"), "replay", str(PROFILE_HOURS)],
+                   cwd=SIM_DIR, check=True, stdout=subprocess.DEVNULL)
+
+    calls = isr_calls.read_graph(obj_dir)
+    isrs = isr_calls.source_functions(r"^INTERRUPT(?:_USING)?\((\w+),") & set(calls)
+    in_isr = isr_calls.reachable(calls, isrs)
+
+    seconds = PROFILE_HOURS * 3600.0
+    rates, present = {}, set()
+    for src in SRCS:
+        tokens = preprocessed_lines(os.path.join(obj_dir, src[:-2] + ".i"), src)
+        for names_on_line, _ in tokens.values():
+            present.update(tok for tok in names_on_line if tok in names)
+        counts, starts = gcov_lines(obj_dir, src)
+        for key, count in counts.items():
+            if not count or key not in tokens:
+                continue
+            names_on_line, site = tokens[key]
+            i = bisect.bisect_right(starts, (site, "\uffff")) - 1
+            isr = i >= 0 and starts[i][1] in in_isr
+            for tok in names_on_line:
+                if tok in names:
+                    total, from_isr = rates.get(tok, (0.0, 0.0))
+                    rates[tok] = (total + count / seconds, from_isr + (count / seconds if isr else 0.0))
+    return rates, present
+
+
+# +---------------------------------------------------------------+
+# | SDCC LINKER OUTPUT                                            |
+# +---------------------------------------------------------------+
+AREA_CLASS = {"DSEG": "__DATA", "OSEG": "__DATA", "BSEG": "__BIT", "ISEG": "__IDATA",
+              "XSEG": "__XDATA", "XISEG": "__XDATA", "PSEG": "__XDATA"}
+
+
+def read_map(path):
+    """symbol (without the leading _) -> memory class, from an sdld .map."""
+    where, area = {}, None
+    with open(path) as f:
+        for line in f:
+            m = re.match(r"^(\w+)\s+[0-9A-Fa-f]{4,8}\s+[0-9A-Fa-f]{4,8}\s+=", line)
+            if m:
+                area = m.group(1)
+                continue
+            m = re.match(r"^\s+[0-9A-Fa-f]{4,8}\s+_(\w+)\s", line)
+            if m and area in AREA_CLASS:
+                where.setdefault(m.group(1), AREA_CLASS[area])
+    return where
+
+
+def read_mem(path):
+    """Internal RAM use and stack space, from an sdld .mem."""
+    grid, stack = "", None
+    with open(path) as f:
+        for line in f:
+            m = re.match(r"^0x[0-9a-fA-F]{2}:\|(.*)\|\s*$", line)
+            if m:
+                grid += m.group(1).replace("|", "")
+            m = re.search(r"with (\d+) bytes available", line)
+            if m:
+                stack = int(m.group(1))
+    return {
+        "data": sum(c.islower() for c in grid),
+        "bits": grid.count("B"),
+        "overlay": grid.count("Q"),
+        "stack": stack,
+    }
+
+
+# +---------------------------------------------------------------+
+# | PLAN                                                          |
+# +---------------------------------------------------------------+
+def plan(vars_, rates, shipped):
+    """ISR-hot variables first, then shipped ones, then the feature-only ones."""
+    placed, data_used, bits_used = {}, 0, 0
+
+    def rank(name):
+        total, from_isr = rates.get(name, (0.0, 0.0))
+        return (from_isr < ISR_HOT_PER_SECOND, name not in shipped, -total / vars_[name][1], name)
+
+    for name in sorted(vars_, key=rank):
+        t, size, addressed = vars_[name]
+        total, from_isr = rates.get(name, (0.0, 0.0))
+        if t == "bool" and not addressed and bits_used < BIT_BUDGET:
+            placed[name] = "__BIT"
+            bits_used += 1
+        elif total >= COLD_PER_SECOND and data_used + size <= DATA_BUDGET:
+            placed[name] = "__DATA"
+            data_used += size
+        else:
+            placed[name] = "__XDATA"
+            if from_isr >= ISR_HOT_PER_SECOND:
+                raise SystemExit("gen_mem_classes: %s (%.0f/s from an ISR) does not fit DATA_BUDGET %d"
+                                 % (name, from_isr, DATA_BUDGET))
+    if any(t == "bool" and placed[n] != "__BIT" for n, (t, _, a) in vars_.items() if not a):
+        raise SystemExit("gen_mem_classes: more bools than BIT_BUDGET %d" % BIT_BUDGET)
+    return placed, data_used, bits_used
+
+
+def read_plan(path=OUT_H):
+    """name -> memory class, from a generated mem_classes.h."""
+    with open(path) as f:
+        return dict(re.findall(r"^#define MEM_(\w+)\(type\) (__\w+)", f.read(), re.MULTILINE))
+
+
+def write_header(vars_, rates, shipped, placed, data_used, bits_used):
+    order = {"__BIT": 0, "__DATA": 1, "__XDATA": 2}
+    rows = sorted(vars_, key=lambda n: (n not in shipped, order[placed[n]], -rates.get(n, (0.0, 0.0))[0], n))
+    shipped_data = sum(vars_[n][1] for n in shipped if placed[n] == "__DATA")
+    out = [
+        "// Generated by tools/gen_mem_classes.py -- do not edit.",
+        "//",
+        "// Memory class of every MEMVAR(type, name) global, from accesses per",
+        "// second in %d h sim gig replays of %s." % (PROFILE_HOURS, ", ".join(PROFILE_VARIANTS)),
+        "// What an ISR touches more than %d/s is planned first, then the shipped" % ISR_HOT_PER_SECOND,
+        "// build (%s) from its own replay; the variables only a feature flag" % SHIPPED_VARIANT,
+        "// compiles in share what is left.",
+        "// __DATA: %d of %d bytes (%d shipped), __BIT: %d of %d bits." %
+        (data_used, DATA_BUDGET, shipped_data, bits_used, BIT_BUDGET),
+        "// The other %d of the %d direct RAM bytes are kept for SDCC's overlay." %
+        (DIRECT_FREE - DATA_BUDGET, DIRECT_FREE),
+        "",
+        "#ifndef MEM_CLASSES_H",
+        "#define MEM_CLASSES_H",
+        "",
+        "#ifdef MEM_CLASSES_UNPLANNED",
+        "// the profiling build: every global in the default class",
+        "#define MEMVAR(type, name) type name",
+        "#else",
+        "#define MEMVAR(type, name) MEM_##name(type) name",
+        "",
+    ]
+    section = None
+    for name in rows:
+        if section != (name in shipped):
+            section = name in shipped
+            out += [] if section else [""]
+            out.append("%-52s // accesses/s  (from ISRs)" %
+                       ("// shipped build" if section else "// feature flags only"))
+        cls = placed[name]
+        decl = "#define MEM_%s(type) %s" % (name, "__BIT" if cls == "__BIT" else cls + " type")
+        total, from_isr = rates.get(name, (0.0, 0.0))
+        out.append("%-52s // %10.1f  (%.1f)" % (decl, total, from_isr))
+    out += ["#endif", "", "#endif // MEM_CLASSES_H", ""]
+    with open(OUT_H, "w") as f:
+        f.write("\n".join(out))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--map", help="sdld .map of an SDCC build: report each variable's current class")
+    ap.add_argument("--mem", help="sdld .mem of the same build: check internal RAM and stack")
+    args = ap.parse_args()
+
+    vars_ = memvars()
+    profiles = {v: profile_variant(v, vars_) for v in PROFILE_VARIANTS}
+    shipped_rates, shipped = profiles[SHIPPED_VARIANT]
+    rates = {n: r for n, r in shipped_rates.items()}  # as shipped, whatever a variant does
+    for variant_rates, _ in profiles.values():
+        for name, (total, from_isr) in variant_rates.items():
+            if name not in shipped:
+                old = rates.get(name, (0.0, 0.0))
+                rates[name] = (max(old[0], total), max(old[1], from_isr))
+
+    placed, data_used, bits_used = plan(vars_, rates, shipped)
+    write_header(vars_, rates, shipped, placed, data_used, bits_used)
+
+    print("%-28s %-8s %6s %12s %12s %-8s" % ("variable", "type", "bytes", "accesses/s", "from ISRs", "class"))
+    now = read_map(args.map) if args.map else {}
+    for name in sorted(vars_, key=lambda n: -rates.get(n, (0.0, 0.0))[0]):
+        t, size, _ = vars_[name]
+        total, from_isr = rates.get(name, (0.0, 0.0))
+        moved = "  (now %s)" % now[name] if name in now and now[name] != placed[name] else ""
+        print("%-28s %-8s %6d %12.1f %12.1f %-8s%s" % (name, t, size, total, from_isr, placed[name], moved))
+    print("__DATA %d/%d bytes, __BIT %d/%d bits -> %s" %
+          (data_used, DATA_BUDGET, bits_used, BIT_BUDGET, os.path.relpath(OUT_H, FW_DIR)))
+
+    if args.mem:
+        mem = read_mem(args.mem)
+        print("internal RAM: %d bytes data, %d bit bytes, %d overlay, stack %s bytes" %
+              (mem["data"], mem["bits"], mem["overlay"], mem["stack"]))
+        if mem["stack"] is not None and mem["stack"] < STACK_MIN:
+            print("stack has less than STACK_MIN = %d bytes" % STACK_MIN)
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
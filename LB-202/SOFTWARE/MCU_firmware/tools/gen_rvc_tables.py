@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+Generate the RVC (Remote Volume Control) -> attenuation lookup tables.
+
+Writes include/rvc_tables.h and src/rvc_tables.c: one 256-entry code-space
+table per rvc_mode_t, indexed directly by the 8-bit ADC7 result, so
+handle_RVC() does a single MOVC instead of a software divide per update.
+
+The curves below are the integer formulas that used to run in handle_RVC()
+(and in graphics/plot_rvc_curves.py).  Change a curve HERE, re-run this
+script, and commit the regenerated files:
+
+    python3 tools/gen_rvc_tables.py
+
+The sim (make -C sim check, scenario rvc_tables) checks the generated tables
+exhaustively against an independent C copy of the same formulas.
+"""
+
+import os
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FW_DIR = os.path.abspath(os.path.join(HERE, ".."))
+
+NO_RVC_THRESHOLD = 0xE0  # above this, nothing is plugged in => 0dB
+MUTE_DB = 64
+
+# Traditional MA-220 curve, RVC (0-133, 0 = loudest) -> attenuation (dB).
+# Generated from the CSV of MA-220 measurements with minimized quantization
+# error.  It has no MUTE.
+#
+# RVC,attenuation_dB
+# 1,0
+# 0.875,-1.5010471526555516
+# 0.75,-4.4084218269296525
+# 0.625,-6.363435814235585
+# 0.5,-8.636989461747557
+# 0.375,-10.011288052965444
+# 0.25,-10.936623787957386
+# 0.125,-11.527373590991886
+# 0,-11.840504365156153
+ATTEN_LOOKUP = [
+    -12, -12, -12, -12, -12, -12, -12, -12, -12, -12,  # RVC 0-9
+    -12, -12, -12, -12, -12, -12, -12, -12, -11, -11,  # RVC 10-19
+    -11, -11, -11, -11, -11, -11, -11, -11, -11, -11,  # RVC 20-29
+    -11, -11, -11, -11, -11, -11, -11, -11, -11, -11,  # RVC 30-39
+    -11, -11, -10, -10, -10, -10, -10, -10, -10, -10,  # RVC 40-49
+    -10, -10, -10, -10, -10, -10, -10,  -9,  -9,  -9,  # RVC 50-59
+     -9,  -9,  -9,  -9,  -9,  -9,  -9,  -9,  -8,  -8,  # RVC 60-69
+     -8,  -8,  -8,  -8,  -8,  -8,  -7,  -7,  -7,  -7,  # RVC 70-79
+     -7,  -7,  -7,  -6,  -6,  -6,  -6,  -6,  -6,  -6,  # RVC 80-89
+     -6,  -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,  # RVC 90-99
+     -4,  -4,  -4,  -4,  -4,  -3,  -3,  -3,  -3,  -3,  # RVC 100-109
+     -3,  -2,  -2,  -2,  -2,  -2,  -2,  -1,  -1,  -1,  # RVC 110-119
+     -1,  -1,  -1,  -1,  -1,  -1,  -1,  -1,   0,   0,  # RVC 120-129
+      0,   0,   0,   0                                 # RVC 130-133
+]
+
+
+def default_with_mute(rvc):
+    """RVC_DEFAULT_MODE_WITH_MUTE: linearize the audio-taper pot, then a
+    two-slope curve to MUTE."""
+    if rvc > NO_RVC_THRESHOLD:
+        return 0
+
+    # RVCval range = {0, 133 or so (depends on tolerance of pot)}
+    top = (rvc << 8) - rvc  # (RVCval * 255)
+    bot = 255 - rvc
+    linear_pot_val = min(top // bot, 255)  # range: {0, 255}
+
+    A = 3 * 64  # turn pot 3/4 of the way
+    B = 14      #  to attenuate by 12dB @ knee of the curve
+    C = 48      # then drop to mute
+    D = 236     #  at the end of the pot travel (guard band)
+    E = 6       #  at the beginning of the pot travel (guard band)
+
+    if linear_pot_val < E:
+        return 0  # no attenuation
+    if linear_pot_val > D:
+        return MUTE_DB  # attenuation = MAX
+    if linear_pot_val <= A:
+        return ((linear_pot_val - E) * B) // A
+    return B + ((linear_pot_val - A) * (C - B)) // (D - A)
+
+
+def traditional_ma220(rvc):
+    """RVC_TRADITIONAL_MA220_MODE: measured MA-220 curve, no MUTE."""
+    if rvc > NO_RVC_THRESHOLD:
+        return 0
+
+    # Reverse RVCval so that 0 = loudest (0dB), matching the Default curve direction
+    rvc_reversed = 0 if rvc >= 133 else 133 - rvc
+    return -ATTEN_LOOKUP[min(rvc_reversed, 133)]
+
+
+# Order must match rvc_mode_t in src/main.c
+CURVES = [
+    ("RVC_DEFAULT_MODE_WITH_MUTE", default_with_mute),
+    ("RVC_TRADITIONAL_MA220_MODE", traditional_ma220),
+]
+
+BANNER = """\
+// +-----------------------------------------------+
+// | RVC ATTENUATION TABLES                        |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// GENERATED by tools/gen_rvc_tables.py -- DO NOT EDIT.
+"""
+
+
+def emit_header():
+    return BANNER + """
+#ifndef __RVC_TABLES_H__
+#define __RVC_TABLES_H__
+
+#include "fw_hal.h"
+#include <stdint.h>
+
+#define RVC_TABLE_MODES %d // one table per rvc_mode_t
+
+/**
+ * @brief RVC -> attenuation in dB (0 = 0dB, >= 64 = MUTE).
+ *
+ * Indexed by [rvc_mode][ADC7 result].  Values above 0x%02X (nothing plugged
+ * in) map to 0dB in every mode.
+ */
+extern __CODE const uint8_t rvc_atten_table[RVC_TABLE_MODES][256];
+
+#endif // __RVC_TABLES_H__
+""" % (len(CURVES), NO_RVC_THRESHOLD)
+
+
+def emit_source():
+    out = [BANNER, '\n#include "rvc_tables.h"\n\n']
+    out.append("__CODE const uint8_t rvc_atten_table[RVC_TABLE_MODES][256] = {\n")
+    for name, curve in CURVES:
+        values = [curve(v) for v in range(256)]
+        assert all(0 <= x <= MUTE_DB for x in values)
+        out.append("    // %s\n    {\n" % name)
+        for row in range(0, 256, 16):
+            cells = ", ".join("%2d" % x for x in values[row:row + 16])
+            out.append("        %s, // RVC 0x%02X-0x%02X\n" % (cells, row, row + 15))
+        out.append("    },\n")
+    out.append("};\n")
+    return "".join(out)
+
+
+def write(path, text):
+    with open(path, "w") as f:
+        f.write(text)
+    print("wrote", os.path.relpath(path, FW_DIR))
+
+
+if __name__ == "__main__":
+    write(os.path.join(FW_DIR, "include", "rvc_tables.h"), emit_header())
+    write(os.path.join(FW_DIR, "src", "rvc_tables.c"), emit_source())
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""
+Generate the VU meter color table.
+
+Writes include/vu_colors.h and src/vu_colors.c: one code-space entry per VU
+display value (0-127) with the LED color to show, so handle_leds() does a
+single lookup instead of the log table, two 16-bit multiplies and a divide by
+191 or 31 on every 50ms update.
+
+The log curve and the green -> yellow -> red ramp below are what used to run
+in handle_leds() and calculate_vu_color().  The colors are perceptual levels
+for set_rgb() (see tools/gen_led_gamma.py).  Change them HERE, re-run this
+script, and commit the regenerated files:
+
+    python3 tools/gen_vu_colors.py
+
+The generated code-space tables together must fit CODE_TABLE_BUDGET of the
+8KB flash; this script refuses to write a table that does not.  The sim
+(make -C sim check, scenario vu_colors) checks the table against an
+independent C copy of the old code, entry by entry.
+"""
+
+import os
+
+import gen_led_gamma
+import gen_rvc_tables
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+FW_DIR = os.path.abspath(os.path.join(HERE, ".."))
+
+FLASH_BYTES = 8192  # STC8G1K08
+CODE_TABLE_BUDGET = FLASH_BYTES // 4  # all generated tables together
+
+VU_FULL_SCALE = 127  # VU_METER_FULL_SCALE in src/main.c
+
+# Logarithmic Volume Table (0-127 input -> 0-255 brightness/loudness)
+# Maps linear signal amplitude to perceived loudness (approx 40dB range)
+# Method: dB = 20 * log10(x/127). Map -40dB..0dB to 0..255.
+VOLUME_LOG_TABLE = [
+    0,   16,   25,  48,  64,  76,  86,  95,  102, 108, 114, 120, 124, 129, 133,
+    137, 140, 144, 147, 150, 153, 155, 158, 160, 163, 165, 167, 169, 171, 173,
+    175, 177, 179, 180, 182, 184, 185, 187, 188, 190, 191, 192, 194, 195, 196,
+    198, 199, 200, 201, 202, 203, 204, 206, 207, 208, 209, 210, 211, 212, 213,
+    213, 214, 215, 216, 217, 218, 219, 220, 220, 221, 222, 223, 224, 224, 225,
+    226, 227, 227, 228, 229, 229, 230, 231, 231, 232, 233, 233, 234, 235, 235,
+    236, 237, 237, 238, 238, 239, 240, 240, 241, 241, 242, 242, 243, 243, 244,
+    244, 245, 246, 246, 247, 247, 248, 248, 249, 249, 250, 250, 250, 251, 251,
+    252, 252, 253, 253, 254, 254, 255, 255,
+]
+
+
+def vu_color(b):
+    """Brightness b (0-255) -> (r, g, blue) levels.
+    Green zone (b=0-191): pure green, increasing brightness
+    Yellow zone (b=192-223): transition from green to yellow
+    Red zone (b=224-255): red only, increasing brightness
+    The levels go through the gamma table, so the ramps are even in
+    brightness (duty 0-133/1023 green, up to 202+161 yellow, 403-1023 red)."""
+    if b < 192:
+        return (0, (b * 101) // 191, 0)          # (0,0,0) -> (0,101,0)
+    if b < 224:
+        t = b - 192
+        return ((t * 122) // 31, 101 + (t * 9) // 31, 0)  # -> (122,110,0)
+    t = b - 224
+    return (167 + (t * 88) // 31, 0, 0)          # (167,0,0) -> (255,0,0)
+
+
+BANNER = """\
+// +-----------------------------------------------+
+// | VU METER COLOR TABLE                          |
+// |                                               |
+// | Copyright (c) 2026 Michael Pogue              |
+// | License: GPL V3                               |
+// +-----------------------------------------------+
+//
+// GENERATED by tools/gen_vu_colors.py -- DO NOT EDIT.
+"""
+
+
+def emit_header():
+    return BANNER + """
+#ifndef __VU_COLORS_H__
+#define __VU_COLORS_H__
+
+#include "fw_hal.h"
+#include <stdint.h>
+
+#define VU_COLOR_ENTRIES %d // VU display value 0..VU_METER_FULL_SCALE
+
+typedef struct {
+  uint8_t r, g; // set_rgb() levels; the VU meter never uses blue
+} vu_color_t;
+
+/**
+ * @brief VU display value (0-%d, linear amplitude) -> LED color: the log
+ *        loudness curve, then green -> yellow -> red.
+ */
+extern __CODE const vu_color_t vu_color_table[VU_COLOR_ENTRIES];
+
+#endif // __VU_COLORS_H__
+""" % (VU_FULL_SCALE + 1, VU_FULL_SCALE)
+
+
+def emit_source(colors):
+    out = [BANNER, '\n#include "vu_colors.h"\n\n']
+    out.append("__CODE const vu_color_t vu_color_table[VU_COLOR_ENTRIES] = {\n")
+    for row in range(0, len(colors), 8):
+        cells = ", ".join("{%3d, %3d}" % c for c in colors[row:row + 8])
+        out.append("    %s, // VU %3d-%3d\n" % (cells, row, row + 7))
+    out.append("};\n")
+    return "".join(out)
+
+
+def table_bytes():
+    """Code space used by every generated table, this one included."""
+    return {
+        "rvc_atten_table": len(gen_rvc_tables.CURVES) * 256,
+        "led_gamma_table": 256 * 2,
+        "vu_color_table": (VU_FULL_SCALE + 1) * 2,
+    }
+
+
+def write(path, text):
+    with open(path, "w") as f:
+        f.write(text)
+    print("wrote", os.path.relpath(path, FW_DIR))
+
+
+if __name__ == "__main__":
+    assert len(VOLUME_LOG_TABLE) == VU_FULL_SCALE + 1
+    colors = []
+    for b in VOLUME_LOG_TABLE:
+        r, g, blue = vu_color(b)
+        assert blue == 0 and 0 <= r <= 255 and 0 <= g <= 255
+        colors.append((r, g))
+    assert gen_led_gamma.duty(255) == gen_led_gamma.DUTY_MAX
+
+    sizes = table_bytes()
+    total = sum(sizes.values())
+    for name, size in sizes.items():
+        print("%-16s %4d bytes" % (name, size))
+    print("%-16s %4d bytes of %d budget (%d-byte flash)"
+          % ("total", total, CODE_TABLE_BUDGET, FLASH_BYTES))
+    if total > CODE_TABLE_BUDGET:
+        raise SystemExit("code-space tables over budget")
+
+    write(os.path.join(FW_DIR, "include", "vu_colors.h"), emit_header())
+    write(os.path.join(FW_DIR, "src", "vu_colors.c"), emit_source(colors))